@@ -0,0 +1,416 @@
+/*
+* Author: LowBoyTeam (https://github.com/LowBoyTeam)
+* License: Code Project Open License
+* Disclaimer: The software is provided "as-is". No claim of suitability, guarantee, or any warranty whatsoever is provided.
+* Copyright (c) 2016-2017.
+*/
+
+#ifndef _ASYNCFIND_HELPER_HPP_INCLUDED_
+#define _ASYNCFIND_HELPER_HPP_INCLUDED_
+
+#if !defined(__cpp_impl_coroutine)
+#error asyncfind_helper.hpp needs C++20 coroutines (/std:c++20 or -std=c++20)
+#endif
+
+#include <Windows.h>
+#include <stdint.h>
+#include <atomic>
+#include <condition_variable>
+#include <coroutine>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <stop_token>
+#include <string>
+#include <vector>
+
+////////////////////////////////////////////////////////
+// Asynchronous directory listing
+//
+//  finder_t lists one directory without blocking the caller. co_await next()
+//  gives the next batch of entries. The FindFirstFile/FindNextFile calls run
+//  on the Win32 thread pool, and the waiting coroutine is resumed through
+//  the executor it was given. One thread running a loop_t can therefore
+//  drive thousands of listings at once.
+//
+//  Reads are pulled, not pushed. A finder reads at most one batch ahead of
+//  its consumer, so it holds two batches at most however slow the consumer
+//  is. A batch stays valid until the next call to next(). Only one next()
+//  may be pending per finder.
+//
+//  When the stop token is triggered, the read in flight ends at the next
+//  entry, next() returns an empty batch and error() is
+//  ERROR_OPERATION_ABORTED. A finder may be destroyed at any time when
+//  no next() is pending; a read still in flight finishes on its own.
+//
+//  "." and ".." are skipped. The listing is not recursive.
+//
+//  Usage:
+//    // task_t is any coroutine type; path is copied into its frame
+//    task_t list(std::wstring path, asyncfind_helper::executor_t ex, std::stop_token stop)
+//    {
+//        asyncfind_helper::finder_t dir(path.c_str(), ex, stop);
+//        for (;;) {
+//            std::span<const asyncfind_helper::entry_t> batch = co_await dir.next();
+//            if (batch.empty())
+//                break;
+//            for (const auto& e : batch)
+//                add(e.name, e.size);
+//        }
+//        if (dir.error() != 0)
+//            report(dir.error());
+//    }
+//
+//    asyncfind_helper::loop_t loop;
+//    for (auto& d : dirs)
+//        list(d, asyncfind_helper::executor_t::from(loop), stop);
+//    loop.run();        // until loop.stop()
+
+namespace asyncfind_helper
+{
+	struct entry_t
+	{
+		std::wstring name;
+		DWORD attributes;
+		uint64_t size;
+		FILETIME write_time;
+
+		bool is_directory() const { return (attributes & FILE_ATTRIBUTE_DIRECTORY) != 0; }
+	};
+
+	// Where a finder resumes its waiting coroutine. The default executor resumes
+	// it directly on the pool thread that finished the read.
+	class executor_t
+	{
+	public:
+		executor_t() : m_context(NULL), m_post(NULL) {}
+
+		// Wraps any object with a post(std::coroutine_handle<>) member. It must
+		// outlive every finder that uses it.
+		template <class E>
+		static executor_t from(E& e)
+		{
+			executor_t ex;
+			ex.m_context = &e;
+			ex.m_post = [](void* context, std::coroutine_handle<> h) { static_cast<E*>(context)->post(h); };
+			return ex;
+		}
+
+		void resume(std::coroutine_handle<> h) const
+		{
+			if (m_post != NULL)
+				m_post(m_context, h);
+			else
+				h.resume();
+		}
+
+	private:
+		void* m_context;
+		void (*m_post)(void*, std::coroutine_handle<>);
+	};
+
+	// Single-thread run loop: resumes posted coroutines on the thread calling run()
+	class loop_t
+	{
+	public:
+		loop_t() : m_stop(false) {}
+
+		void post(std::coroutine_handle<> h)
+		{
+			std::lock_guard<std::mutex> guard(m_lock);
+			m_queue.push_back(h);
+			m_ready.notify_one();
+		}
+
+		// Resumes posted coroutines until stop() has been called and the queue
+		// is empty; anything posted while it drains is still resumed. Coroutines
+		// posted after it returns wait for the next run(), which again returns
+		// as soon as the queue is empty.
+		void run()
+		{
+			std::vector<std::coroutine_handle<> > batch;
+			for (;;) {
+				{
+					std::unique_lock<std::mutex> lock(m_lock);
+					m_ready.wait(lock, [this] { return !m_queue.empty() || m_stop; });
+					if (m_queue.empty())
+						break;
+					batch.swap(m_queue);
+				}
+				for (size_t i = 0; i < batch.size(); ++i)
+					batch[i].resume();
+				batch.clear();
+			}
+		}
+
+		// Makes run() return once it has resumed everything posted so far
+		void stop()
+		{
+			std::lock_guard<std::mutex> guard(m_lock);
+			m_stop = true;
+			m_ready.notify_one();
+		}
+
+	private:
+		loop_t(const loop_t&);
+		loop_t& operator= (const loop_t&);
+
+		std::mutex m_lock;
+		std::condition_variable m_ready;
+		std::vector<std::coroutine_handle<> > m_queue;
+		bool m_stop;
+	};
+
+	namespace detail
+	{
+		// Shared between a finder and the pool callback reading for it, so that
+		// either may go away first
+		class state_t : public std::enable_shared_from_this<state_t>
+		{
+		public:
+			state_t(std::wstring pattern, executor_t executor, std::stop_token stop, size_t batch, PTP_CALLBACK_ENVIRON pool)
+				: m_pattern(std::move(pattern)), m_executor(executor), m_stop(std::move(stop)), m_batch(batch ? batch : 1), m_pool(pool),
+				m_abandoned(false), m_hFind(INVALID_HANDLE_VALUE), m_target(0), m_ready(-1), m_busy(false), m_done(false), m_error(0)
+			{
+				m_counts[0] = m_counts[1] = 0;
+			}
+
+			~state_t()
+			{
+				if (m_hFind != INVALID_HANDLE_VALUE)
+					::FindClose(m_hFind);
+			}
+
+			void abandon() { m_abandoned.store(true, std::memory_order_relaxed); }
+
+			// Starts reading into buffer target; called with no read in flight
+			void submit(int target)
+			{
+				{
+					std::lock_guard<std::mutex> guard(m_lock);
+					m_target = target;
+					m_busy = true;
+				}
+				std::shared_ptr<state_t>* job = new std::shared_ptr<state_t>(shared_from_this());
+				if (!::TrySubmitThreadpoolCallback(&state_t::callback, job, m_pool)) {
+					const DWORD dwError = ::GetLastError();
+					delete job;
+					std::lock_guard<std::mutex> guard(m_lock);
+					m_busy = false;
+					m_done = true;
+					m_error = dwError;
+				}
+			}
+
+			bool ready()
+			{
+				std::lock_guard<std::mutex> guard(m_lock);
+				return m_ready >= 0 || !m_busy;
+			}
+
+			bool wait(std::coroutine_handle<> h)
+			{
+				std::lock_guard<std::mutex> guard(m_lock);
+				if (m_ready >= 0 || !m_busy)
+					return false;
+				m_waiter = h;
+				return true;
+			}
+
+			// Hands out the ready batch and starts reading the next one into the
+			// buffer the consumer has just given back
+			std::span<const entry_t> take()
+			{
+				int out;
+				bool more = false;
+				{
+					std::lock_guard<std::mutex> guard(m_lock);
+					if (m_ready < 0)
+						return std::span<const entry_t>();
+					out = m_ready;
+					m_ready = -1;
+					if (!m_done) {
+						if (m_stop.stop_requested()) {
+							m_done = true;
+							m_error = ERROR_OPERATION_ABORTED;
+						}
+						else {
+							more = true;
+						}
+					}
+				}
+				if (more)
+					submit(out ^ 1);
+				return std::span<const entry_t>(m_entries[out].data(), m_counts[out]);
+			}
+
+			DWORD error()
+			{
+				std::lock_guard<std::mutex> guard(m_lock);
+				return m_error;
+			}
+
+		private:
+			state_t(const state_t&);
+			state_t& operator= (const state_t&);
+
+			static void CALLBACK callback(PTP_CALLBACK_INSTANCE, PVOID context)
+			{
+				std::unique_ptr<std::shared_ptr<state_t> > job(static_cast<std::shared_ptr<state_t>*>(context));
+				(*job)->read();
+			}
+
+			bool cancelled() const
+			{
+				return m_abandoned.load(std::memory_order_relaxed) || m_stop.stop_requested();
+			}
+
+			// Runs on a pool thread; owns m_hFind, m_fd and m_entries[m_target]
+			// until it clears m_busy
+			void read()
+			{
+				std::vector<entry_t>& entries = m_entries[m_target];
+				if (entries.size() < m_batch)
+					entries.resize(m_batch);
+
+				size_t count = 0;
+				DWORD dwError = 0;
+				bool bFound;
+				if (cancelled()) {
+					bFound = false;
+					dwError = ERROR_OPERATION_ABORTED;
+				}
+				else if (m_hFind == INVALID_HANDLE_VALUE) {
+					m_hFind = ::FindFirstFileExW(m_pattern.c_str(), FindExInfoBasic, &m_fd, FindExSearchNameMatch, NULL, FIND_FIRST_EX_LARGE_FETCH);
+					bFound = m_hFind != INVALID_HANDLE_VALUE;
+				}
+				else {
+					bFound = ::FindNextFileW(m_hFind, &m_fd) != FALSE;
+				}
+				if (!bFound && dwError == 0)
+					dwError = ::GetLastError();
+
+				while (bFound) {
+					if (!is_dots(m_fd)) {
+						entry_t& e = entries[count++];
+						e.name.assign(m_fd.cFileName);
+						e.attributes = m_fd.dwFileAttributes;
+						e.size = ((uint64_t)m_fd.nFileSizeHigh << 32) | m_fd.nFileSizeLow;
+						e.write_time = m_fd.ftLastWriteTime;
+						if (count == m_batch)
+							break;
+					}
+					if (cancelled()) {
+						bFound = false;
+						dwError = ERROR_OPERATION_ABORTED;
+						break;
+					}
+					bFound = ::FindNextFileW(m_hFind, &m_fd) != FALSE;
+					if (!bFound)
+						dwError = ::GetLastError();
+				}
+
+				// An empty drive root has no "." entry and fails with ERROR_FILE_NOT_FOUND
+				if (dwError == ERROR_NO_MORE_FILES || dwError == ERROR_FILE_NOT_FOUND)
+					dwError = 0;
+				if (!bFound && m_hFind != INVALID_HANDLE_VALUE) {
+					::FindClose(m_hFind);
+					m_hFind = INVALID_HANDLE_VALUE;
+				}
+
+				std::coroutine_handle<> waiter;
+				{
+					std::lock_guard<std::mutex> guard(m_lock);
+					m_busy = false;
+					m_counts[m_target] = count;
+					if (count != 0)
+						m_ready = m_target;
+					if (!bFound) {
+						m_done = true;
+						m_error = dwError;
+					}
+					waiter = m_waiter;
+					m_waiter = std::coroutine_handle<>();
+				}
+				if (waiter)
+					m_executor.resume(waiter);
+			}
+
+			static bool is_dots(const WIN32_FIND_DATAW& fd)
+			{
+				return (fd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) && fd.cFileName[0] == L'.' &&
+					(fd.cFileName[1] == L'\0' || (fd.cFileName[1] == L'.' && fd.cFileName[2] == L'\0'));
+			}
+
+			const std::wstring m_pattern;
+			const executor_t m_executor;
+			const std::stop_token m_stop;
+			const size_t m_batch;
+			const PTP_CALLBACK_ENVIRON m_pool;
+			std::atomic<bool> m_abandoned;
+
+			// Owned by the read in flight
+			HANDLE m_hFind;
+			WIN32_FIND_DATAW m_fd;
+			int m_target;
+
+			std::mutex m_lock;
+			std::vector<entry_t> m_entries[2];
+			size_t m_counts[2];
+			int m_ready;					// buffer holding a batch not handed out yet, or -1
+			bool m_busy;					// a read is in flight
+			bool m_done;
+			DWORD m_error;
+			std::coroutine_handle<> m_waiter;
+		};
+	}
+
+	class finder_t
+	{
+	public:
+		class next_t
+		{
+		public:
+			explicit next_t(detail::state_t* state) : m_state(state) {}
+
+			bool await_ready() { return m_state->ready(); }
+			bool await_suspend(std::coroutine_handle<> h) { return m_state->wait(h); }
+			std::span<const entry_t> await_resume() { return m_state->take(); }
+
+		private:
+			detail::state_t* m_state;
+		};
+
+		// Starts listing pszDirectory at once. batch is the number of entries per
+		// next(); pool is a callback environment for a dedicated thread pool,
+		// NULL for the process default pool.
+		explicit finder_t(LPCWSTR pszDirectory, executor_t executor = executor_t(), std::stop_token stop = std::stop_token(), size_t batch = 256, PTP_CALLBACK_ENVIRON pool = NULL)
+		{
+			std::wstring pattern(pszDirectory);
+			if (!pattern.empty() && pattern.back() != L'\\' && pattern.back() != L'/')
+				pattern += L'\\';
+			pattern += L'*';
+			m_state = std::make_shared<detail::state_t>(std::move(pattern), executor, std::move(stop), batch, pool);
+			m_state->submit(0);
+		}
+
+		~finder_t()
+		{
+			m_state->abandon();
+		}
+
+		// Next batch of entries; empty once the listing is over
+		next_t next() { return next_t(m_state.get()); }
+
+		// 0 after a complete listing, otherwise the Win32 error that ended it
+		DWORD error() const { return m_state->error(); }
+
+	private:
+		finder_t(const finder_t&);
+		finder_t& operator= (const finder_t&);
+
+		std::shared_ptr<detail::state_t> m_state;
+	};
+}
+
+#endif // _ASYNCFIND_HELPER_HPP_INCLUDED_
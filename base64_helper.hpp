@@ -0,0 +1,590 @@
+/*
+* Author: LowBoyTeam (https://github.com/LowBoyTeam)
+* License: Code Project Open License
+* Disclaimer: The software is provided "as-is". No claim of suitability, guarantee, or any warranty whatsoever is provided.
+* Copyright (c) 2016-2017.
+*/
+
+#ifndef _BASE64_HELPER_HPP_INCLUDED_
+#define _BASE64_HELPER_HPP_INCLUDED_
+
+#include <stddef.h>
+#include <string.h>
+#include <string>
+#include <string_view>
+
+#include "cpu_helper.hpp"
+
+#if defined(CPU_HELPER_ARM) && (defined(__aarch64__) || defined(_M_ARM64))
+#define BASE64_HELPER_HAS_NEON 1
+#endif
+
+////////////////////////////////////////////////////////
+// Base64 / Base64URL (RFC 4648)
+//
+//  standard_mode uses "+/" and pads with '='; url_mode uses "-_" and does
+//  not pad, so its output can go into a URL or file name as is, without
+//  url_encode. Both decoders accept input with or without padding.
+//
+//  Encoding and decoding work on whole blocks with SIMD kernels (AVX2 or
+//  SSSE3 on x86, NEON on AArch64, chosen at run time through cpu_helper)
+//  and finish the tail with a table. Output goes into a caller buffer of
+//  exactly encoded_length() / decoded_length() bytes. decode() validates
+//  as it goes and returns npos for any byte outside the alphabet, padding
+//  in the wrong place or an impossible length.
+//
+//  decoder_t decodes input that arrives in pieces, such as a MIME body,
+//  and skips whitespace (space, tab, CR, LF) anywhere in it.
+//
+//  Usage:
+//    std::string token = base64_helper::encode<base64_helper::url_mode>(std::string_view((const char*)digest.data(), digest.size()));
+//
+//    std::string bytes;
+//    if (!base64_helper::decode(text, bytes))
+//        return false;
+//
+//    base64_helper::decoder_t<> decoder;
+//    buffer.resize(decoder.max_output(piece.size()));
+//    size_t n = decoder.update(piece.data(), piece.size(), &buffer[0]);
+
+namespace base64_helper
+{
+	static const size_t npos = (size_t)-1;
+
+	namespace detail
+	{
+		// Sextet value of each byte; 0xFF for bytes outside the alphabet
+		struct decode_table_t
+		{
+			unsigned char value[256];
+		};
+
+		constexpr decode_table_t make_decode_table(const char* chars)
+		{
+			decode_table_t t = {};
+			for (int c = 0; c < 256; ++c)
+				t.value[c] = 0xFF;
+			for (int i = 0; i < 64; ++i)
+				t.value[(unsigned char)chars[i]] = (unsigned char)i;
+			return t;
+		}
+	}
+
+	struct standard_mode
+	{
+		static constexpr bool url = false;
+		static constexpr bool pad = true;
+		static constexpr char chars[65] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+		static constexpr detail::decode_table_t table = detail::make_decode_table(chars);
+	};
+
+	struct url_mode
+	{
+		static constexpr bool url = true;
+		static constexpr bool pad = false;
+		static constexpr char chars[65] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_";
+		static constexpr detail::decode_table_t table = detail::make_decode_table(chars);
+	};
+
+	namespace detail
+	{
+		inline bool is_space(char c)
+		{
+			return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+		}
+
+		inline void encode_triple(const unsigned char* src, char* dst, const char* chars)
+		{
+			const unsigned v = ((unsigned)src[0] << 16) | ((unsigned)src[1] << 8) | src[2];
+			dst[0] = chars[v >> 18];
+			dst[1] = chars[(v >> 12) & 63];
+			dst[2] = chars[(v >> 6) & 63];
+			dst[3] = chars[v & 63];
+		}
+
+		inline size_t encode_scalar(const unsigned char* src, size_t len, char* dst, const char* chars, bool pad)
+		{
+			char* to = dst;
+			size_t i = 0;
+			for (; i + 3 <= len; i += 3, to += 4)
+				encode_triple(src + i, to, chars);
+			if (i < len) {
+				unsigned char last[3] = { src[i], i + 1 < len ? src[i + 1] : (unsigned char)0, 0 };
+				char quad[4];
+				encode_triple(last, quad, chars);
+				const size_t used = len - i + 1;
+				memcpy(to, quad, used);
+				to += used;
+				if (pad) {
+					memset(to, '=', 4 - used);
+					to += 4 - used;
+				}
+			}
+			return to - dst;
+		}
+
+		inline bool decode_quad(const char* src, unsigned char* dst, const unsigned char* table)
+		{
+			const unsigned a = table[(unsigned char)src[0]], b = table[(unsigned char)src[1]];
+			const unsigned c = table[(unsigned char)src[2]], d = table[(unsigned char)src[3]];
+			if ((a | b | c | d) & 0x80)
+				return false;
+			dst[0] = (unsigned char)((a << 2) | (b >> 4));
+			dst[1] = (unsigned char)((b << 4) | (c >> 2));
+			dst[2] = (unsigned char)((c << 6) | d);
+			return true;
+		}
+
+		// n characters without padding; returns the bytes written or npos
+		inline size_t decode_scalar(const char* src, size_t n, unsigned char* dst, const unsigned char* table)
+		{
+			unsigned char* to = dst;
+			size_t i = 0;
+			for (; i + 4 <= n; i += 4, to += 3) {
+				if (!decode_quad(src + i, to, table))
+					return npos;
+			}
+			const size_t rest = n - i;
+			if (rest == 1)
+				return npos;
+			if (rest > 1) {
+				char quad[4] = { src[i], src[i + 1], rest > 2 ? src[i + 2] : 'A', 'A' };
+				unsigned char bytes[3];
+				if (!decode_quad(quad, bytes, table))
+					return npos;
+				memcpy(to, bytes, rest - 1);
+				to += rest - 1;
+			}
+			return to - dst;
+		}
+
+		// Kernels handle whole blocks and return how much input they consumed:
+		// a multiple of 3 bytes for encoding, of 4 characters for decoding. A
+		// decode kernel stops in front of a block it cannot decode and leaves
+		// the error to decode_scalar. Decode kernels may store up to 8 bytes
+		// past the block they decode, so they stop early enough for those to
+		// land on output the following characters will produce anyway.
+		typedef size_t encode_fn(const unsigned char* src, size_t len, char* dst, bool url);
+		typedef size_t decode_fn(const char* src, size_t n, unsigned char* dst, bool url);
+
+		inline size_t encode_none(const unsigned char*, size_t, char*, bool)
+		{
+			return 0;
+		}
+
+		inline size_t decode_none(const char*, size_t, unsigned char*, bool)
+		{
+			return 0;
+		}
+
+#ifdef CPU_HELPER_X86
+		// Spreads 12 bytes into 16 sextets, one per byte (per 128-bit lane)
+		CPU_HELPER_TARGET_SSSE3 inline __m128i enc_reshuffle(__m128i in)
+		{
+			in = _mm_shuffle_epi8(in, _mm_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1));
+			const __m128i t0 = _mm_and_si128(in, _mm_set1_epi32(0x0FC0FC00));
+			const __m128i t1 = _mm_mulhi_epu16(t0, _mm_set1_epi32(0x04000040));
+			const __m128i t2 = _mm_and_si128(in, _mm_set1_epi32(0x003F03F0));
+			const __m128i t3 = _mm_mullo_epi16(t2, _mm_set1_epi32(0x01000010));
+			return _mm_or_si128(t1, t3);
+		}
+
+		// Sextets to characters: one pshufb picks the offset of each range
+		CPU_HELPER_TARGET_SSSE3 inline __m128i enc_translate(__m128i in, __m128i lut)
+		{
+			__m128i indices = _mm_subs_epu8(in, _mm_set1_epi8(51));
+			indices = _mm_sub_epi8(indices, _mm_cmpgt_epi8(in, _mm_set1_epi8(25)));
+			return _mm_add_epi8(in, _mm_shuffle_epi8(lut, indices));
+		}
+
+		inline __m128i enc_lut(bool url)
+		{
+			return url ? _mm_setr_epi8(65, 71, -4, -4, -4, -4, -4, -4, -4, -4, -4, -4, '-' - 62, '_' - 63, 0, 0)
+				: _mm_setr_epi8(65, 71, -4, -4, -4, -4, -4, -4, -4, -4, -4, -4, '+' - 62, '/' - 63, 0, 0);
+		}
+
+		CPU_HELPER_TARGET_SSSE3 inline size_t encode_ssse3(const unsigned char* src, size_t len, char* dst, bool url)
+		{
+			const __m128i lut = enc_lut(url);
+			size_t i = 0;
+			// Each step reads 16 bytes and uses 12
+			for (; len - i >= 16; i += 12, dst += 16) {
+				const __m128i in = _mm_loadu_si128((const __m128i*)(src + i));
+				_mm_storeu_si128((__m128i*)dst, enc_translate(enc_reshuffle(in), lut));
+			}
+			return i;
+		}
+
+		// Maps 16 characters to 16 sextets; false if any is not in the alphabet.
+		// The URL alphabet is folded onto "+/" first so one table serves both.
+		CPU_HELPER_TARGET_SSSE3 inline bool dec_translate(__m128i& str, bool url)
+		{
+			const __m128i lut_lo = _mm_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A);
+			const __m128i lut_hi = _mm_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+			const __m128i lut_roll = _mm_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+			const __m128i mask_2F = _mm_set1_epi8(0x2F);
+
+			__m128i bad = _mm_setzero_si128();
+			if (url) {
+				bad = _mm_or_si128(_mm_cmpeq_epi8(str, _mm_set1_epi8('+')), _mm_cmpeq_epi8(str, mask_2F));
+				str = _mm_add_epi8(str, _mm_and_si128(_mm_cmpeq_epi8(str, _mm_set1_epi8('-')), _mm_set1_epi8('+' - '-')));
+				str = _mm_add_epi8(str, _mm_and_si128(_mm_cmpeq_epi8(str, _mm_set1_epi8('_')), _mm_set1_epi8('/' - '_')));
+			}
+			const __m128i hi_nibbles = _mm_and_si128(_mm_srli_epi32(str, 4), mask_2F);
+			const __m128i lo_nibbles = _mm_and_si128(str, mask_2F);
+			const __m128i hi = _mm_shuffle_epi8(lut_hi, hi_nibbles);
+			const __m128i lo = _mm_shuffle_epi8(lut_lo, lo_nibbles);
+			bad = _mm_or_si128(bad, _mm_xor_si128(_mm_cmpeq_epi8(_mm_and_si128(lo, hi), _mm_setzero_si128()), _mm_set1_epi8(-1)));
+			if (_mm_movemask_epi8(bad) != 0)
+				return false;
+			const __m128i eq_2F = _mm_cmpeq_epi8(str, mask_2F);
+			str = _mm_add_epi8(str, _mm_shuffle_epi8(lut_roll, _mm_add_epi8(eq_2F, hi_nibbles)));
+			return true;
+		}
+
+		// Packs 16 sextets into 12 bytes at the start of the register
+		CPU_HELPER_TARGET_SSSE3 inline __m128i dec_reshuffle(__m128i in)
+		{
+			const __m128i merge_ab_and_bc = _mm_maddubs_epi16(in, _mm_set1_epi32(0x01400140));
+			const __m128i out = _mm_madd_epi16(merge_ab_and_bc, _mm_set1_epi32(0x00011000));
+			return _mm_shuffle_epi8(out, _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+		}
+
+		CPU_HELPER_TARGET_SSSE3 inline size_t decode_ssse3(const char* src, size_t n, unsigned char* dst, bool url)
+		{
+			size_t i = 0;
+			// Stores 16 bytes for 12; the 8 characters after the block cover the rest
+			for (; n - i >= 24; i += 16, dst += 12) {
+				__m128i str = _mm_loadu_si128((const __m128i*)(src + i));
+				if (!dec_translate(str, url))
+					break;
+				_mm_storeu_si128((__m128i*)dst, dec_reshuffle(str));
+			}
+			return i;
+		}
+
+		CPU_HELPER_TARGET_AVX2 inline size_t encode_avx2(const unsigned char* src, size_t len, char* dst, bool url)
+		{
+			const __m256i shuffle = _mm256_setr_epi8(1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10, 1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10);
+			const __m256i lut = _mm256_broadcastsi128_si256(enc_lut(url));
+			size_t i = 0;
+			// Lane 0 takes bytes [0, 12), lane 1 bytes [12, 24); the load reads 28
+			for (; len - i >= 28; i += 24, dst += 32) {
+				const __m128i lo = _mm_loadu_si128((const __m128i*)(src + i));
+				const __m128i hi = _mm_loadu_si128((const __m128i*)(src + i + 12));
+				__m256i in = _mm256_shuffle_epi8(_mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1), shuffle);
+				const __m256i t1 = _mm256_mulhi_epu16(_mm256_and_si256(in, _mm256_set1_epi32(0x0FC0FC00)), _mm256_set1_epi32(0x04000040));
+				const __m256i t3 = _mm256_mullo_epi16(_mm256_and_si256(in, _mm256_set1_epi32(0x003F03F0)), _mm256_set1_epi32(0x01000010));
+				in = _mm256_or_si256(t1, t3);
+
+				__m256i indices = _mm256_subs_epu8(in, _mm256_set1_epi8(51));
+				indices = _mm256_sub_epi8(indices, _mm256_cmpgt_epi8(in, _mm256_set1_epi8(25)));
+				_mm256_storeu_si256((__m256i*)dst, _mm256_add_epi8(in, _mm256_shuffle_epi8(lut, indices)));
+			}
+			return i;
+		}
+
+		CPU_HELPER_TARGET_AVX2 inline size_t decode_avx2(const char* src, size_t n, unsigned char* dst, bool url)
+		{
+			const __m256i lut_lo = _mm256_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A,
+				0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A);
+			const __m256i lut_hi = _mm256_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+				0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+			const __m256i lut_roll = _mm256_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0,
+				0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+			const __m256i mask_2F = _mm256_set1_epi8(0x2F);
+			const __m256i pack = _mm256_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1,
+				2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+
+			size_t i = 0;
+			// Stores 32 bytes for 24; the 12 characters after the block cover the rest
+			for (; n - i >= 44; i += 32, dst += 24) {
+				__m256i str = _mm256_loadu_si256((const __m256i*)(src + i));
+				__m256i bad = _mm256_setzero_si256();
+				if (url) {
+					bad = _mm256_or_si256(_mm256_cmpeq_epi8(str, _mm256_set1_epi8('+')), _mm256_cmpeq_epi8(str, mask_2F));
+					str = _mm256_add_epi8(str, _mm256_and_si256(_mm256_cmpeq_epi8(str, _mm256_set1_epi8('-')), _mm256_set1_epi8('+' - '-')));
+					str = _mm256_add_epi8(str, _mm256_and_si256(_mm256_cmpeq_epi8(str, _mm256_set1_epi8('_')), _mm256_set1_epi8('/' - '_')));
+				}
+				const __m256i hi_nibbles = _mm256_and_si256(_mm256_srli_epi32(str, 4), mask_2F);
+				const __m256i lo = _mm256_shuffle_epi8(lut_lo, _mm256_and_si256(str, mask_2F));
+				const __m256i hi = _mm256_shuffle_epi8(lut_hi, hi_nibbles);
+				if (!_mm256_testz_si256(lo, hi) || !_mm256_testz_si256(bad, bad))
+					break;
+				str = _mm256_add_epi8(str, _mm256_shuffle_epi8(lut_roll, _mm256_add_epi8(_mm256_cmpeq_epi8(str, mask_2F), hi_nibbles)));
+
+				const __m256i merge_ab_and_bc = _mm256_maddubs_epi16(str, _mm256_set1_epi32(0x01400140));
+				__m256i out = _mm256_shuffle_epi8(_mm256_madd_epi16(merge_ab_and_bc, _mm256_set1_epi32(0x00011000)), pack);
+				out = _mm256_permutevar8x32_epi32(out, _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 7, 7));
+				_mm256_storeu_si256((__m256i*)dst, out);
+			}
+			return i;
+		}
+#endif
+
+#ifdef BASE64_HELPER_HAS_NEON
+		inline size_t encode_neon(const unsigned char* src, size_t len, char* dst, bool url)
+		{
+			const uint8_t* chars = (const uint8_t*)(url ? url_mode::chars : standard_mode::chars);
+			uint8x16x4_t table;
+			table.val[0] = vld1q_u8(chars);
+			table.val[1] = vld1q_u8(chars + 16);
+			table.val[2] = vld1q_u8(chars + 32);
+			table.val[3] = vld1q_u8(chars + 48);
+			const uint8x16_t mask = vdupq_n_u8(0x3F);
+
+			size_t i = 0;
+			for (; len - i >= 48; i += 48, dst += 64) {
+				const uint8x16x3_t in = vld3q_u8(src + i);
+				uint8x16x4_t out;
+				out.val[0] = vqtbl4q_u8(table, vshrq_n_u8(in.val[0], 2));
+				out.val[1] = vqtbl4q_u8(table, vandq_u8(vorrq_u8(vshrq_n_u8(in.val[1], 4), vshlq_n_u8(in.val[0], 4)), mask));
+				out.val[2] = vqtbl4q_u8(table, vandq_u8(vorrq_u8(vshrq_n_u8(in.val[2], 6), vshlq_n_u8(in.val[1], 2)), mask));
+				out.val[3] = vqtbl4q_u8(table, vandq_u8(in.val[2], mask));
+				vst4q_u8((uint8_t*)dst, out);
+			}
+			return i;
+		}
+
+		inline size_t decode_neon(const char* src, size_t n, unsigned char* dst, bool url)
+		{
+			// Two 64-entry lookups cover ASCII; bytes >= 0x80 are caught by their top bit
+			const uint8_t* values = url ? url_mode::table.value : standard_mode::table.value;
+			uint8x16x4_t low, high;
+			for (int k = 0; k < 4; ++k) {
+				low.val[k] = vld1q_u8(values + 16 * k);
+				high.val[k] = vld1q_u8(values + 64 + 16 * k);
+			}
+			const uint8x16_t offset = vdupq_n_u8(64);
+
+			size_t i = 0;
+			for (; n - i >= 64; i += 64, dst += 48) {
+				const uint8x16x4_t in = vld4q_u8((const uint8_t*)src + i);
+				uint8x16_t v[4];
+				uint8x16_t check = vdupq_n_u8(0);
+				for (int k = 0; k < 4; ++k) {
+					v[k] = vqtbx4q_u8(vqtbl4q_u8(low, in.val[k]), high, vsubq_u8(in.val[k], offset));
+					check = vorrq_u8(check, vorrq_u8(v[k], in.val[k]));
+				}
+				if (vmaxvq_u8(check) & 0x80)
+					break;
+				uint8x16x3_t out;
+				out.val[0] = vorrq_u8(vshlq_n_u8(v[0], 2), vshrq_n_u8(v[1], 4));
+				out.val[1] = vorrq_u8(vshlq_n_u8(v[1], 4), vshrq_n_u8(v[2], 2));
+				out.val[2] = vorrq_u8(vshlq_n_u8(v[2], 6), v[3]);
+				vst3q_u8(dst, out);
+			}
+			return i;
+		}
+#endif
+
+		inline cpu_helper::dispatch_t<encode_fn>& encode_kernel()
+		{
+			static cpu_helper::dispatch_t<encode_fn> kernel = {
+#ifdef CPU_HELPER_X86
+				{ cpu_helper::kAVX2, encode_avx2 },
+				{ cpu_helper::kSSSE3, encode_ssse3 },
+#endif
+#ifdef BASE64_HELPER_HAS_NEON
+				{ cpu_helper::kNEON, encode_neon },
+#endif
+				{ 0, encode_none } };
+			return kernel;
+		}
+
+		inline cpu_helper::dispatch_t<decode_fn>& decode_kernel()
+		{
+			static cpu_helper::dispatch_t<decode_fn> kernel = {
+#ifdef CPU_HELPER_X86
+				{ cpu_helper::kAVX2, decode_avx2 },
+				{ cpu_helper::kSSSE3, decode_ssse3 },
+#endif
+#ifdef BASE64_HELPER_HAS_NEON
+				{ cpu_helper::kNEON, decode_neon },
+#endif
+				{ 0, decode_none } };
+			return kernel;
+		}
+
+		// Characters left once trailing padding is dropped
+		inline size_t unpadded_length(const char* src, size_t len)
+		{
+			if (len % 4 == 0 && len > 0 && src[len - 1] == '=') {
+				--len;
+				if (src[len - 1] == '=')
+					--len;
+			}
+			return len;
+		}
+	}
+
+	template <class Mode = standard_mode>
+	inline size_t encoded_length(size_t len)
+	{
+		return Mode::pad ? (len + 2) / 3 * 4 : len / 3 * 4 + (len % 3 ? len % 3 + 1 : 0);
+	}
+
+	// Encodes src[0, len) into dst, which must hold encoded_length<Mode>(len) characters
+	template <class Mode = standard_mode>
+	inline size_t encode(const void* src, size_t len, char* dst)
+	{
+		const unsigned char* from = (const unsigned char*)src;
+		const size_t done = detail::encode_kernel().get()(from, len, dst, Mode::url);
+		return done / 3 * 4 + detail::encode_scalar(from + done, len - done, dst + done / 3 * 4, Mode::chars, Mode::pad);
+	}
+
+	// Appends the encoding of src to out
+	template <class Mode = standard_mode>
+	inline std::string& encode(std::string_view src, std::string& out)
+	{
+		const size_t pos = out.size();
+		out.resize(pos + encoded_length<Mode>(src.size()));
+		encode<Mode>(src.data(), src.size(), &out[0] + pos);
+		return out;
+	}
+
+	template <class Mode = standard_mode>
+	inline std::string encode(std::string_view src)
+	{
+		std::string out;
+		return encode<Mode>(src, out);
+	}
+
+	// Exact size of the decoded src, assuming it is valid
+	inline size_t decoded_length(const char* src, size_t len)
+	{
+		const size_t n = detail::unpadded_length(src, len);
+		return n / 4 * 3 + (n % 4 > 1 ? n % 4 - 1 : 0);
+	}
+
+	// Decodes src[0, len) into dst, which must hold decoded_length(src, len)
+	// bytes. Returns the number of bytes written, or npos if src is invalid.
+	template <class Mode = standard_mode>
+	inline size_t decode(const char* src, size_t len, void* dst)
+	{
+		const size_t n = detail::unpadded_length(src, len);
+		if (n % 4 == 1)
+			return npos;
+		unsigned char* to = (unsigned char*)dst;
+		const size_t done = detail::decode_kernel().get()(src, n, to, Mode::url);
+		const size_t rest = detail::decode_scalar(src + done, n - done, to + done / 4 * 3, Mode::table.value);
+		return rest == npos ? npos : done / 4 * 3 + rest;
+	}
+
+	// Appends the decoded src to out. On invalid input returns false and
+	// leaves out as it was.
+	template <class Mode = standard_mode>
+	inline bool decode(std::string_view src, std::string& out)
+	{
+		const size_t pos = out.size();
+		out.resize(pos + decoded_length(src.data(), src.size()));
+		if (decode<Mode>(src.data(), src.size(), &out[0] + pos) == npos) {
+			out.resize(pos);
+			return false;
+		}
+		return true;
+	}
+
+	////////////////////////////////////////////////////////
+	// Streaming decoder
+	//
+	//  Feed the input in pieces of any size with update(), then call finish()
+	//  once. Whitespace between characters is skipped. Whole blocks between
+	//  line breaks still go through the SIMD kernel. Once any input is found
+	//  invalid, update() and finish() return npos until reset().
+	template <class Mode = standard_mode>
+	class decoder_t
+	{
+	public:
+		decoder_t() : m_count(0), m_padding(0), m_failed(false) {}
+
+		// Most bytes update() can write for len characters of input
+		static size_t max_output(size_t len)
+		{
+			return (len + 3) / 4 * 3;
+		}
+
+		// Decodes src[0, len) into dst, which must hold max_output(len) bytes.
+		// Returns the number of bytes written, or npos.
+		size_t update(const char* src, size_t len, void* dst)
+		{
+			if (m_failed)
+				return npos;
+			const char* p = src;
+			const char* end = src + len;
+			unsigned char* to = (unsigned char*)dst;
+			detail::decode_fn* kernel = detail::decode_kernel().get();
+
+			bool fresh = true;	// the kernel has not looked at the input from p on
+			while (p < end) {
+				// At a group boundary, let the kernel take every whole block up to
+				// the next whitespace; it is not worth asking again before that
+				if (fresh && m_count == 0 && m_padding == 0) {
+					const size_t done = kernel(p, end - p, to, Mode::url);
+					p += done;
+					to += done / 4 * 3;
+					fresh = false;
+					if (p == end)
+						break;
+				}
+
+				const char c = *p++;
+				if (detail::is_space(c)) {
+					fresh = true;
+					continue;
+				}
+				// Padding ends the data: only more '=' and whitespace may follow
+				if (c == '=' || m_padding) {
+					if (c != '=' || ++m_padding > 2)
+						return fail();
+					continue;
+				}
+				m_pending[m_count++] = c;
+				if (m_count == 4) {
+					if (!detail::decode_quad(m_pending, to, Mode::table.value))
+						return fail();
+					to += 3;
+					m_count = 0;
+				}
+			}
+			return to - (unsigned char*)dst;
+		}
+
+		// Writes the last bytes (at most 2) into dst and resets the decoder.
+		// Returns the number of bytes written, or npos if the input was
+		// invalid or ended in the middle of a group.
+		size_t finish(void* dst)
+		{
+			if (m_failed || m_count == 1 || (m_padding && m_count + m_padding != 4)) {
+				reset();
+				return npos;
+			}
+			const size_t written = m_count ? detail::decode_scalar(m_pending, m_count, (unsigned char*)dst, Mode::table.value) : 0;
+			reset();
+			return written;
+		}
+
+		void reset()
+		{
+			m_count = 0;
+			m_padding = 0;
+			m_failed = false;
+		}
+
+		bool failed() const { return m_failed; }
+
+	private:
+		size_t fail()
+		{
+			m_failed = true;
+			return npos;
+		}
+
+		char m_pending[4];
+		size_t m_count;
+		size_t m_padding;
+		bool m_failed;
+	};
+}
+
+#endif // _BASE64_HELPER_HPP_INCLUDED_
@@ -0,0 +1,141 @@
+/*
+* Author: LowBoyTeam (https://github.com/LowBoyTeam)
+* License: Code Project Open License
+* Disclaimer: The software is provided "as-is". No claim of suitability, guarantee, or any warranty whatsoever is provided.
+* Copyright (c) 2016-2017.
+*/
+
+#include "bench_common.hpp"
+#include "asyncfind_helper.hpp"
+#include "filefinder_helper.hpp"
+
+#include <string>
+
+// Fire-and-forget coroutine, enough to drive finders from the benchmark
+struct detached_t
+{
+	struct promise_type
+	{
+		detached_t get_return_object() { return detached_t(); }
+		std::suspend_never initial_suspend() { return std::suspend_never(); }
+		std::suspend_never final_suspend() noexcept { return std::suspend_never(); }
+		void return_void() {}
+		void unhandled_exception() { std::terminate(); }
+	};
+};
+
+// Creates root\dir0 .. root\dirN with files_per_dir empty files each
+static void make_dirs(const std::wstring& root, int dirs, int files_per_dir)
+{
+	::CreateDirectoryW(root.c_str(), NULL);
+	for (int d = 0; d < dirs; ++d)
+	{
+		std::wstring dir = root + L"\\dir" + std::to_wstring(d);
+		::CreateDirectoryW(dir.c_str(), NULL);
+		for (int f = 0; f < files_per_dir; ++f)
+		{
+			std::wstring file = dir + L"\\file" + std::to_wstring(f) + L".dat";
+			HANDLE h = ::CreateFileW(file.c_str(), GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+			if (h != INVALID_HANDLE_VALUE)
+				::CloseHandle(h);
+		}
+	}
+}
+
+static void remove_tree(const std::wstring& root)
+{
+	filefinder_helper finder;
+	BOOL bFound = finder.FindFile((root + L"\\*").c_str());
+	while (bFound)
+	{
+		if (!finder.IsDots())
+		{
+			std::wstring path = root + L"\\" + finder.m_fd.cFileName;
+			if (finder.IsDirectory())
+				remove_tree(path);
+			else
+				::DeleteFileW(path.c_str());
+		}
+		bFound = finder.FindNextFile();
+	}
+	finder.Close();
+	::RemoveDirectoryW(root.c_str());
+}
+
+static size_t list_sync(const std::wstring& dir)
+{
+	size_t count = 0;
+	filefinder_helper finder;
+	BOOL bFound = finder.FindFile((dir + L"\\*").c_str());
+	while (bFound)
+	{
+		if (!finder.IsDots())
+			++count;
+		bFound = finder.FindNextFile();
+	}
+	return count;
+}
+
+struct counter_t
+{
+	asyncfind_helper::loop_t* loop;
+	size_t pending;
+	size_t entries;
+};
+
+static detached_t list_async(std::wstring dir, counter_t& counter)
+{
+	asyncfind_helper::finder_t finder(dir.c_str(), asyncfind_helper::executor_t::from(*counter.loop));
+	for (;;)
+	{
+		std::span<const asyncfind_helper::entry_t> batch = co_await finder.next();
+		if (batch.empty())
+			break;
+		counter.entries += batch.size();
+	}
+	// Runs on the loop thread, so the counter needs no lock
+	if (--counter.pending == 0)
+		counter.loop->stop();
+}
+
+int main(int argc, char** argv)
+{
+	bench::runner_t runner(argc, argv, "asyncfind_helper");
+
+	WCHAR szTemp[MAX_PATH];
+	::GetTempPathW(MAX_PATH, szTemp);
+
+	// directories, files per directory
+	const int shapes[][2] = { { 64, 64 }, { 1024, 16 }, { 16, 4096 } };
+	for (size_t i = 0; i < sizeof(shapes) / sizeof(shapes[0]); ++i)
+	{
+		std::wstring root = std::wstring(szTemp) + L"cpp_utils_bench_async_" + std::to_wstring(i);
+		remove_tree(root);
+		make_dirs(root, shapes[i][0], shapes[i][1]);
+
+		std::vector<std::wstring> dirs;
+		for (int d = 0; d < shapes[i][0]; ++d)
+			dirs.push_back(root + L"\\dir" + std::to_wstring(d));
+		const std::string name = std::to_string(shapes[i][0]) + "x" + std::to_string(shapes[i][1]);
+
+		runner.run("filefinder/" + name, 0, [&] {
+			size_t entries = 0;
+			for (size_t d = 0; d < dirs.size(); ++d)
+				entries += list_sync(dirs[d]);
+			bench::do_not_optimize(entries);
+		});
+
+		runner.run("finder/" + name, 0, [&] {
+			asyncfind_helper::loop_t loop;
+			counter_t counter = { &loop, dirs.size(), 0 };
+			for (size_t d = 0; d < dirs.size(); ++d)
+				list_async(dirs[d], counter);
+			loop.run();
+			bench::do_not_optimize(counter.entries);
+		});
+
+		remove_tree(root);
+	}
+
+	return runner.finish();
+}
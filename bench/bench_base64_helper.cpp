@@ -0,0 +1,73 @@
+/*
+* Author: LowBoyTeam (https://github.com/LowBoyTeam)
+* License: Code Project Open License
+* Disclaimer: The software is provided "as-is". No claim of suitability, guarantee, or any warranty whatsoever is provided.
+* Copyright (c) 2016-2017.
+*/
+
+#include "bench_common.hpp"
+#include "url_helper.hpp"
+#include "base64_helper.hpp"
+
+// The path being replaced: a byte-at-a-time encoder, then url_encode
+static std::string naive_token(const std::string& bytes)
+{
+	static const char chars[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+	std::string out;
+	unsigned bits = 0, count = 0;
+	for (size_t i = 0; i < bytes.size(); ++i) {
+		bits = (bits << 8) | (unsigned char)bytes[i];
+		count += 8;
+		while (count >= 6) {
+			count -= 6;
+			out += chars[(bits >> count) & 63];
+		}
+	}
+	if (count)
+		out += chars[(bits << (6 - count)) & 63];
+	while (out.size() % 4)
+		out += '=';
+	return url_helper::url_encode<url_helper::raw_mode>(out);
+}
+
+int main(int argc, char** argv)
+{
+	bench::runner_t runner(argc, argv, "base64_helper");
+	const size_t sizes[] = { 32, 4096, 1 << 20 };
+
+	for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); ++i)
+	{
+		const std::string n = std::to_string(sizes[i]);
+		const std::string bytes = bench::random_bytes(sizes[i], sizes[i]);
+		const std::string text = base64_helper::encode(bytes);
+		std::string out(base64_helper::encoded_length(bytes.size()) + 16, '\0');
+
+		runner.run("naive_url_token/" + n, bytes.size(), [&] {
+			bench::do_not_optimize(naive_token(bytes));
+		});
+		runner.run("encode/" + n, bytes.size(), [&] {
+			bench::do_not_optimize(base64_helper::encode(bytes.data(), bytes.size(), &out[0]));
+		});
+		runner.run("encode_url/" + n, bytes.size(), [&] {
+			bench::do_not_optimize(base64_helper::encode<base64_helper::url_mode>(bytes.data(), bytes.size(), &out[0]));
+		});
+		runner.run("decode/" + n, text.size(), [&] {
+			bench::do_not_optimize(base64_helper::decode(text.data(), text.size(), &out[0]));
+		});
+	}
+
+	// MIME style: 76 characters per line, CRLF between lines
+	const std::string bytes = bench::random_bytes(1 << 20, 42);
+	const std::string flat = base64_helper::encode(bytes);
+	std::string mime;
+	for (size_t pos = 0; pos < flat.size(); pos += 76)
+		mime.append(flat, pos, 76).append("\r\n");
+	std::string out(base64_helper::decoder_t<>::max_output(mime.size()), '\0');
+	runner.run("decoder_mime/1048576", mime.size(), [&] {
+		base64_helper::decoder_t<> decoder;
+		size_t written = decoder.update(mime.data(), mime.size(), &out[0]);
+		bench::do_not_optimize(written + decoder.finish(&out[0] + written));
+	});
+
+	return runner.finish();
+}
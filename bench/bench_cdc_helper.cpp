@@ -0,0 +1,49 @@
+/*
+* Author: LowBoyTeam (https://github.com/LowBoyTeam)
+* License: Code Project Open License
+* Disclaimer: The software is provided "as-is". No claim of suitability, guarantee, or any warranty whatsoever is provided.
+* Copyright (c) 2016-2017.
+*/
+
+#include "bench_common.hpp"
+#include "cdc_helper.hpp"
+
+int main(int argc, char** argv)
+{
+	bench::runner_t runner(argc, argv, "cdc_helper");
+	const std::string data = bench::random_bytes(64 << 20);
+
+	// min, avg, max
+	const size_t shapes[][3] = { { 2048, 8192, 65536 }, { 16384, 65536, 262144 }, { 256 * 1024, 1024 * 1024, 4096 * 1024 } };
+	for (size_t i = 0; i < sizeof(shapes) / sizeof(shapes[0]); ++i)
+	{
+		cdc_helper::chunker_t chunker(cdc_helper::params_t(shapes[i][0], shapes[i][1], shapes[i][2]));
+		runner.run("split/avg" + std::to_string(shapes[i][1]), data.size(), [&] {
+			size_t count = 0;
+			chunker.split(data.data(), data.size(), [&count](uint64_t, size_t) { ++count; });
+			bench::do_not_optimize(count);
+		});
+	}
+
+	// Fixed-size blocks with no gear hash, each read once as 64-bit words:
+	// what a chunker costs that only has to look at every byte
+	runner.run("fixed/8192", data.size(), [&] {
+		size_t count = 0;
+		uint64_t sum = 0;
+		for (size_t offset = 0; offset < data.size(); offset += 8192)
+		{
+			const size_t end = offset + 8192 < data.size() ? offset + 8192 : data.size();
+			for (size_t i = offset; i + 8 <= end; i += 8)
+			{
+				uint64_t word;
+				memcpy(&word, data.data() + i, 8);
+				sum += word;
+			}
+			++count;
+		}
+		bench::do_not_optimize(count);
+		bench::do_not_optimize(sum);
+	});
+
+	return runner.finish();
+}
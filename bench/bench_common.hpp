@@ -0,0 +1,258 @@
+/*
+* Author: LowBoyTeam (https://github.com/LowBoyTeam)
+* License: Code Project Open License
+* Disclaimer: The software is provided "as-is". No claim of suitability, guarantee, or any warranty whatsoever is provided.
+* Copyright (c) 2016-2017.
+*/
+
+#ifndef _BENCH_COMMON_HPP_INCLUDED_
+#define _BENCH_COMMON_HPP_INCLUDED_
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <time.h>
+#endif
+
+////////////////////////////////////////////////////////
+// Minimal benchmark harness shared by the bench_* executables
+//
+//  Every case is calibrated until one sample runs for at least --min-time
+//  seconds, then sampled several times; the median is reported. Wall time
+//  is real_time; cpu_time is the CPU time of the whole process, so it covers
+//  worker threads and exceeds real_time for multi-threaded cases. Results go
+//  to stderr as a table and, with --json <file>, to a file in the same
+//  layout Google Benchmark writes, so its compare.py can diff two runs.
+//
+//  Data sets come from a fixed-seed splitmix64 generator rather than
+//  <random> distributions, whose output differs between standard libraries,
+//  so every platform benchmarks identical input.
+//
+//  Usage:
+//    bench::runner_t runner(argc, argv, "url_helper");
+//    runner.run("url_encode/4096", data.size(), [&] { bench::do_not_optimize(url_encode(data)); });
+//    return runner.finish();
+
+namespace bench
+{
+	template <class T>
+	inline void do_not_optimize(const T& value)
+	{
+#ifdef _MSC_VER
+		static const void* volatile sink;
+		sink = &value;
+		_ReadWriteBarrier();
+#else
+		asm volatile("" : : "g"(&value) : "memory");
+#endif
+	}
+
+	class random_t
+	{
+	public:
+		explicit random_t(uint64_t seed = 0x5EED) : m_state(seed) {}
+
+		uint64_t next()
+		{
+			uint64_t z = (m_state += 0x9E3779B97F4A7C15ULL);
+			z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+			z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+			return z ^ (z >> 31);
+		}
+
+		size_t below(size_t bound) { return (size_t)(next() % bound); }
+
+	private:
+		uint64_t m_state;
+	};
+
+	// size bytes drawn uniformly from alphabet
+	inline std::string random_text(size_t size, const std::string& alphabet, uint64_t seed = 1)
+	{
+		random_t rng(seed);
+		std::string s(size, '\0');
+		for (size_t i = 0; i < size; ++i)
+			s[i] = alphabet[rng.below(alphabet.size())];
+		return s;
+	}
+
+	inline std::string random_bytes(size_t size, uint64_t seed = 1)
+	{
+		random_t rng(seed);
+		std::string s(size, '\0');
+		for (size_t i = 0; i < size; ++i)
+			s[i] = (char)(rng.next() & 0xFF);
+		return s;
+	}
+
+	// count tokens of 1..max_len letters joined by delim
+	inline std::string random_tokens(size_t count, size_t max_len, const std::string& delim, uint64_t seed = 1)
+	{
+		random_t rng(seed);
+		std::string s;
+		for (size_t i = 0; i < count; ++i)
+		{
+			if (i)
+				s += delim;
+			size_t len = 1 + rng.below(max_len);
+			for (size_t k = 0; k < len; ++k)
+				s += (char)('a' + rng.below(26));
+		}
+		return s;
+	}
+
+	struct result_t
+	{
+		std::string name;
+		uint64_t iterations;
+		double ns_per_op;
+		double cpu_ns_per_op;
+		double bytes_per_second;
+	};
+
+	class runner_t
+	{
+	public:
+		runner_t(int argc, char** argv, const char* suite) : m_suite(suite), m_min_time(0.1), m_samples(5)
+		{
+			for (int i = 1; i < argc; ++i)
+			{
+				if (!strcmp(argv[i], "--json") && i + 1 < argc)
+					m_json = argv[++i];
+				else if (!strcmp(argv[i], "--filter") && i + 1 < argc)
+					m_filter = argv[++i];
+				else if (!strcmp(argv[i], "--min-time") && i + 1 < argc)
+					m_min_time = atof(argv[++i]);
+				else if (!strcmp(argv[i], "--samples") && i + 1 < argc)
+					m_samples = atoi(argv[++i]) > 0 ? atoi(argv[i]) : 1;
+				else
+					fprintf(stderr, "usage: %s [--json file] [--filter substring] [--min-time seconds] [--samples n]\n", argv[0]);
+			}
+		}
+
+		// bytes is the amount of input one call of fn processes (0 if not meaningful)
+		template <class F>
+		void run(const std::string& name, size_t bytes, F fn)
+		{
+			if (!m_filter.empty() && name.find(m_filter) == std::string::npos)
+				return;
+
+			// Calibrate: double the batch until one batch takes min_time
+			uint64_t iterations = 1;
+			for (;;)
+			{
+				double cpu;
+				double elapsed = time_batch(fn, iterations, cpu);
+				if (elapsed >= m_min_time || iterations >= (1ULL << 40))
+					break;
+				double scale = elapsed > 0 ? m_min_time * 1.2 / elapsed : 10.0;
+				iterations = (uint64_t)(iterations * (scale > 10.0 ? 10.0 : (scale < 2.0 ? 2.0 : scale)));
+			}
+
+			std::vector<double> samples, cpu_samples;
+			for (int i = 0; i < m_samples; ++i)
+			{
+				double cpu;
+				samples.push_back(time_batch(fn, iterations, cpu) * 1e9 / iterations);
+				cpu_samples.push_back(cpu * 1e9 / iterations);
+			}
+			std::sort(samples.begin(), samples.end());
+			std::sort(cpu_samples.begin(), cpu_samples.end());
+
+			result_t r;
+			r.name = name;
+			r.iterations = iterations;
+			r.ns_per_op = samples[samples.size() / 2];
+			r.cpu_ns_per_op = cpu_samples[cpu_samples.size() / 2];
+			r.bytes_per_second = bytes ? bytes * 1e9 / r.ns_per_op : 0.0;
+			m_results.push_back(r);
+
+			fprintf(stderr, "%-48s %14.1f ns %12.1f MB/s %12llu it\n", (m_suite + "/" + name).c_str(), r.ns_per_op,
+				r.bytes_per_second / 1e6, (unsigned long long)iterations);
+		}
+
+		// Writes the JSON report if requested; returns the process exit code
+		int finish()
+		{
+			if (m_json.empty())
+				return 0;
+
+			FILE* f = fopen(m_json.c_str(), "w");
+			if (f == NULL)
+			{
+				fprintf(stderr, "cannot write %s\n", m_json.c_str());
+				return 1;
+			}
+
+			fprintf(f, "{\n  \"context\": {\n    \"executable\": \"%s\",\n    \"min_time\": %g,\n    \"samples\": %d\n  },\n  \"benchmarks\": [\n",
+				m_suite.c_str(), m_min_time, m_samples);
+			for (size_t i = 0; i < m_results.size(); ++i)
+			{
+				const result_t& r = m_results[i];
+				fprintf(f, "    {\"name\": \"%s/%s\", \"run_type\": \"iteration\", \"iterations\": %llu, \"real_time\": %.3f, \"cpu_time\": %.3f, \"time_unit\": \"ns\", \"bytes_per_second\": %.1f}%s\n",
+					m_suite.c_str(), r.name.c_str(), (unsigned long long)r.iterations, r.ns_per_op, r.cpu_ns_per_op, r.bytes_per_second,
+					i + 1 < m_results.size() ? "," : "");
+			}
+			fprintf(f, "  ]\n}\n");
+			fclose(f);
+			return 0;
+		}
+
+	private:
+		// CPU time consumed by all threads of the process, in seconds
+		static double process_cpu_time()
+		{
+#ifdef _WIN32
+			FILETIME creation, exited, kernel, user;
+			if (!GetProcessTimes(GetCurrentProcess(), &creation, &exited, &kernel, &user))
+				return 0.0;
+			ULARGE_INTEGER k, u;
+			k.LowPart = kernel.dwLowDateTime;
+			k.HighPart = kernel.dwHighDateTime;
+			u.LowPart = user.dwLowDateTime;
+			u.HighPart = user.dwHighDateTime;
+			return (double)(k.QuadPart + u.QuadPart) * 1e-7;
+#else
+			struct timespec ts;
+			if (clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts) != 0)
+				return 0.0;
+			return (double)ts.tv_sec + ts.tv_nsec * 1e-9;
+#endif
+		}
+
+		// Returns the wall time of the batch; cpu receives its process CPU time
+		template <class F>
+		static double time_batch(F& fn, uint64_t iterations, double& cpu)
+		{
+			double cpu_start = process_cpu_time();
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			for (uint64_t i = 0; i < iterations; ++i)
+				fn();
+			double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+			cpu = process_cpu_time() - cpu_start;
+			return elapsed;
+		}
+
+		std::string m_suite;
+		std::string m_json;
+		std::string m_filter;
+		double m_min_time;
+		int m_samples;
+		std::vector<result_t> m_results;
+	};
+}
+
+#endif // _BENCH_COMMON_HPP_INCLUDED_
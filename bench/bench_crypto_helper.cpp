@@ -0,0 +1,39 @@
+/*
+* Author: LowBoyTeam (https://github.com/LowBoyTeam)
+* License: Code Project Open License
+* Disclaimer: The software is provided "as-is". No claim of suitability, guarantee, or any warranty whatsoever is provided.
+* Copyright (c) 2016-2017.
+*/
+
+#include "bench_common.hpp"
+#include "crypto_helper.hpp"
+
+template <ALG_ID algorithm>
+static void run_hash(bench::runner_t& runner, const char* name, const std::string& data)
+{
+	const std::string n = std::to_string(data.size());
+	runner.run(std::string(name) + "/" + n, data.size(), [&] {
+		crypto::cryptohash_t<algorithm> hash;
+		hash.begin();
+		hash.update((unsigned char*)data.data(), data.size());
+		hash.finalize();
+		bench::do_not_optimize(hash.digest());
+	});
+}
+
+int main(int argc, char** argv)
+{
+	bench::runner_t runner(argc, argv, "crypto_helper");
+	const size_t sizes[] = { 64, 1024, 64 * 1024, 1 << 20 };
+
+	for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); ++i)
+	{
+		const std::string data = bench::random_bytes(sizes[i], sizes[i]);
+		run_hash<CALG_MD5>(runner, "md5", data);
+		run_hash<CALG_SHA1>(runner, "sha1", data);
+		run_hash<CALG_SHA_256>(runner, "sha256", data);
+		run_hash<CALG_SHA_512>(runner, "sha512", data);
+	}
+
+	return runner.finish();
+}
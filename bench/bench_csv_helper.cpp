@@ -0,0 +1,61 @@
+/*
+* Author: LowBoyTeam (https://github.com/LowBoyTeam)
+* License: Code Project Open License
+* Disclaimer: The software is provided "as-is". No claim of suitability, guarantee, or any warranty whatsoever is provided.
+* Copyright (c) 2016-2017.
+*/
+
+#include "bench_common.hpp"
+#include "string_helper.hpp"
+#include "csv_helper.hpp"
+
+int main(int argc, char** argv)
+{
+	bench::runner_t runner(argc, argv, "csv_helper");
+
+	// About 64 MB of records; every eighth field is quoted and a few hold ""
+	bench::random_t rng(40);
+	std::string csv;
+	while (csv.size() < 64 * 1024 * 1024) {
+		for (size_t f = 0; f < 8; ++f) {
+			if (f)
+				csv += ',';
+			if (f == 3)
+				csv += rng.below(16) ? "\"Doe, Jane\"" : "\"say \"\"hi\"\"\"";
+			else
+				csv += bench::random_text(1 + rng.below(12), "abcdefghijklmnopqrstuvwxyz0123456789", csv.size());
+		}
+		csv += '\n';
+	}
+
+	// The current approach: one string per line, split into strings (ignores quoting)
+	runner.run("getline_split", csv.size(), [&] {
+		size_t fields = 0, pos = 0;
+		while (pos < csv.size()) {
+			size_t end = csv.find('\n', pos);
+			if (end == std::string::npos)
+				end = csv.size();
+			fields += string_helper::split(csv.substr(pos, end - pos), ",").size();
+			pos = end + 1;
+		}
+		bench::do_not_optimize(fields);
+	});
+
+	runner.run("reader/serial", csv.size(), [&] {
+		csv_helper::reader_t reader;
+		reader.parse(csv);
+		size_t fields = 0;
+		reader.for_each_row([&fields](const csv_helper::row_t& row) { fields += row.size(); });
+		bench::do_not_optimize(fields);
+	});
+
+	runner.run("reader/parallel", csv.size(), [&] {
+		csv_helper::reader_t reader;
+		reader.parse(csv, 0);
+		std::vector<size_t> fields(std::thread::hardware_concurrency() + 1, 0);
+		reader.for_each_row([&fields](const csv_helper::row_t& row, unsigned thread) { fields[thread] += row.size(); }, 0);
+		bench::do_not_optimize(fields);
+	});
+
+	return runner.finish();
+}
@@ -0,0 +1,116 @@
+/*
+* Author: LowBoyTeam (https://github.com/LowBoyTeam)
+* License: Code Project Open License
+* Disclaimer: The software is provided "as-is". No claim of suitability, guarantee, or any warranty whatsoever is provided.
+* Copyright (c) 2016-2017.
+*/
+
+#include "bench_common.hpp"
+#include "diskusage_helper.hpp"
+
+#include <string>
+
+// Builds root/dir0/dir1/... with fanout subdirectories per level and
+// files_per_dir small files in every directory. Returns the number of entries.
+static size_t make_tree(const std::wstring& root, int depth, int fanout, int files_per_dir)
+{
+	size_t created = 0;
+	::CreateDirectoryW(root.c_str(), NULL);
+	for (int f = 0; f < files_per_dir; ++f)
+	{
+		std::wstring file = root + L"\\file" + std::to_wstring(f) + L".dat";
+		HANDLE h = ::CreateFileW(file.c_str(), GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+		if (h != INVALID_HANDLE_VALUE)
+		{
+			DWORD dwWritten;
+			::WriteFile(h, file.c_str(), (DWORD)(file.size() * sizeof(WCHAR)), &dwWritten, NULL);
+			::CloseHandle(h);
+			++created;
+		}
+	}
+	if (depth > 0)
+	{
+		for (int d = 0; d < fanout; ++d)
+			created += 1 + make_tree(root + L"\\dir" + std::to_wstring(d), depth - 1, fanout, files_per_dir);
+	}
+	return created;
+}
+
+static void remove_tree(const std::wstring& root)
+{
+	filefinder_helper finder;
+	BOOL bFound = finder.FindFile((root + L"\\*").c_str());
+	while (bFound)
+	{
+		if (!finder.IsDots())
+		{
+			std::wstring path = root + L"\\" + finder.m_fd.cFileName;
+			if (finder.IsDirectory())
+				remove_tree(path);
+			else
+				::DeleteFileW(path.c_str());
+		}
+		bFound = finder.FindNextFile();
+	}
+	finder.Close();
+	::RemoveDirectoryW(root.c_str());
+}
+
+// The straightforward version: recursive FindFirstFile, sizes only
+static uint64_t total_size(const std::wstring& root)
+{
+	uint64_t size = 0;
+	filefinder_helper finder;
+	BOOL bFound = finder.FindFile((root + L"\\*").c_str());
+	while (bFound)
+	{
+		if (!finder.IsDots())
+		{
+			if (finder.IsDirectory())
+				size += total_size(root + L"\\" + finder.m_fd.cFileName);
+			else
+				size += ((uint64_t)finder.m_fd.nFileSizeHigh << 32) | finder.m_fd.nFileSizeLow;
+		}
+		bFound = finder.FindNextFile();
+	}
+	return size;
+}
+
+int main(int argc, char** argv)
+{
+	bench::runner_t runner(argc, argv, "diskusage_helper");
+
+	WCHAR szTemp[MAX_PATH];
+	::GetTempPathW(MAX_PATH, szTemp);
+
+	// depth, fanout, files per directory
+	const int shapes[][3] = { { 3, 4, 16 }, { 2, 16, 64 }, { 4, 6, 8 } };
+	for (size_t i = 0; i < sizeof(shapes) / sizeof(shapes[0]); ++i)
+	{
+		std::wstring root = std::wstring(szTemp) + L"cpp_utils_bench_du_" + std::to_wstring(i);
+		remove_tree(root);
+		const std::string entries = std::to_string(make_tree(root, shapes[i][0], shapes[i][1], shapes[i][2]));
+
+		runner.run("filefinder/" + entries, 0, [&] {
+			bench::do_not_optimize(total_size(root));
+		});
+
+		runner.run("scanner/1t/" + entries, 0, [&] {
+			diskusage_helper::scanner_t scan;
+			scan.start(root.c_str(), 1);
+			scan.wait();
+			bench::do_not_optimize(scan.totals().size);
+		});
+
+		runner.run("scanner/nt/" + entries, 0, [&] {
+			diskusage_helper::scanner_t scan;
+			scan.start(root.c_str());
+			scan.wait();
+			bench::do_not_optimize(scan.top(10).size());
+		});
+
+		remove_tree(root);
+	}
+
+	return runner.finish();
+}
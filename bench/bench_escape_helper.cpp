@@ -0,0 +1,78 @@
+/*
+* Author: LowBoyTeam (https://github.com/LowBoyTeam)
+* License: Code Project Open License
+* Disclaimer: The software is provided "as-is". No claim of suitability, guarantee, or any warranty whatsoever is provided.
+* Copyright (c) 2016-2017.
+*/
+
+#include "bench_common.hpp"
+#include "escape_helper.hpp"
+#include "string_helper.hpp"
+
+// What escape_helper replaces: one full pass and one allocation per character
+static std::string replace_chain(const std::string& s)
+{
+	std::string r = string_helper::replace(s, "\\", "\\\\");
+	r = string_helper::replace(r, "\"", "\\\"");
+	r = string_helper::replace(r, "\n", "\\n");
+	r = string_helper::replace(r, "\r", "\\r");
+	r = string_helper::replace(r, "\t", "\\t");
+	return r;
+}
+
+int main(int argc, char** argv)
+{
+	bench::runner_t runner(argc, argv, "escape_helper");
+	const size_t sizes[] = { 64, 4096, 1 << 20 };
+
+	// "clean" needs no escaping, "log" has a quote or newline every few dozen
+	// bytes, "dense" is mostly escapes
+	const std::string clean_alphabet = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789 .,:;=/-_";
+	const std::string log_alphabet = clean_alphabet + clean_alphabet + clean_alphabet + "\"\n";
+	const std::string dense_alphabet = "\"\\\n\t\x01a";
+
+	for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); ++i)
+	{
+		const std::string n = std::to_string(sizes[i]);
+		const std::string clean = bench::random_text(sizes[i], clean_alphabet, sizes[i]);
+		const std::string log = bench::random_text(sizes[i], log_alphabet, sizes[i]);
+		const std::string dense = bench::random_text(sizes[i], dense_alphabet, sizes[i]);
+		const std::string log_escaped = escape_helper::escape(log);
+		const std::string dense_escaped = escape_helper::escape(dense);
+		std::string out;
+		out.reserve(escape_helper::max_escaped_length(sizes[i]));
+
+		runner.run("escape/clean/" + n, clean.size(), [&] {
+			out.clear();
+			bench::do_not_optimize(escape_helper::escape(clean, out));
+		});
+		runner.run("escape_if_needed/clean/" + n, clean.size(), [&] {
+			bench::do_not_optimize(escape_helper::escape_if_needed(clean, out));
+		});
+		runner.run("escape/log/" + n, log.size(), [&] {
+			out.clear();
+			bench::do_not_optimize(escape_helper::escape(log, out));
+		});
+		runner.run("escape/dense/" + n, dense.size(), [&] {
+			out.clear();
+			bench::do_not_optimize(escape_helper::escape(dense, out));
+		});
+		runner.run("escape_c/log/" + n, log.size(), [&] {
+			out.clear();
+			bench::do_not_optimize(escape_helper::escape<escape_helper::c_mode>(log, out));
+		});
+		runner.run("replace_chain/log/" + n, log.size(), [&] {
+			bench::do_not_optimize(replace_chain(log));
+		});
+		runner.run("unescape/log/" + n, log_escaped.size(), [&] {
+			out.clear();
+			bench::do_not_optimize(escape_helper::unescape(log_escaped, out));
+		});
+		runner.run("unescape/dense/" + n, dense_escaped.size(), [&] {
+			out.clear();
+			bench::do_not_optimize(escape_helper::unescape(dense_escaped, out));
+		});
+	}
+
+	return runner.finish();
+}
@@ -0,0 +1,98 @@
+/*
+* Author: LowBoyTeam (https://github.com/LowBoyTeam)
+* License: Code Project Open License
+* Disclaimer: The software is provided "as-is". No claim of suitability, guarantee, or any warranty whatsoever is provided.
+* Copyright (c) 2016-2017.
+*/
+
+#include "bench_common.hpp"
+#include "filefinder_helper.hpp"
+
+#include <string>
+
+// Builds root/d0/d1/... with fanout subdirectories per level and files_per_dir
+// empty files in every directory. Returns the number of entries created.
+static size_t make_tree(const std::wstring& root, int depth, int fanout, int files_per_dir)
+{
+	size_t created = 0;
+	::CreateDirectoryW(root.c_str(), NULL);
+	for (int f = 0; f < files_per_dir; ++f)
+	{
+		std::wstring file = root + L"\\file" + std::to_wstring(f) + L".dat";
+		HANDLE h = ::CreateFileW(file.c_str(), GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+		if (h != INVALID_HANDLE_VALUE)
+		{
+			::CloseHandle(h);
+			++created;
+		}
+	}
+	if (depth > 0)
+	{
+		for (int d = 0; d < fanout; ++d)
+			created += 1 + make_tree(root + L"\\dir" + std::to_wstring(d), depth - 1, fanout, files_per_dir);
+	}
+	return created;
+}
+
+static void remove_tree(const std::wstring& root)
+{
+	filefinder_helper finder;
+	BOOL bFound = finder.FindFile((root + L"\\*").c_str());
+	while (bFound)
+	{
+		if (!finder.IsDots())
+		{
+			std::wstring path = root + L"\\" + finder.m_fd.cFileName;
+			if (finder.IsDirectory())
+				remove_tree(path);
+			else
+				::DeleteFileW(path.c_str());
+		}
+		bFound = finder.FindNextFile();
+	}
+	finder.Close();
+	::RemoveDirectoryW(root.c_str());
+}
+
+static size_t enumerate(const std::wstring& root)
+{
+	size_t count = 0;
+	filefinder_helper finder;
+	BOOL bFound = finder.FindFile((root + L"\\*").c_str());
+	while (bFound)
+	{
+		if (!finder.IsDots())
+		{
+			++count;
+			if (finder.IsDirectory())
+				count += enumerate(root + L"\\" + finder.m_fd.cFileName);
+		}
+		bFound = finder.FindNextFile();
+	}
+	return count;
+}
+
+int main(int argc, char** argv)
+{
+	bench::runner_t runner(argc, argv, "filefinder_helper");
+
+	WCHAR szTemp[MAX_PATH];
+	::GetTempPathW(MAX_PATH, szTemp);
+
+	// depth, fanout, files per directory
+	const int shapes[][3] = { { 1, 4, 16 }, { 3, 4, 16 }, { 2, 16, 64 } };
+	for (size_t i = 0; i < sizeof(shapes) / sizeof(shapes[0]); ++i)
+	{
+		std::wstring root = std::wstring(szTemp) + L"cpp_utils_bench_" + std::to_wstring(i);
+		remove_tree(root);
+		size_t entries = make_tree(root, shapes[i][0], shapes[i][1], shapes[i][2]);
+
+		runner.run("enumerate/" + std::to_string(entries), 0, [&] {
+			bench::do_not_optimize(enumerate(root));
+		});
+
+		remove_tree(root);
+	}
+
+	return runner.finish();
+}
@@ -0,0 +1,56 @@
+/*
+* Author: LowBoyTeam (https://github.com/LowBoyTeam)
+* License: Code Project Open License
+* Disclaimer: The software is provided "as-is". No claim of suitability, guarantee, or any warranty whatsoever is provided.
+* Copyright (c) 2016-2017.
+*/
+
+#include "bench_common.hpp"
+#include "string_helper.hpp"
+#include "intern_helper.hpp"
+
+int main(int argc, char** argv)
+{
+	bench::runner_t runner(argc, argv, "intern_helper");
+
+	// Log-like lines: a few hosts, methods and status codes repeated over and over
+	const char* hosts[] = { "api.example.com", "cdn.example.com", "auth.example.com", "www.example.com" };
+	const char* methods[] = { "GET", "POST", "PUT", "DELETE" };
+	const char* status[] = { "200", "204", "301", "404", "500" };
+	bench::random_t rng(7);
+	std::string log;
+	for (int i = 0; i < 1024; ++i)
+	{
+		log += hosts[rng.below(4)];
+		log += ' ';
+		log += methods[rng.below(4)];
+		log += ' ';
+		log += status[rng.below(5)];
+		log += ' ';
+	}
+
+	runner.run("split/strings", log.size(), [&] {
+		bench::do_not_optimize(string_helper::split(log, " "));
+	});
+
+	intern_helper::intern_table_t table;
+	std::vector<uint32_t> ids;
+	runner.run("split_interned/ids", log.size(), [&] {
+		ids.clear();
+		intern_helper::split_interned(table, log, " ", ids);
+		bench::do_not_optimize(ids);
+	});
+
+	std::vector<std::string_view> views;
+	runner.run("split_interned/views", log.size(), [&] {
+		views.clear();
+		intern_helper::split_interned(table, log, " ", views);
+		bench::do_not_optimize(views);
+	});
+
+	runner.run("find/hit", 3, [&] {
+		bench::do_not_optimize(table.find("GET"));
+	});
+
+	return runner.finish();
+}
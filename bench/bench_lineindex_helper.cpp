@@ -0,0 +1,75 @@
+/*
+* Author: LowBoyTeam (https://github.com/LowBoyTeam)
+* License: Code Project Open License
+* Disclaimer: The software is provided "as-is". No claim of suitability, guarantee, or any warranty whatsoever is provided.
+* Copyright (c) 2016-2017.
+*/
+
+#include "bench_common.hpp"
+#include "lineindex_helper.hpp"
+
+int main(int argc, char** argv)
+{
+	bench::runner_t runner(argc, argv, "lineindex_helper");
+	const size_t sizes[] = { 1 << 20, 64 << 20 };
+
+	for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); ++s)
+	{
+		const std::string n = std::to_string(sizes[s]);
+
+		// Log-like text, about 40 bytes per line
+		const std::string data = bench::random_text(sizes[s], "abcdefghijklmnopqrstuvwxyz0123456789 :=[]\n", sizes[s]);
+
+		// Every line start in a vector, the usual way to get random access
+		runner.run("offsets_vector/" + n, data.size(), [&] {
+			std::vector<uint64_t> starts(1, 0);
+			for (size_t i = 0; i < data.size(); ++i)
+				if (data[i] == '\n')
+					starts.push_back(i + 1);
+			bench::do_not_optimize(starts);
+		});
+		runner.run("build/" + n, data.size(), [&] {
+			lineindex_helper::line_index_t index;
+			index.build(data);
+			bench::do_not_optimize(index.lines());
+		});
+		runner.run("build/threads/" + n, data.size(), [&] {
+			lineindex_helper::line_index_t index;
+			index.build(data, 0);
+			bench::do_not_optimize(index.lines());
+		});
+
+		// Appending 1% to an indexed buffer
+		const std::string_view base(data.data(), data.size() - data.size() / 100);
+		lineindex_helper::line_index_t indexed;
+		indexed.build(base);
+		runner.run("extend_1pct/" + n, data.size() / 100, [&] {
+			lineindex_helper::line_index_t index = indexed;
+			index.extend(data);
+			bench::do_not_optimize(index.lines());
+		});
+
+		lineindex_helper::line_index_t index;
+		index.build(data);
+		std::string sidecar;
+		index.save(sidecar);
+		runner.run("load/" + n, sidecar.size(), [&] {
+			lineindex_helper::line_index_t loaded;
+			bench::do_not_optimize(loaded.load(sidecar));
+		});
+
+		// 1000 random lines
+		bench::random_t rng(sizes[s]);
+		std::vector<uint64_t> picks(1000);
+		for (size_t i = 0; i < picks.size(); ++i)
+			picks[i] = rng.below(index.lines());
+		runner.run("line_x1000/" + n, 1000, [&] {
+			size_t total = 0;
+			for (size_t i = 0; i < picks.size(); ++i)
+				total += index.line(data, picks[i]).size();
+			bench::do_not_optimize(total);
+		});
+	}
+
+	return runner.finish();
+}
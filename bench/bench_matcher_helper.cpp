@@ -0,0 +1,51 @@
+/*
+* Author: LowBoyTeam (https://github.com/LowBoyTeam)
+* License: Code Project Open License
+* Disclaimer: The software is provided "as-is". No claim of suitability, guarantee, or any warranty whatsoever is provided.
+* Copyright (c) 2016-2017.
+*/
+
+#include "bench_common.hpp"
+#include "string_helper.hpp"
+#include "matcher_helper.hpp"
+
+int main(int argc, char** argv)
+{
+	bench::runner_t runner(argc, argv, "matcher_helper");
+	const size_t counts[] = { 16, 256, 1024 };
+
+	for (size_t i = 0; i < sizeof(counts) / sizeof(counts[0]); ++i)
+	{
+		const std::string n = std::to_string(counts[i]);
+
+		// Route-like prefixes and paths that mostly hit one of them
+		bench::random_t rng(counts[i]);
+		std::vector<std::string> prefixes;
+		for (size_t k = 0; k < counts[i]; ++k)
+			prefixes.push_back("/" + bench::random_text(2 + rng.below(6), "abcdefghijklmnop", k) + "/");
+		std::vector<std::string> paths;
+		for (size_t k = 0; k < 64; ++k)
+			paths.push_back(prefixes[rng.below(prefixes.size())] + bench::random_text(16, "abcdefghijklmnopqrstuvwxyz/", k));
+		size_t bytes = 0;
+		for (size_t k = 0; k < paths.size(); ++k)
+			bytes += paths[k].size();
+
+		runner.run("is_start_with_loop/" + n, bytes, [&] {
+			size_t hits = 0;
+			for (size_t p = 0; p < paths.size(); ++p)
+				for (size_t k = 0; k < prefixes.size(); ++k)
+					hits += string_helper::is_start_with(paths[p], prefixes[k]);
+			bench::do_not_optimize(hits);
+		});
+
+		const matcher_helper::prefix_matcher_t matcher(prefixes);
+		runner.run("prefix_matcher/" + n, bytes, [&] {
+			size_t hits = 0;
+			for (size_t p = 0; p < paths.size(); ++p)
+				hits += matcher.longest(paths[p]) != matcher_helper::npos;
+			bench::do_not_optimize(hits);
+		});
+	}
+
+	return runner.finish();
+}
@@ -0,0 +1,96 @@
+/*
+* Author: LowBoyTeam (https://github.com/LowBoyTeam)
+* License: Code Project Open License
+* Disclaimer: The software is provided "as-is". No claim of suitability, guarantee, or any warranty whatsoever is provided.
+* Copyright (c) 2016-2017.
+*/
+
+#include "bench_common.hpp"
+#include "string_helper.hpp"
+#include "url_helper.hpp"
+
+#include <thread>
+#include <memory_resource>
+
+// A simulated request: split a header line, trim and uppercase every field,
+// rewrite one and url-encode the result. Every thread handles its share of
+// requests, so the std:: variant hammers the global heap from all threads at
+// once while the pmr variant works in a per-thread arena released per request.
+
+static const int kRequestsPerThread = 64;
+
+static size_t handle_heap(const std::string& line)
+{
+	size_t total = 0;
+	std::vector<std::string> fields = string_helper::split(line, ",");
+	for (size_t i = 0; i < fields.size(); ++i)
+		total += string_helper::Toupper(string_helper::trim(fields[i])).size();
+	std::string joined = string_helper::join(fields, ";");
+	total += url_helper::url_encode(string_helper::replace(joined, ";", " ")).size();
+	return total;
+}
+
+static size_t handle_pmr(const std::string& line, std::pmr::memory_resource* arena)
+{
+	size_t total = 0;
+	std::pmr::vector<std::pmr::string> fields = string_helper::pmr::split(line, ",", false, arena);
+	for (size_t i = 0; i < fields.size(); ++i)
+		total += string_helper::pmr::Toupper(string_helper::pmr::trim(fields[i], arena), arena).size();
+	std::pmr::string joined = string_helper::pmr::join(fields, ";", false, arena);
+	total += url_helper::pmr::url_encode(string_helper::pmr::replace(joined, ";", " ", arena), arena).size();
+	return total;
+}
+
+template <class F>
+static void run_threads(unsigned threads, F fn)
+{
+	std::vector<std::thread> pool;
+	for (unsigned t = 0; t < threads; ++t)
+		pool.emplace_back(fn);
+	for (size_t t = 0; t < pool.size(); ++t)
+		pool[t].join();
+}
+
+int main(int argc, char** argv)
+{
+	bench::runner_t runner(argc, argv, "pmr");
+	const std::string line = bench::random_tokens(64, 12, " , ", 64);
+
+	unsigned hw = std::thread::hardware_concurrency();
+	std::vector<unsigned> thread_counts;
+	for (unsigned t = 1; t <= (hw ? hw : 1); t *= 2)
+		thread_counts.push_back(t);
+	if (hw > 1 && thread_counts.back() != hw)
+		thread_counts.push_back(hw);
+
+	for (size_t i = 0; i < thread_counts.size(); ++i)
+	{
+		const unsigned threads = thread_counts[i];
+		const std::string n = std::to_string(threads);
+		const size_t bytes = line.size() * kRequestsPerThread * threads;
+
+		runner.run("request_heap/threads:" + n, bytes, [&] {
+			run_threads(threads, [&] {
+				size_t total = 0;
+				for (int r = 0; r < kRequestsPerThread; ++r)
+					total += handle_heap(line);
+				bench::do_not_optimize(total);
+			});
+		});
+
+		runner.run("request_arena/threads:" + n, bytes, [&] {
+			run_threads(threads, [&] {
+				char buffer[32768];
+				size_t total = 0;
+				for (int r = 0; r < kRequestsPerThread; ++r)
+				{
+					std::pmr::monotonic_buffer_resource arena(buffer, sizeof(buffer));
+					total += handle_pmr(line, &arena);
+				}
+				bench::do_not_optimize(total);
+			});
+		});
+	}
+
+	return runner.finish();
+}
@@ -0,0 +1,50 @@
+/*
+* Author: LowBoyTeam (https://github.com/LowBoyTeam)
+* License: Code Project Open License
+* Disclaimer: The software is provided "as-is". No claim of suitability, guarantee, or any warranty whatsoever is provided.
+* Copyright (c) 2016-2017.
+*/
+
+#include "bench_common.hpp"
+#include "query_helper.hpp"
+
+int main(int argc, char** argv)
+{
+	bench::runner_t runner(argc, argv, "query_helper");
+	const size_t counts[] = { 4, 32, 256 };
+
+	for (size_t i = 0; i < sizeof(counts) / sizeof(counts[0]); ++i)
+	{
+		const std::string n = std::to_string(counts[i]);
+		bench::random_t rng(counts[i]);
+		std::string query;
+		for (size_t k = 0; k < counts[i]; ++k)
+		{
+			if (k)
+				query += '&';
+			query += "key" + std::to_string(k) + "=" + bench::random_text(1 + rng.below(24), "abcdef0123456789%20+", k);
+		}
+
+		query_helper::query_t q;
+		runner.run("parse/" + n, query.size(), [&] {
+			q.clear();
+			q.parse(query);
+			bench::do_not_optimize(q.size());
+		});
+		runner.run("parse_get_all/" + n, query.size(), [&] {
+			q.clear();
+			q.parse(query);
+			for (size_t k = 0; k < q.size(); ++k)
+				bench::do_not_optimize(q.get(q.key(k)));
+		});
+		runner.run("feed/" + n, query.size(), [&] {
+			q.clear();
+			for (size_t k = 0; k < query.size(); k += 1024)
+				q.feed(std::string_view(query).substr(k, 1024));
+			q.finish();
+			bench::do_not_optimize(q.size());
+		});
+	}
+
+	return runner.finish();
+}
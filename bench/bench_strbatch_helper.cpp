@@ -0,0 +1,106 @@
+/*
+* Author: LowBoyTeam (https://github.com/LowBoyTeam)
+* License: Code Project Open License
+* Disclaimer: The software is provided "as-is". No claim of suitability, guarantee, or any warranty whatsoever is provided.
+* Copyright (c) 2016-2017.
+*/
+
+#include "bench_common.hpp"
+#include "strbatch_helper.hpp"
+#include "string_helper.hpp"
+
+int main(int argc, char** argv)
+{
+	bench::runner_t runner(argc, argv, "strbatch_helper");
+	const size_t counts[] = { 1000, 1000000 };
+
+	for (size_t c = 0; c < sizeof(counts) / sizeof(counts[0]); ++c)
+	{
+		const std::string n = std::to_string(counts[c]);
+
+		// Field values of 1..24 letters, some padded with spaces
+		bench::random_t rng(counts[c]);
+		std::vector<std::string> values(counts[c]);
+		size_t bytes = 0;
+		for (size_t i = 0; i < values.size(); ++i)
+		{
+			std::string& v = values[i];
+			if (rng.below(4) == 0)
+				v += "  ";
+			v += bench::random_text(1 + rng.below(24), "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ_/ ", rng.next());
+			if (rng.below(4) == 0)
+				v += " ";
+			bytes += v.size();
+		}
+		const strbatch_helper::batch_t batch = strbatch_helper::make_batch(values);
+
+		// One string_helper call, and one allocation, per value
+		runner.run("per_value/Tolower/" + n, bytes, [&] {
+			std::vector<std::string> out;
+			out.reserve(values.size());
+			for (size_t i = 0; i < values.size(); ++i)
+				out.push_back(string_helper::Tolower(values[i]));
+			bench::do_not_optimize(out);
+		});
+		runner.run("Tolower/" + n, bytes, [&] {
+			bench::do_not_optimize(strbatch_helper::Tolower(batch));
+		});
+		runner.run("Tolower/threads/" + n, bytes, [&] {
+			bench::do_not_optimize(strbatch_helper::Tolower(batch, 0));
+		});
+
+		runner.run("per_value/trim/" + n, bytes, [&] {
+			std::vector<std::string> out;
+			out.reserve(values.size());
+			for (size_t i = 0; i < values.size(); ++i)
+				out.push_back(string_helper::trim(values[i]));
+			bench::do_not_optimize(out);
+		});
+		runner.run("trim/" + n, bytes, [&] {
+			bench::do_not_optimize(strbatch_helper::trim(batch));
+		});
+		runner.run("trim/threads/" + n, bytes, [&] {
+			bench::do_not_optimize(strbatch_helper::trim(batch, 0));
+		});
+
+		runner.run("per_value/replace/" + n, bytes, [&] {
+			std::vector<std::string> out;
+			out.reserve(values.size());
+			for (size_t i = 0; i < values.size(); ++i)
+				out.push_back(string_helper::replace(values[i], "/", "::"));
+			bench::do_not_optimize(out);
+		});
+		runner.run("replace/" + n, bytes, [&] {
+			bench::do_not_optimize(strbatch_helper::replace(batch, "/", "::"));
+		});
+		runner.run("replace/threads/" + n, bytes, [&] {
+			bench::do_not_optimize(strbatch_helper::replace(batch, "/", "::", 0));
+		});
+
+		runner.run("per_value/split/" + n, bytes, [&] {
+			std::vector<std::vector<std::string> > out;
+			out.reserve(values.size());
+			for (size_t i = 0; i < values.size(); ++i)
+				out.push_back(string_helper::split(values[i], "/"));
+			bench::do_not_optimize(out);
+		});
+		runner.run("split/" + n, bytes, [&] {
+			bench::do_not_optimize(strbatch_helper::split(batch, "/"));
+		});
+		runner.run("split/threads/" + n, bytes, [&] {
+			bench::do_not_optimize(strbatch_helper::split(batch, "/", 0));
+		});
+
+		runner.run("url_encode/" + n, bytes, [&] {
+			bench::do_not_optimize(strbatch_helper::url_encode(batch));
+		});
+		runner.run("url_encode/threads/" + n, bytes, [&] {
+			bench::do_not_optimize(strbatch_helper::url_encode(batch, 0));
+		});
+		runner.run("is_start_with/" + n, bytes, [&] {
+			bench::do_not_optimize(strbatch_helper::is_start_with(batch, "ab"));
+		});
+	}
+
+	return runner.finish();
+}
@@ -0,0 +1,57 @@
+/*
+* Author: LowBoyTeam (https://github.com/LowBoyTeam)
+* License: Code Project Open License
+* Disclaimer: The software is provided "as-is". No claim of suitability, guarantee, or any warranty whatsoever is provided.
+* Copyright (c) 2016-2017.
+*/
+
+#include "bench_common.hpp"
+#include "string_helper.hpp"
+#include "strbuilder_helper.hpp"
+
+int main(int argc, char** argv)
+{
+	bench::runner_t runner(argc, argv, "strbuilder_helper");
+	const size_t counts[] = { 16, 1024, 65536 };
+
+	for (size_t i = 0; i < sizeof(counts) / sizeof(counts[0]); ++i)
+	{
+		const std::string n = std::to_string(counts[i]);
+		const std::string line = bench::random_tokens(counts[i], 12, ",", counts[i]);
+		const std::vector<std::string> tokens = string_helper::split(line, ",");
+		const size_t bytes = line.size() * 3;
+
+		// The pattern the builder replaces: helper results chained with +=
+		runner.run("concat_string/" + n, bytes, [&] {
+			std::string out;
+			out += string_helper::join(tokens, ";");
+			out += string_helper::replace(line, ",", ", ");
+			for (size_t k = 0; k < tokens.size(); ++k)
+			{
+				out += std::to_string(k);
+				out += ':';
+			}
+			bench::do_not_optimize(out);
+		});
+
+		runner.run("builder_str/" + n, bytes, [&] {
+			strbuilder_helper::builder_t b;
+			b.append_join(tokens, ";");
+			b.append_replace(line, ",", ", ");
+			for (size_t k = 0; k < tokens.size(); ++k)
+				b.append_number(k).append(':');
+			bench::do_not_optimize(b.str());
+		});
+
+		runner.run("builder_segments/" + n, bytes, [&] {
+			strbuilder_helper::builder_t b;
+			b.append_join(tokens, ";");
+			b.append_replace(line, ",", ", ");
+			for (size_t k = 0; k < tokens.size(); ++k)
+				b.append_number(k).append(':');
+			bench::do_not_optimize(b.segments());
+		});
+	}
+
+	return runner.finish();
+}
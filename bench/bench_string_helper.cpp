@@ -0,0 +1,101 @@
+/*
+* Author: LowBoyTeam (https://github.com/LowBoyTeam)
+* License: Code Project Open License
+* Disclaimer: The software is provided "as-is". No claim of suitability, guarantee, or any warranty whatsoever is provided.
+* Copyright (c) 2016-2017.
+*/
+
+#include "bench_common.hpp"
+#include "string_helper.hpp"
+
+int main(int argc, char** argv)
+{
+	bench::runner_t runner(argc, argv, "string_helper");
+	const size_t counts[] = { 16, 1024, 65536 };
+
+	for (size_t i = 0; i < sizeof(counts) / sizeof(counts[0]); ++i)
+	{
+		const std::string n = std::to_string(counts[i]);
+		const std::string line = bench::random_tokens(counts[i], 12, ",", counts[i]);
+		const std::vector<std::string> tokens = string_helper::split(line, ",");
+
+		runner.run("split/" + n, line.size(), [&] {
+			bench::do_not_optimize(string_helper::split(line, ","));
+		});
+		runner.run("join/" + n, line.size(), [&] {
+			bench::do_not_optimize(string_helper::join(tokens, ","));
+		});
+		runner.run("replace/" + n, line.size(), [&] {
+			bench::do_not_optimize(string_helper::replace(line, ",", ", "));
+		});
+
+		const std::string padded = std::string(counts[i] % 64, ' ') + line + std::string(counts[i] % 64, '\t');
+		runner.run("trim/" + n, padded.size(), [&] {
+			bench::do_not_optimize(string_helper::trim(padded));
+		});
+	}
+
+	// find_all / count over a large buffer, single-threaded and on every core
+	const std::string haystack = bench::random_text(16 << 20, "abcdefghijklmnopqrstuvwxyz \n");
+	runner.run("find_all/16M/threads:1", haystack.size(), [&] {
+		bench::do_not_optimize(string_helper::find_all(haystack, "abc", false, 1));
+	});
+	runner.run("find_all/16M/threads:all", haystack.size(), [&] {
+		bench::do_not_optimize(string_helper::find_all(haystack, "abc"));
+	});
+	runner.run("count/16M/threads:1", haystack.size(), [&] {
+		bench::do_not_optimize(string_helper::count(haystack, "\n", false, 1));
+	});
+	runner.run("count/16M/threads:all", haystack.size(), [&] {
+		bench::do_not_optimize(string_helper::count(haystack, "\n"));
+	});
+
+	// Numeric fields: std::stoll / std::stod / std::to_string against the view-based forms
+	bench::random_t rng(41);
+	std::vector<std::string> ints, doubles;
+	for (size_t k = 0; k < 4096; ++k) {
+		ints.push_back(std::to_string((long long)(rng.next() >> (rng.below(48) + 1))));
+		doubles.push_back(std::to_string((double)rng.below(1000000) / 1000.0));
+	}
+	size_t int_bytes = 0, double_bytes = 0;
+	for (size_t k = 0; k < ints.size(); ++k) {
+		int_bytes += ints[k].size();
+		double_bytes += doubles[k].size();
+	}
+	const std::vector<std::string_view> int_views(ints.begin(), ints.end());
+	const std::vector<std::string_view> double_views(doubles.begin(), doubles.end());
+	std::vector<int64_t> int_values(ints.size());
+	std::vector<double> double_values(doubles.size());
+
+	runner.run("stoll", int_bytes, [&] {
+		for (size_t k = 0; k < ints.size(); ++k)
+			int_values[k] = std::stoll(ints[k]);
+		bench::do_not_optimize(int_values);
+	});
+	runner.run("parse_int", int_bytes, [&] {
+		bench::do_not_optimize(string_helper::parse_int(int_views.data(), int_views.size(), int_values.data()));
+	});
+	runner.run("stod", double_bytes, [&] {
+		for (size_t k = 0; k < doubles.size(); ++k)
+			double_values[k] = std::stod(doubles[k]);
+		bench::do_not_optimize(double_values);
+	});
+	runner.run("parse_double", double_bytes, [&] {
+		bench::do_not_optimize(string_helper::parse_double(double_views.data(), double_views.size(), double_values.data()));
+	});
+	runner.run("to_string_join", int_bytes, [&] {
+		std::string out;
+		for (size_t k = 0; k < int_values.size(); ++k) {
+			if (k)
+				out += ',';
+			out += std::to_string(int_values[k]);
+		}
+		bench::do_not_optimize(out);
+	});
+	runner.run("append_number", int_bytes, [&] {
+		std::string out;
+		bench::do_not_optimize(string_helper::append_number(out, int_values.data(), int_values.size(), ","));
+	});
+
+	return runner.finish();
+}
@@ -0,0 +1,61 @@
+/*
+* Author: LowBoyTeam (https://github.com/LowBoyTeam)
+* License: Code Project Open License
+* Disclaimer: The software is provided "as-is". No claim of suitability, guarantee, or any warranty whatsoever is provided.
+* Copyright (c) 2016-2017.
+*/
+
+#include "bench_common.hpp"
+#include "textconv_helper.hpp"
+
+using namespace textconv_helper;
+
+int main(int argc, char** argv)
+{
+	bench::runner_t runner(argc, argv, "textconv_helper");
+	const size_t sizes[] = { 64, 4096, 1 << 20 };
+
+	// ASCII only, and a UTF-8 mix of 1- to 4-byte sequences
+	const char* utf8_samples[] = { "a", "\xC3\xA9", "\xE4\xB8\xAD", "\xF0\x9F\x98\x80" };
+
+	for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); ++i)
+	{
+		const std::string n = std::to_string(sizes[i]);
+		const std::string ascii = bench::random_text(sizes[i], "abcdefghijklmnopqrstuvwxyz0123456789 ", sizes[i]);
+
+		bench::random_t rng(sizes[i]);
+		std::string mixed;
+		while (mixed.size() < sizes[i])
+			mixed += utf8_samples[rng.below(4)];
+
+		const std::wstring wide(CA2W(mixed.c_str(), CP_UTF8));
+
+		runner.run("A2W/ascii/" + n, ascii.size(), [&] {
+			CA2W w(ascii.c_str(), CP_UTF8);
+			bench::do_not_optimize((LPCWSTR)w);
+		});
+		runner.run("A2W/utf8/" + n, mixed.size(), [&] {
+			CA2W w(mixed.c_str(), CP_UTF8);
+			bench::do_not_optimize((LPCWSTR)w);
+		});
+		runner.run("W2A/utf8/" + n, wide.size() * sizeof(wchar_t), [&] {
+			CW2A a(wide.c_str(), CP_UTF8);
+			bench::do_not_optimize((LPCSTR)a);
+		});
+
+		std::vector<BYTE> out(64 * 1024);
+		runner.run("StreamConv/utf8_to_utf16/" + n, mixed.size(), [&] {
+			CStreamConv conv(CP_UTF8, CP_WINUNICODE);
+			size_t done = 0;
+			while (done < mixed.size())
+			{
+				size_t cbRead = 0, cbWritten = 0;
+				conv.Convert(mixed.data() + done, mixed.size() - done, &cbRead, &out[0], out.size(), &cbWritten);
+				done += cbRead;
+			}
+			bench::do_not_optimize(out);
+		});
+	}
+
+	return runner.finish();
+}
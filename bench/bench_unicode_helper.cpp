@@ -0,0 +1,102 @@
+/*
+* Author: LowBoyTeam (https://github.com/LowBoyTeam)
+* License: Code Project Open License
+* Disclaimer: The software is provided "as-is". No claim of suitability, guarantee, or any warranty whatsoever is provided.
+* Copyright (c) 2016-2017.
+*/
+
+#include "bench_common.hpp"
+#include "string_helper.hpp"
+#include "unicode_helper.hpp"
+
+// Words drawn from a list of UTF-8 words, joined by spaces, up to size bytes
+static std::string random_words(size_t size, const char* const* words, size_t count, uint64_t seed)
+{
+	bench::random_t rng(seed);
+	std::string s;
+	while (s.size() < size)
+	{
+		s += words[rng.below(count)];
+		s += ' ';
+	}
+	return s;
+}
+
+int main(int argc, char** argv)
+{
+	bench::runner_t runner(argc, argv, "unicode_helper");
+	const size_t size = 64 * 1024;
+
+	static const char* const ascii[] = { "The", "quick", "brown", "fox", "jumps", "over", "the", "lazy", "dog", "User_Name", "ID" };
+	static const char* const latin[] = { "\xC3\xA9t\xC3\xA9", "Stra\xC3\x9F" "e", "\xC3\x87" "a", "na\xC3\xAFve", "Ol\xC3\xA1", "Z\xC3\xBCrich", "fa\xC3\xA7" "ade", "Paris" };
+	static const char* const decomposed[] = { "e\xCC\x81t" "e\xCC\x81", "C\xCC\xA7" "a", "nai\xCC\x88ve", "Ola\xCC\x81", "Zu\xCC\x88rich", "Paris" };
+	static const char* const cjk[] = { "\xE4\xB8\xAD\xE6\x96\x87", "\xE6\x97\xA5\xE6\x9C\xAC\xE8\xAA\x9E", "\xED\x95\x9C\xEA\xB5\xAD\xEC\x96\xB4", "\xD0\x9F\xD1\x80\xD0\xB8\xD0\xB2\xD0\xB5\xD1\x82" };
+
+	struct input_t
+	{
+		const char* name;
+		std::string text;
+	};
+	const input_t inputs[] = {
+		{ "ascii", random_words(size, ascii, sizeof(ascii) / sizeof(ascii[0]), 1) },
+		{ "latin", random_words(size, latin, sizeof(latin) / sizeof(latin[0]), 2) },
+		{ "decomposed", random_words(size, decomposed, sizeof(decomposed) / sizeof(decomposed[0]), 3) },
+		{ "cjk", random_words(size, cjk, sizeof(cjk) / sizeof(cjk[0]), 4) },
+	};
+
+	for (size_t i = 0; i < sizeof(inputs) / sizeof(inputs[0]); ++i)
+	{
+		const std::string& text = inputs[i].text;
+		const std::string n = inputs[i].name;
+		std::string out;
+		out.reserve(text.size() * 2);
+
+		// The floor: a plain copy of the same bytes
+		runner.run("copy/" + n, text.size(), [&] {
+			out.assign(text);
+			bench::do_not_optimize(out);
+		});
+
+		// is_nfc stops at the first code point that is not NFC, so only time
+		// it on inputs it has to read to the end
+		if (unicode_helper::is_nfc(text))
+		{
+			runner.run("is_nfc/" + n, text.size(), [&] {
+				bench::do_not_optimize(unicode_helper::is_nfc(text));
+			});
+		}
+
+		runner.run("normalize/" + n, text.size(), [&] {
+			out.clear();
+			unicode_helper::normalize(text, out);
+			bench::do_not_optimize(out);
+		});
+
+		runner.run("casefold/" + n, text.size(), [&] {
+			out.clear();
+			unicode_helper::casefold(text, out);
+			bench::do_not_optimize(out);
+		});
+
+		runner.run("fold_key/" + n, text.size(), [&] {
+			out.clear();
+			unicode_helper::fold_key(text, out);
+			bench::do_not_optimize(out);
+		});
+	}
+
+	// The path being replaced: per-unit C tolower on a wide string
+	std::wstring wide;
+	for (size_t i = 0; i < inputs[0].text.size(); ++i)
+		wide += (wchar_t)inputs[0].text[i];
+	runner.run("Tolower/wstring", wide.size() * sizeof(wchar_t), [&] {
+		bench::do_not_optimize(string_helper::Tolower(wide));
+	});
+	runner.run("casefold/wstring", wide.size() * sizeof(wchar_t), [&] {
+		std::wstring out;
+		unicode_helper::casefold(wide, out);
+		bench::do_not_optimize(out);
+	});
+
+	return runner.finish();
+}
@@ -0,0 +1,56 @@
+/*
+* Author: LowBoyTeam (https://github.com/LowBoyTeam)
+* License: Code Project Open License
+* Disclaimer: The software is provided "as-is". No claim of suitability, guarantee, or any warranty whatsoever is provided.
+* Copyright (c) 2016-2017.
+*/
+
+#include "bench_common.hpp"
+#include "uri_helper.hpp"
+
+int main(int argc, char** argv)
+{
+	bench::runner_t runner(argc, argv, "uri_helper");
+
+	// A fixed mix of the shapes a routing layer sees
+	std::vector<std::string> urls;
+	bench::random_t rng(42);
+	const char* hosts[] = { "example.com", "API.Example.COM:8080", "user:pw@[2001:db8::1]:443", "cdn.example.net:80" };
+	for (size_t i = 0; i < 1024; ++i)
+	{
+		std::string url = (i & 1) ? "HTTPS://" : "http://";
+		url += hosts[rng.below(4)];
+		url += "/" + bench::random_text(1 + rng.below(8), "abcxyz", i) + "/./" + bench::random_text(1 + rng.below(8), "abc%7E", i + 1) + "/../v1/items";
+		if (i % 3)
+			url += "?id=" + std::to_string(rng.below(100000)) + "&q=" + bench::random_text(rng.below(16), "abc%2F+", i);
+		if (i % 7 == 0)
+			url += "#section";
+		urls.push_back(url);
+	}
+	size_t total = 0;
+	for (size_t i = 0; i < urls.size(); ++i)
+		total += urls[i].size();
+
+	runner.run("parse/1024", total, [&] {
+		uri_helper::uri_t u;
+		for (size_t i = 0; i < urls.size(); ++i)
+		{
+			uri_helper::parse(urls[i], u);
+			bench::do_not_optimize(u);
+		}
+	});
+
+	std::vector<std::string> scratch(urls.size());
+	for (size_t i = 0; i < urls.size(); ++i)
+		scratch[i].reserve(urls[i].size() + 1);
+	runner.run("normalize/1024", total, [&] {
+		for (size_t i = 0; i < urls.size(); ++i)
+		{
+			scratch[i].assign(urls[i]);
+			uri_helper::normalize(scratch[i]);
+			bench::do_not_optimize(scratch[i]);
+		}
+	});
+
+	return runner.finish();
+}
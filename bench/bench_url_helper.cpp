@@ -0,0 +1,50 @@
+/*
+* Author: LowBoyTeam (https://github.com/LowBoyTeam)
+* License: Code Project Open License
+* Disclaimer: The software is provided "as-is". No claim of suitability, guarantee, or any warranty whatsoever is provided.
+* Copyright (c) 2016-2017.
+*/
+
+#include "bench_common.hpp"
+#include "url_helper.hpp"
+
+int main(int argc, char** argv)
+{
+	bench::runner_t runner(argc, argv, "url_helper");
+	const size_t sizes[] = { 16, 256, 4096, 1 << 20 };
+
+	// "plain" is typical query text (few escapes), "dense" is mostly escaped
+	const std::string plain_alphabet = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789-_. /=&";
+	const std::string dense_alphabet = "a /?#[]@!$&'()*+,;=%\"<>";
+
+	for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); ++i)
+	{
+		const std::string n = std::to_string(sizes[i]);
+		const std::string plain = bench::random_text(sizes[i], plain_alphabet, sizes[i]);
+		const std::string dense = bench::random_text(sizes[i], dense_alphabet, sizes[i]);
+		const std::string binary = bench::random_bytes(sizes[i], sizes[i]);
+		const std::string plain_encoded = url_helper::url_encode(plain);
+		const std::string binary_encoded = url_helper::url_encode(binary);
+
+		runner.run("encode/plain/" + n, plain.size(), [&] {
+			bench::do_not_optimize(url_helper::url_encode(plain));
+		});
+		runner.run("encode/dense/" + n, dense.size(), [&] {
+			bench::do_not_optimize(url_helper::url_encode(dense));
+		});
+		runner.run("encode/binary/" + n, binary.size(), [&] {
+			bench::do_not_optimize(url_helper::url_encode(binary));
+		});
+		runner.run("encode_raw/plain/" + n, plain.size(), [&] {
+			bench::do_not_optimize(url_helper::url_encode<url_helper::raw_mode>(plain));
+		});
+		runner.run("decode/plain/" + n, plain_encoded.size(), [&] {
+			bench::do_not_optimize(url_helper::url_decode(plain_encoded));
+		});
+		runner.run("decode/binary/" + n, binary_encoded.size(), [&] {
+			bench::do_not_optimize(url_helper::url_decode(binary_encoded));
+		});
+	}
+
+	return runner.finish();
+}
@@ -0,0 +1,363 @@
+/*
+* Author: LowBoyTeam (https://github.com/LowBoyTeam)
+* License: Code Project Open License
+* Disclaimer: The software is provided "as-is". No claim of suitability, guarantee, or any warranty whatsoever is provided.
+* Copyright (c) 2016-2017.
+*/
+
+#ifndef _CDC_HELPER_HPP_INCLUDED_
+#define _CDC_HELPER_HPP_INCLUDED_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef _WIN32
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "crypto_helper.hpp"
+#include "mmap_helper.hpp"
+#endif
+
+////////////////////////////////////////////////////////
+// Content-defined chunking (FastCDC)
+//
+//  chunker_t cuts data into variable-size chunks whose boundaries depend on
+//  the content rather than on offsets. An insertion or deletion therefore
+//  only changes the chunks around it; the rest of a file keeps the same
+//  chunks and digests, which is what backup and sync tools compare.
+//
+//  A cut is placed where a gear hash of the last 64 bytes has its top bits
+//  clear. Hashing starts only min bytes into a chunk. Up to avg bytes a
+//  stricter mask is used, and after that a looser one, which bunches chunk
+//  sizes around avg ("normalized chunking"). No chunk is longer than max.
+//  The mask widths come from avg rounded down to a power of two, but the
+//  switch between them happens at avg itself, which avg_size() returns.
+//
+//  The gear table is generated from a fixed seed. Chunk boundaries are part
+//  of the on-disk format of anything built on this, so the table, the masks
+//  and the cut rule must never change.
+//
+//  On Windows, file_chunker_t maps a file and emits (offset, length, digest)
+//  for every chunk. One thread finds the cuts and the hash workers digest
+//  chunks as soon as they are cut. Chunks are handed to the callback in
+//  file order on the calling thread.
+//
+//  Usage:
+//    cdc_helper::chunker_t chunker(cdc_helper::params_t(4096, 16384, 65536));
+//    chunker.split(data, size, [](uint64_t offset, size_t length) { ... });
+//
+//    cdc_helper::file_chunker_t<CALG_SHA_256> files;
+//    files.run(L"D:\\backup\\disk.vhdx", [&](const cdc_helper::chunk_t& c) {
+//        index.add(c.offset, c.length, c.digest);
+//    });
+
+namespace cdc_helper
+{
+	struct params_t
+	{
+		size_t min;
+		size_t avg;
+		size_t max;
+		unsigned normalization;		// mask bits added before avg and removed after it, 0 to 3
+
+		params_t(size_t min_size = 2048, size_t avg_size = 8192, size_t max_size = 65536, unsigned level = 2)
+			: min(min_size), avg(avg_size), max(max_size), normalization(level)
+		{
+		}
+	};
+
+	namespace detail
+	{
+		struct gear_table_t
+		{
+			uint64_t value[256];
+		};
+
+		// splitmix64 from a fixed seed; see the note on compatibility above
+		constexpr gear_table_t make_gear_table()
+		{
+			gear_table_t t = {};
+			uint64_t state = 0x6A09E667F3BCC908ULL;
+			for (int i = 0; i < 256; ++i) {
+				uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+				z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+				z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+				t.value[i] = z ^ (z >> 31);
+			}
+			return t;
+		}
+
+		struct gear
+		{
+			static constexpr gear_table_t table = make_gear_table();
+		};
+
+		// bits ones in the top of a 64-bit word: the top bits of the gear hash
+		// depend on all of the last 64 bytes, the low ones only on the last few
+		inline uint64_t top_mask(unsigned bits)
+		{
+			if (bits == 0)
+				return 0;
+			if (bits >= 64)
+				return ~0ULL;
+			return ~0ULL << (64 - bits);
+		}
+	}
+
+	class chunker_t
+	{
+	public:
+		explicit chunker_t(const params_t& params = params_t())
+		{
+			m_min = params.min ? params.min : 1;
+			m_max = params.max > m_min ? params.max : m_min;
+			m_avg = params.avg < m_min ? m_min : params.avg > m_max ? m_max : params.avg;
+
+			unsigned bits = 0;
+			while (((size_t)2 << bits) <= m_avg)
+				++bits;
+			const unsigned level = params.normalization > 3 ? 3 : params.normalization;
+			m_mask_small = detail::top_mask(bits + level);
+			m_mask_large = detail::top_mask(bits > level ? bits - level : 1);
+		}
+
+		size_t min_size() const { return m_min; }
+		size_t avg_size() const { return m_avg; }
+		size_t max_size() const { return m_max; }
+
+		// Length of the chunk starting at data. size is what is available: it
+		// must be at least max_size() unless data runs to the end of the input.
+		size_t cut(const unsigned char* data, size_t size) const
+		{
+			if (size <= m_min)
+				return size;
+			if (size > m_max)
+				size = m_max;
+			const size_t normal = size < m_avg ? size : m_avg;
+			const uint64_t* gear = detail::gear::table.value;
+
+			uint64_t hash = 0;
+			size_t i = m_min;
+			for (; i < normal; ++i) {
+				hash = (hash << 1) + gear[data[i]];
+				if ((hash & m_mask_small) == 0)
+					return i + 1;
+			}
+			for (; i < size; ++i) {
+				hash = (hash << 1) + gear[data[i]];
+				if ((hash & m_mask_large) == 0)
+					return i + 1;
+			}
+			return size;
+		}
+
+		// Calls fn(offset, length) for every chunk of a buffer holding the whole input
+		template <class F>
+		void split(const void* data, size_t size, F fn) const
+		{
+			const unsigned char* p = (const unsigned char*)data;
+			size_t offset = 0;
+			while (offset < size) {
+				const size_t length = cut(p + offset, size - offset);
+				fn((uint64_t)offset, length);
+				offset += length;
+			}
+		}
+
+	private:
+		size_t m_min;
+		size_t m_avg;
+		size_t m_max;
+		uint64_t m_mask_small;		// before avg: more bits, cuts less likely
+		uint64_t m_mask_large;		// after avg: fewer bits, cuts more likely
+	};
+
+#ifdef _WIN32
+	struct chunk_t
+	{
+		uint64_t offset;
+		size_t length;
+		crypto::hash_t digest;
+	};
+
+	template <ALG_ID algorithm>
+	class file_chunker_t
+	{
+	public:
+		// threads is the number of hash workers; 0 uses every core but the one cutting
+		explicit file_chunker_t(const params_t& params = params_t(), unsigned threads = 0) : m_chunker(params), m_threads(threads)
+		{
+			if (m_threads == 0) {
+				const unsigned cores = std::thread::hardware_concurrency();
+				m_threads = cores > 1 ? cores - 1 : 1;
+			}
+		}
+
+		// Calls fn(const chunk_t&) for every chunk of the file, in order, on the
+		// calling thread. Returns false if the file cannot be mapped or a digest
+		// fails; lasterror() tells which.
+		template <class F>
+		bool run(LPCWSTR pszPath, F fn)
+		{
+			m_lasterror = crypto::errorinfo_t();
+			mmap_helper::mapped_file_t file;
+			if (!file.open(pszPath)) {
+				m_lasterror = crypto::errorinfo_t(::GetLastError(), "File could not be opened");
+				return false;
+			}
+			if (file.size() == 0)
+				return true;
+
+			pipeline_t pipeline((const unsigned char*)file.data(), file.size());
+			std::thread cutter(&file_chunker_t::cut_all, this, std::ref(pipeline));
+			std::vector<std::thread> workers;
+			for (unsigned t = 0; t < m_threads; ++t)
+				workers.emplace_back(&file_chunker_t::hash_all, this, std::ref(pipeline));
+
+			deliver(pipeline, fn);
+
+			cutter.join();
+			for (size_t t = 0; t < workers.size(); ++t)
+				workers[t].join();
+			if (pipeline.failed)
+				m_lasterror = pipeline.error;
+			return !pipeline.failed;
+		}
+
+		std::vector<chunk_t> chunks(LPCWSTR pszPath)
+		{
+			std::vector<chunk_t> out;
+			run(pszPath, [&out](chunk_t& c) { out.push_back(std::move(c)); });
+			return out;
+		}
+
+		crypto::errorinfo_t lasterror() const { return m_lasterror; }
+
+	private:
+		file_chunker_t(const file_chunker_t&);
+		file_chunker_t& operator= (const file_chunker_t&);
+
+		enum { kWindow = 256 };		// chunks cut but not yet delivered
+
+		struct slot_t
+		{
+			chunk_t chunk;
+			bool hashed;
+		};
+
+		// Chunk i lives in ring[i % kWindow] from the moment it is cut until it
+		// is delivered. The cutter waits for room, workers take chunks in cut
+		// order, and the caller waits for the oldest one to be hashed.
+		struct pipeline_t
+		{
+			pipeline_t(const unsigned char* d, size_t s) : data(d), size(s), ring(kWindow), cut(0), claimed(0), delivered(0), cut_done(false), failed(false) {}
+
+			const unsigned char* data;
+			size_t size;
+
+			std::mutex lock;
+			std::condition_variable room;
+			std::condition_variable work;
+			std::condition_variable ready;
+			std::vector<slot_t> ring;
+			size_t cut;
+			size_t claimed;
+			size_t delivered;
+			bool cut_done;
+			bool failed;
+			crypto::errorinfo_t error;
+		};
+
+		void cut_all(pipeline_t& p)
+		{
+			uint64_t offset = 0;
+			while (offset < p.size) {
+				const size_t length = m_chunker.cut(p.data + offset, p.size - (size_t)offset);
+				std::unique_lock<std::mutex> lock(p.lock);
+				p.room.wait(lock, [&p] { return p.cut - p.delivered < (size_t)kWindow || p.failed; });
+				if (p.failed)
+					break;
+				slot_t& slot = p.ring[p.cut % kWindow];
+				slot.chunk.offset = offset;
+				slot.chunk.length = length;
+				slot.hashed = false;
+				++p.cut;
+				p.work.notify_one();
+				offset += length;
+			}
+			std::lock_guard<std::mutex> guard(p.lock);
+			p.cut_done = true;
+			p.work.notify_all();
+			p.ready.notify_all();
+		}
+
+		void hash_all(pipeline_t& p)
+		{
+			crypto::cryptohash_t<algorithm> mdx;
+			for (;;) {
+				size_t index;
+				uint64_t offset;
+				size_t length;
+				{
+					std::unique_lock<std::mutex> lock(p.lock);
+					p.work.wait(lock, [&p] { return p.claimed < p.cut || p.cut_done || p.failed; });
+					if (p.claimed == p.cut || p.failed)
+						return;
+					index = p.claimed++;
+					offset = p.ring[index % kWindow].chunk.offset;
+					length = p.ring[index % kWindow].chunk.length;
+				}
+
+				bool ok = mdx.begin() && mdx.update(const_cast<unsigned char*>(p.data + offset), length) && mdx.finalize();
+
+				std::lock_guard<std::mutex> guard(p.lock);
+				if (!ok) {
+					if (!p.failed)
+						p.error = mdx.lasterror();
+					p.failed = true;
+					p.room.notify_all();
+					p.work.notify_all();
+					p.ready.notify_all();
+					return;
+				}
+				slot_t& slot = p.ring[index % kWindow];
+				slot.chunk.digest = mdx.digest();
+				slot.hashed = true;
+				if (index == p.delivered)
+					p.ready.notify_one();
+			}
+		}
+
+		template <class F>
+		void deliver(pipeline_t& p, F& fn)
+		{
+			chunk_t chunk;
+			for (;;) {
+				{
+					std::unique_lock<std::mutex> lock(p.lock);
+					p.ready.wait(lock, [&p] {
+						return (p.delivered < p.cut && p.ring[p.delivered % kWindow].hashed) || (p.cut_done && p.delivered == p.cut) || p.failed;
+					});
+					if (p.failed || p.delivered == p.cut)
+						return;
+					chunk.offset = p.ring[p.delivered % kWindow].chunk.offset;
+					chunk.length = p.ring[p.delivered % kWindow].chunk.length;
+					chunk.digest.swap(p.ring[p.delivered % kWindow].chunk.digest);
+					++p.delivered;
+					p.room.notify_one();
+				}
+				fn(chunk);
+			}
+		}
+
+		chunker_t m_chunker;
+		unsigned m_threads;
+		crypto::errorinfo_t m_lasterror;
+	};
+#endif
+}
+
+#endif // _CDC_HELPER_HPP_INCLUDED_
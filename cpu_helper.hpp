@@ -0,0 +1,432 @@
+/*
+* Author: LowBoyTeam (https://github.com/LowBoyTeam)
+* License: Code Project Open License
+* Disclaimer: The software is provided "as-is". No claim of suitability, guarantee, or any warranty whatsoever is provided.
+* Copyright (c) 2016-2017.
+*/
+
+#ifndef _CPU_HELPER_HPP_INCLUDED_
+#define _CPU_HELPER_HPP_INCLUDED_
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <atomic>
+#include <initializer_list>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#if defined(_M_X64) || defined(_M_AMD64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define CPU_HELPER_X86 1
+#if !defined(_MSC_VER)
+#include <cpuid.h>
+#endif
+#include <immintrin.h>
+#elif defined(_M_ARM64) || defined(__aarch64__) || defined(__ARM_NEON)
+#define CPU_HELPER_ARM 1
+#include <arm_neon.h>
+#endif
+
+// SSE2 is part of every x64 build, and of x86 builds that enable it. Code
+// under this needs no dispatch.
+#if defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#include <emmintrin.h>
+#define CPU_HELPER_HAS_SSE2 1
+#endif
+
+// Marks a function whose body uses instructions above the build's baseline.
+// MSVC accepts any intrinsic without this; GCC and Clang need the target
+// attribute. Only call such functions through a dispatch_t.
+#if defined(CPU_HELPER_X86) && !defined(_MSC_VER)
+#define CPU_HELPER_TARGET_SSSE3 __attribute__((target("ssse3")))
+#define CPU_HELPER_TARGET_SSE42 __attribute__((target("sse4.2,popcnt")))
+#define CPU_HELPER_TARGET_AVX2 __attribute__((target("avx2,bmi,bmi2,popcnt")))
+#define CPU_HELPER_TARGET_AVX512 __attribute__((target("avx512f,avx512bw,avx512vl,avx2,bmi,bmi2,popcnt")))
+#define CPU_HELPER_TARGET_SHA __attribute__((target("sha,sse4.1")))
+#define CPU_HELPER_TARGET_PCLMUL __attribute__((target("pclmul,sse4.1")))
+#else
+#define CPU_HELPER_TARGET_SSSE3
+#define CPU_HELPER_TARGET_SSE42
+#define CPU_HELPER_TARGET_AVX2
+#define CPU_HELPER_TARGET_AVX512
+#define CPU_HELPER_TARGET_SHA
+#define CPU_HELPER_TARGET_PCLMUL
+#endif
+
+////////////////////////////////////////////////////////
+// Runtime CPU feature detection and kernel dispatch
+//
+//  The fleet mixes CPU generations, so SIMD kernels are compiled for several
+//  instruction sets and the best one the machine supports is picked at run
+//  time. Features are detected once; each dispatch_t binds a function
+//  pointer on its first call.
+//
+//  For testing, the usable feature set can be lowered, but never raised:
+//    - environment: CPP_UTILS_SIMD=scalar|sse2|sse42|avx2|avx512|neon
+//    - API:         cpu_helper::set_tier(cpu_helper::kTierSSE2);
+//  Overrides should be applied at startup, before the kernels are used.
+//  Every dispatch_t ends in a { 0, ... } kernel in plain C++, so the scalar
+//  tier tests that code. Short inputs some helpers handle inline with
+//  baseline SSE2, before they reach a dispatch_t, are not affected.
+//
+//  The other SIMD helpers share a few small pieces from here as well:
+//  CPU_HELPER_HAS_SSE2 for their baseline kernels, bit scans for walking
+//  movemask results, and chunk_count() / run_parallel() for the scans that
+//  split a large buffer across threads.
+//
+//  Usage:
+//    static cpu_helper::dispatch_t<size_t(const char*, size_t)> count_kernel = {
+//        { cpu_helper::kAVX2, count_avx2 },
+//        { cpu_helper::kSSE2, count_sse2 },
+//        { 0, count_scalar } };
+//    size_t n = count_kernel(data, size);
+
+namespace cpu_helper
+{
+	enum feature_t
+	{
+		kSSE2 = 1 << 0,
+		kSSSE3 = 1 << 1,
+		kSSE41 = 1 << 2,
+		kSSE42 = 1 << 3,
+		kPOPCNT = 1 << 4,
+		kPCLMUL = 1 << 5,
+		kAVX = 1 << 6,
+		kAVX2 = 1 << 7,
+		kBMI1 = 1 << 8,
+		kBMI2 = 1 << 9,
+		kAVX512 = 1 << 10,	// F + BW + VL, with OS support for the ZMM state
+		kSHA = 1 << 11,
+		kNEON = 1 << 12
+	};
+
+	enum tier_t
+	{
+		kTierScalar,
+		kTierSSE2,
+		kTierSSE42,
+		kTierAVX2,
+		kTierAVX512,
+		kTierNEON
+	};
+
+	namespace detail
+	{
+		// Features each tier allows; SHA-NI and PCLMUL are 128-bit extensions
+		// and are therefore usable from the SSE4.2 tier up
+		inline unsigned tier_mask(tier_t tier)
+		{
+			switch (tier) {
+			case kTierScalar:
+				return 0;
+			case kTierSSE2:
+				return kSSE2;
+			case kTierSSE42:
+				return kSSE2 | kSSSE3 | kSSE41 | kSSE42 | kPOPCNT | kPCLMUL | kSHA;
+			case kTierAVX2:
+				return tier_mask(kTierSSE42) | kAVX | kAVX2 | kBMI1 | kBMI2;
+			case kTierAVX512:
+				return tier_mask(kTierAVX2) | kAVX512;
+			case kTierNEON:
+				return kNEON;
+			}
+			return 0;
+		}
+
+		inline unsigned detect()
+		{
+			unsigned f = 0;
+#if defined(CPU_HELPER_X86)
+			int regs[4] = { 0, 0, 0, 0 };
+			unsigned max_leaf;
+#if defined(_MSC_VER)
+			__cpuid(regs, 0);
+			max_leaf = (unsigned)regs[0];
+			__cpuid(regs, 1);
+#else
+			max_leaf = __get_cpuid_max(0, NULL);
+			__cpuid(1, regs[0], regs[1], regs[2], regs[3]);
+#endif
+			const unsigned ecx1 = (unsigned)regs[2];
+			const unsigned edx1 = (unsigned)regs[3];
+
+			if (edx1 & (1u << 26)) f |= kSSE2;
+			if (ecx1 & (1u << 9)) f |= kSSSE3;
+			if (ecx1 & (1u << 19)) f |= kSSE41;
+			if (ecx1 & (1u << 20)) f |= kSSE42;
+			if (ecx1 & (1u << 23)) f |= kPOPCNT;
+			if (ecx1 & (1u << 1)) f |= kPCLMUL;
+
+			// AVX state must also be enabled by the OS (OSXSAVE + XCR0)
+			uint64_t xcr0 = 0;
+			if ((ecx1 & (1u << 27)) && (ecx1 & (1u << 28))) {
+#if defined(_MSC_VER)
+				xcr0 = _xgetbv(0);
+#else
+				unsigned eax, edx;
+				__asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+				xcr0 = ((uint64_t)edx << 32) | eax;
+#endif
+			}
+			const bool os_avx = (xcr0 & 0x6) == 0x6;
+			const bool os_avx512 = (xcr0 & 0xE6) == 0xE6;
+			if (os_avx)
+				f |= kAVX;
+
+			if (max_leaf >= 7) {
+#if defined(_MSC_VER)
+				__cpuidex(regs, 7, 0);
+#else
+				__cpuid_count(7, 0, regs[0], regs[1], regs[2], regs[3]);
+#endif
+				const unsigned ebx7 = (unsigned)regs[1];
+				if (ebx7 & (1u << 3)) f |= kBMI1;
+				if (ebx7 & (1u << 8)) f |= kBMI2;
+				if (ebx7 & (1u << 29)) f |= kSHA;
+				if (os_avx && (ebx7 & (1u << 5))) f |= kAVX2;
+				if (os_avx512 && (ebx7 & (1u << 16)) && (ebx7 & (1u << 30)) && (ebx7 & (1u << 31))) f |= kAVX512;
+			}
+#elif defined(CPU_HELPER_ARM)
+			f |= kNEON;
+#endif
+			return f;
+		}
+
+		inline bool parse_tier(const char* name, tier_t& tier)
+		{
+			static const struct { const char* name; tier_t tier; } names[] = {
+				{ "scalar", kTierScalar }, { "sse2", kTierSSE2 }, { "sse42", kTierSSE42 },
+				{ "avx2", kTierAVX2 }, { "avx512", kTierAVX512 }, { "neon", kTierNEON } };
+			for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); ++i) {
+				if (!strcmp(name, names[i].name)) {
+					tier = names[i].tier;
+					return true;
+				}
+			}
+			return false;
+		}
+
+		inline std::atomic<unsigned>& effective()
+		{
+			static std::atomic<unsigned> features(0);
+			return features;
+		}
+
+		// Bumped on every override so dispatch_t knows to re-bind
+		inline std::atomic<unsigned>& generation()
+		{
+			static std::atomic<unsigned> gen(1);
+			return gen;
+		}
+	}
+
+	// What the hardware and OS support, ignoring overrides
+	inline unsigned detected()
+	{
+		static const unsigned features = detail::detect();
+		return features;
+	}
+
+	// What kernels may use: detected() limited by CPP_UTILS_SIMD and set_tier()
+	inline unsigned features()
+	{
+		static const bool initialized = [] {
+			unsigned f = detected();
+#ifdef _MSC_VER
+#pragma warning(suppress: 4996)
+#endif
+			const char* env = getenv("CPP_UTILS_SIMD");
+			tier_t tier;
+			if (env != NULL && detail::parse_tier(env, tier))
+				f &= detail::tier_mask(tier);
+			detail::effective().store(f);
+			return true;
+		}();
+		(void)initialized;
+		return detail::effective().load(std::memory_order_relaxed);
+	}
+
+	inline bool has(unsigned required)
+	{
+		return (features() & required) == required;
+	}
+
+	// Limits kernels to the given feature set (intersected with detected())
+	inline void set_features(unsigned mask)
+	{
+		features();
+		detail::effective().store(detected() & mask);
+		detail::generation().fetch_add(1);
+	}
+
+	inline void set_tier(tier_t tier)
+	{
+		set_features(detail::tier_mask(tier));
+	}
+
+	// Removes every override, including the environment one
+	inline void reset()
+	{
+		set_features(~0u);
+	}
+
+	// Highest tier fully covered by the current features
+	inline tier_t tier()
+	{
+		const unsigned f = features();
+		if (f & kNEON)
+			return kTierNEON;
+		const tier_t order[] = { kTierAVX512, kTierAVX2, kTierSSE42, kTierSSE2 };
+		for (size_t i = 0; i < sizeof(order) / sizeof(order[0]); ++i) {
+			if ((f & detail::tier_mask(order[i])) == detail::tier_mask(order[i]))
+				return order[i];
+		}
+		return kTierScalar;
+	}
+
+	inline const char* tier_name(tier_t t)
+	{
+		static const char* names[] = { "scalar", "sse2", "sse42", "avx2", "avx512", "neon" };
+		return names[t];
+	}
+
+	// Index of the lowest set bit; mask must not be 0
+	inline unsigned ctz32(uint32_t mask)
+	{
+#ifdef _MSC_VER
+		unsigned long index;
+		_BitScanForward(&index, mask);
+		return (unsigned)index;
+#else
+		return (unsigned)__builtin_ctz(mask);
+#endif
+	}
+
+	inline unsigned ctz64(uint64_t mask)
+	{
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_ARM64))
+		unsigned long index;
+		_BitScanForward64(&index, mask);
+		return (unsigned)index;
+#elif defined(_MSC_VER)
+		return (uint32_t)mask != 0 ? ctz32((uint32_t)mask) : ctz32((uint32_t)(mask >> 32)) + 32;
+#else
+		return (unsigned)__builtin_ctzll(mask);
+#endif
+	}
+
+	// Set bits, counted by hand: POPCNT is not part of the x64 baseline
+	inline unsigned popcount32(uint32_t x)
+	{
+		x = x - ((x >> 1) & 0x55555555u);
+		x = (x & 0x33333333u) + ((x >> 2) & 0x33333333u);
+		return (((x + (x >> 4)) & 0x0F0F0F0Fu) * 0x01010101u) >> 24;
+	}
+
+	inline unsigned popcount64(uint64_t x)
+	{
+		x = x - ((x >> 1) & 0x5555555555555555ULL);
+		x = (x & 0x3333333333333333ULL) + ((x >> 2) & 0x3333333333333333ULL);
+		return (unsigned)((((x + (x >> 4)) & 0x0F0F0F0F0F0F0F0FULL) * 0x0101010101010101ULL) >> 56);
+	}
+
+	// How many chunks to split size bytes into for threads threads (0 = every
+	// core) so that none is under min_chunk bytes; at least 1
+	inline size_t chunk_count(size_t size, unsigned threads, size_t min_chunk = 1 << 20)
+	{
+		const size_t most = size / min_chunk;
+		// hardware_concurrency() costs more than a small input takes to scan
+		if (most <= 1)
+			return 1;
+		if (threads == 0)
+			threads = std::thread::hardware_concurrency();
+		if (threads == 0)
+			threads = 1;
+		return most < threads ? most : threads;
+	}
+
+	// Calls fn(i) for every i in [0, count), fn(0) on the calling thread and
+	// the others on threads of their own; returns when all have finished
+	template <class F>
+	inline void run_parallel(size_t count, F fn)
+	{
+		std::vector<std::thread> pool;
+		for (size_t i = 1; i < count; ++i)
+			pool.emplace_back(fn, i);
+		if (count)
+			fn(0);
+		for (size_t t = 0; t < pool.size(); ++t)
+			pool[t].join();
+	}
+
+	// A set of implementations of one kernel, best first; the last one should
+	// require nothing. The first call binds the first candidate whose required
+	// features are all available; later calls are an indirect call.
+	template <class Fn>
+	class dispatch_t;
+
+	template <class R, class... Args>
+	class dispatch_t<R(Args...)>
+	{
+	public:
+		typedef R (*fn_t)(Args...);
+
+		struct candidate_t
+		{
+			unsigned required;
+			fn_t fn;
+		};
+
+		dispatch_t(std::initializer_list<candidate_t> candidates) : m_count(0), m_fn(NULL), m_generation(0)
+		{
+			for (const candidate_t* c = candidates.begin(); c != candidates.end() && m_count < kMaxCandidates; ++c)
+				m_candidates[m_count++] = *c;
+		}
+
+		fn_t get()
+		{
+			const unsigned gen = detail::generation().load(std::memory_order_relaxed);
+			fn_t fn = m_fn.load(std::memory_order_acquire);
+			if (fn != NULL && m_generation.load(std::memory_order_relaxed) == gen)
+				return fn;
+			return resolve(gen);
+		}
+
+		R operator()(Args... args)
+		{
+			return get()(std::forward<Args>(args)...);
+		}
+
+	private:
+		dispatch_t(const dispatch_t&);
+		dispatch_t& operator= (const dispatch_t&);
+
+		enum { kMaxCandidates = 8 };
+
+		fn_t resolve(unsigned gen)
+		{
+			fn_t fn = m_candidates[m_count - 1].fn;
+			for (size_t i = 0; i < m_count; ++i) {
+				if (has(m_candidates[i].required)) {
+					fn = m_candidates[i].fn;
+					break;
+				}
+			}
+			// Racing resolvers store the same answer, so no lock is needed
+			m_fn.store(fn, std::memory_order_release);
+			m_generation.store(gen, std::memory_order_relaxed);
+			return fn;
+		}
+
+		candidate_t m_candidates[kMaxCandidates];
+		size_t m_count;
+		std::atomic<fn_t> m_fn;
+		std::atomic<unsigned> m_generation;
+	};
+}
+
+#endif // _CPU_HELPER_HPP_INCLUDED_
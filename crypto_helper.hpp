@@ -20,6 +20,9 @@
 #include <iomanip>
 #include <fstream>
 
+#include "instrument_helper.hpp"
+#include "base64_helper.hpp"
+
 namespace crypto
 {
 	typedef std::vector<unsigned char> hash_t;
@@ -45,6 +48,16 @@ namespace crypto
 
 			return sstr.str();
 		}
+
+		// url = true gives unpadded base64url, safe in URLs without further escaping
+		static std::string b64tostr(std::vector<unsigned char> const & val, bool url = false)
+		{
+			std::string out;
+			const char* data = val.empty() ? "" : (const char*)&val[0];
+			if (url)
+				return base64_helper::encode<base64_helper::url_mode>(std::string_view(data, val.size()), out);
+			return base64_helper::encode<base64_helper::standard_mode>(std::string_view(data, val.size()), out);
+		}
 	};
 
 	struct errorinfo_t
@@ -78,7 +91,7 @@ namespace crypto
 		{
 			m_lasterror = errorinfo_t();
 
-			if (m_hCryptProv != NULL && m_hHash != NULL)
+			if (m_hHash != NULL)
 			{
 				m_lasterror = errorinfo_t(0, "Cryptographic provider already acquired!");
 				return false;
@@ -86,9 +99,11 @@ namespace crypto
 
 			m_digest.clear();
 
-			DWORD   dwProvType = PROV_RSA_AES;
-			if (!::CryptAcquireContext(&m_hCryptProv,NULL,NULL,PROV_RSA_AES,CRYPT_VERIFYCONTEXT | CRYPT_MACHINE_KEYSET))
+			// The context outlives finalize(), so hashing many small inputs with
+			// one object acquires it only once
+			if (m_hCryptProv == NULL && !::CryptAcquireContext(&m_hCryptProv,NULL,NULL,PROV_RSA_AES,CRYPT_VERIFYCONTEXT | CRYPT_MACHINE_KEYSET))
 			{
+				m_hCryptProv = NULL;
 				m_lasterror = errorinfo_t(GetLastError(), "Failed to acquire cryptographic context.");
 				return false;
 			}
@@ -106,6 +121,7 @@ namespace crypto
 
 		bool update(unsigned char* const buffer, size_t size)
 		{
+			CPP_UTILS_PROBE(kCryptoUpdate, size);
 			m_lasterror = errorinfo_t();
 
 			if (m_hCryptProv == NULL || m_hHash == NULL)
@@ -162,17 +178,12 @@ namespace crypto
 				m_hHash = NULL;
 			}
 
-			if (m_hCryptProv != NULL)
-			{
-				::CryptReleaseContext(m_hCryptProv, 0);
-				m_hCryptProv = NULL;
-			}
-
 			return success;
 		}
 
 		hash_t digest() const { return m_digest; }
 		std::string hexdigest(bool uppercase = false) const { return string_utils::hextostr(m_digest, uppercase); }
+		std::string b64digest(bool url = false) const { return string_utils::b64tostr(m_digest, url); }
 		errorinfo_t lasterror() const { return m_lasterror; }
 
 	private:
@@ -209,6 +220,11 @@ namespace crypto
 			return string_utils::hextostr(digesttext(text), uppercase);
 		}
 
+		std::string b64digesttext(std::string const& text, bool url = false)
+		{
+			return string_utils::b64tostr(digesttext(text), url);
+		}
+
 		hash_t digestfile(std::string const& filename)
 		{
 			cryptohash_t<algorithm> mdx;
@@ -266,6 +282,11 @@ namespace crypto
 			return string_utils::hextostr(digestfile(filename), uppercase);
 		}
 
+		std::string b64digestfile(std::string const& filename, bool url = false)
+		{
+			return string_utils::b64tostr(digestfile(filename), url);
+		}
+
 		errorinfo_t lasterror() const { return m_lasterror; }
 	};
 
@@ -0,0 +1,511 @@
+/*
+* Author: LowBoyTeam (https://github.com/LowBoyTeam)
+* License: Code Project Open License
+* Disclaimer: The software is provided "as-is". No claim of suitability, guarantee, or any warranty whatsoever is provided.
+* Copyright (c) 2016-2017.
+*/
+
+#ifndef _CSV_HELPER_HPP_INCLUDED_
+#define _CSV_HELPER_HPP_INCLUDED_
+
+#include <stdint.h>
+#include <string.h>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <thread>
+#include <utility>
+
+#include "cpu_helper.hpp"
+#include "mmap_helper.hpp"
+
+////////////////////////////////////////////////////////
+// Delimited record (CSV / TSV) reader
+//
+//  parse() indexes a whole buffer in the style of simdcsv: every 64-byte
+//  block is classified into quote, delimiter and newline bitmasks with SIMD
+//  compares, the inside-quotes mask is the prefix XOR of the quote bits, and
+//  the delimiters and newlines outside quotes are recorded as offsets. Rows
+//  are then produced from that index as views into the buffer. Only quoted
+//  fields that contain "" are unescaped, into a per-row scratch buffer.
+//
+//  With threads > 1 the buffer is cut into chunks. A first parallel pass
+//  counts the quotes of every chunk, which gives the exact quote state at
+//  each chunk start; a second pass indexes the chunks in parallel. Rows may
+//  cross chunk boundaries, and for_each_row(fn, threads) hands each thread
+//  the rows that start in its chunks.
+//
+//  Records end at '\n' (a preceding '\r' is dropped); blank lines are
+//  skipped. The buffer must outlive the reader.
+//
+//  Usage:
+//    csv_helper::reader_t csv;
+//    csv.open("data.csv", 0);                       // 0 = every core
+//    csv.for_each_row([](const csv_helper::row_t& row) {
+//        std::string_view name = row[1];
+//    });
+
+namespace csv_helper
+{
+	class row_t
+	{
+	public:
+		row_t() : m_offset(0) {}
+
+		size_t size() const { return m_fields.size(); }
+		bool empty() const { return m_fields.empty(); }
+		std::string_view operator[](size_t i) const { return m_fields[i]; }
+		const std::string_view* begin() const { return m_fields.data(); }
+		const std::string_view* end() const { return m_fields.data() + m_fields.size(); }
+
+		// Byte offset of the record in the parsed buffer
+		size_t offset() const { return m_offset; }
+
+	private:
+		friend class reader_t;
+
+		std::vector<std::string_view> m_fields;
+		std::vector<std::pair<size_t, size_t> > m_spans;	// raw field bounds while scanning
+		std::string m_scratch;
+		size_t m_offset;
+	};
+
+	namespace detail
+	{
+		struct masks_t
+		{
+			uint64_t quote;
+			uint64_t delim;
+			uint64_t newline;
+		};
+
+		// Bit i of the result is the XOR of bits 0..i of x: set inside a quoted run
+		inline uint64_t prefix_xor(uint64_t x)
+		{
+			x ^= x << 1;
+			x ^= x << 2;
+			x ^= x << 4;
+			x ^= x << 8;
+			x ^= x << 16;
+			x ^= x << 32;
+			return x;
+		}
+
+		inline void classify_scalar(const char* p, size_t n, char quote, char delim, masks_t& m)
+		{
+			m.quote = m.delim = m.newline = 0;
+			for (size_t i = 0; i < n; ++i) {
+				const uint64_t bit = (uint64_t)1 << i;
+				if (p[i] == quote)
+					m.quote |= bit;
+				else if (p[i] == delim)
+					m.delim |= bit;
+				else if (p[i] == '\n')
+					m.newline |= bit;
+			}
+		}
+
+#ifdef CPU_HELPER_HAS_SSE2
+		inline void classify_sse2(const char* p, char quote, char delim, masks_t& m)
+		{
+			const __m128i q = _mm_set1_epi8(quote), d = _mm_set1_epi8(delim), nl = _mm_set1_epi8('\n');
+			m.quote = m.delim = m.newline = 0;
+			for (int k = 0; k < 4; ++k) {
+				const __m128i v = _mm_loadu_si128((const __m128i*)(p + 16 * k));
+				m.quote |= (uint64_t)(unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(v, q)) << (16 * k);
+				m.delim |= (uint64_t)(unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(v, d)) << (16 * k);
+				m.newline |= (uint64_t)(unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(v, nl)) << (16 * k);
+			}
+		}
+#endif
+
+		// Records the structural characters of one block; inquote carries the
+		// quote state from the previous block
+		inline void emit(const masks_t& m, size_t base, uint64_t& inquote, std::vector<uint32_t>& out)
+		{
+			const uint64_t inside = prefix_xor(m.quote) ^ inquote;
+			inquote = (uint64_t)0 - (inside >> 63);
+			uint64_t structural = (m.delim | m.newline) & ~inside;
+			while (structural) {
+				out.push_back((uint32_t)(base + cpu_helper::ctz64(structural)));
+				structural &= structural - 1;
+			}
+		}
+
+		// Offsets (relative to p) of the delimiters and newlines outside quotes
+		typedef void index_fn(const char* p, size_t n, char quote, char delim, bool inquote, std::vector<uint32_t>& out);
+		typedef size_t quotes_fn(const char* p, size_t n, char quote);
+
+		inline void index_tail(const char* p, size_t i, size_t n, char quote, char delim, uint64_t& inquote, std::vector<uint32_t>& out)
+		{
+			if (i < n) {
+				masks_t m;
+				classify_scalar(p + i, n - i, quote, delim, m);
+				emit(m, i, inquote, out);
+			}
+		}
+
+		inline void index_scalar(const char* p, size_t n, char quote, char delim, bool inquote, std::vector<uint32_t>& out)
+		{
+			uint64_t state = inquote ? ~(uint64_t)0 : 0;
+			size_t i = 0;
+			for (; i + 64 <= n; i += 64) {
+				masks_t m;
+				classify_scalar(p + i, 64, quote, delim, m);
+				emit(m, i, state, out);
+			}
+			index_tail(p, i, n, quote, delim, state, out);
+		}
+
+		inline size_t quotes_scalar(const char* p, size_t n, char quote)
+		{
+			size_t count = 0;
+			for (size_t i = 0; i < n; ++i)
+				count += p[i] == quote;
+			return count;
+		}
+
+		inline void index_sse2(const char* p, size_t n, char quote, char delim, bool inquote, std::vector<uint32_t>& out)
+		{
+			uint64_t state = inquote ? ~(uint64_t)0 : 0;
+			size_t i = 0;
+#ifdef CPU_HELPER_HAS_SSE2
+			for (; i + 64 <= n; i += 64) {
+				masks_t m;
+				classify_sse2(p + i, quote, delim, m);
+				emit(m, i, state, out);
+			}
+#endif
+			index_tail(p, i, n, quote, delim, state, out);
+		}
+
+		inline size_t quotes_sse2(const char* p, size_t n, char quote)
+		{
+			size_t count = 0, i = 0;
+#ifdef CPU_HELPER_HAS_SSE2
+			const __m128i q = _mm_set1_epi8(quote);
+			for (; i + 16 <= n; i += 16)
+				count += cpu_helper::popcount32((unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(p + i)), q)));
+#endif
+			return count + quotes_scalar(p + i, n - i, quote);
+		}
+
+#ifdef CPU_HELPER_X86
+		CPU_HELPER_TARGET_AVX2 inline void classify_avx2(const char* p, char quote, char delim, masks_t& m)
+		{
+			const __m256i q = _mm256_set1_epi8(quote), d = _mm256_set1_epi8(delim), nl = _mm256_set1_epi8('\n');
+			const __m256i lo = _mm256_loadu_si256((const __m256i*)p);
+			const __m256i hi = _mm256_loadu_si256((const __m256i*)(p + 32));
+			m.quote = (uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(lo, q)) | ((uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(hi, q)) << 32);
+			m.delim = (uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(lo, d)) | ((uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(hi, d)) << 32);
+			m.newline = (uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(lo, nl)) | ((uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(hi, nl)) << 32);
+		}
+
+		CPU_HELPER_TARGET_AVX2 inline void index_avx2(const char* p, size_t n, char quote, char delim, bool inquote, std::vector<uint32_t>& out)
+		{
+			uint64_t state = inquote ? ~(uint64_t)0 : 0;
+			size_t i = 0;
+			for (; i + 64 <= n; i += 64) {
+				masks_t m;
+				classify_avx2(p + i, quote, delim, m);
+				emit(m, i, state, out);
+			}
+			index_tail(p, i, n, quote, delim, state, out);
+		}
+
+		CPU_HELPER_TARGET_AVX2 inline size_t quotes_avx2(const char* p, size_t n, char quote)
+		{
+			size_t count = 0, i = 0;
+			const __m256i q = _mm256_set1_epi8(quote);
+			for (; i + 32 <= n; i += 32)
+				count += _mm_popcnt_u32((unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(p + i)), q)));
+			return count + quotes_sse2(p + i, n - i, quote);
+		}
+#endif
+
+		inline cpu_helper::dispatch_t<index_fn>& index_kernel()
+		{
+			static cpu_helper::dispatch_t<index_fn> kernel = {
+#ifdef CPU_HELPER_X86
+				{ cpu_helper::kAVX2 | cpu_helper::kBMI1, index_avx2 },
+#endif
+#ifdef CPU_HELPER_HAS_SSE2
+				{ cpu_helper::kSSE2, index_sse2 },
+#endif
+				{ 0, index_scalar } };
+			return kernel;
+		}
+
+		inline cpu_helper::dispatch_t<quotes_fn>& quotes_kernel()
+		{
+			static cpu_helper::dispatch_t<quotes_fn> kernel = {
+#ifdef CPU_HELPER_X86
+				{ cpu_helper::kAVX2 | cpu_helper::kPOPCNT, quotes_avx2 },
+#endif
+#ifdef CPU_HELPER_HAS_SSE2
+				{ cpu_helper::kSSE2, quotes_sse2 },
+#endif
+				{ 0, quotes_scalar } };
+			return kernel;
+		}
+	}
+
+	class reader_t
+	{
+	public:
+		explicit reader_t(char delimiter = ',', char quote = '"') : m_delimiter(delimiter), m_quote(quote) {}
+
+		// Maps the file and indexes it; threads = 0 uses every core
+#ifdef _WIN32
+		BOOL open(LPCWSTR pszPath, unsigned threads = 1)
+		{
+			if (!m_file.open(pszPath))
+				return FALSE;
+			parse(m_file.view(), threads);
+			return TRUE;
+		}
+#else
+		bool open(const char* path, unsigned threads = 1)
+		{
+			if (!m_file.open(path))
+				return false;
+			parse(m_file.view(), threads);
+			return true;
+		}
+#endif
+
+		// Indexes data, which must stay alive and unchanged while rows are read
+		void parse(std::string_view data, unsigned threads = 1)
+		{
+			m_data = data;
+			m_chunks.clear();
+			if (data.empty())
+				return;
+
+			// Offsets are stored relative to their chunk in 32 bits
+			size_t count = cpu_helper::chunk_count(data.size(), threads, kMinChunk);
+			if (data.size() / count > kMaxChunk)
+				count = (data.size() + kMaxChunk - 1) / kMaxChunk;
+
+			m_chunks.resize(count);
+			for (size_t c = 0; c < count; ++c) {
+				m_chunks[c].begin = data.size() / count * c;
+				m_chunks[c].end = c + 1 == count ? data.size() : data.size() / count * (c + 1);
+			}
+
+			// Pass 1: the quote parity before each chunk gives its starting state
+			std::vector<size_t> quotes(count, 0);
+			if (count > 1) {
+				detail::quotes_fn* count_quotes = detail::quotes_kernel().get();
+				cpu_helper::run_parallel(count, [&](size_t c) {
+					quotes[c] = count_quotes(data.data() + m_chunks[c].begin, m_chunks[c].end - m_chunks[c].begin, m_quote);
+				});
+			}
+			bool inquote = false;
+			for (size_t c = 0; c < count; ++c) {
+				m_chunks[c].inquote = inquote;
+				inquote ^= (quotes[c] & 1) != 0;
+			}
+
+			// Pass 2: index every chunk
+			detail::index_fn* index = detail::index_kernel().get();
+			cpu_helper::run_parallel(count, [&](size_t c) {
+				chunk_t& chunk = m_chunks[c];
+				chunk.index.clear();
+				chunk.index.reserve((chunk.end - chunk.begin) / 16);
+				index(data.data() + chunk.begin, chunk.end - chunk.begin, m_quote, m_delimiter, chunk.inquote, chunk.index);
+			});
+		}
+
+		std::string_view data() const { return m_data; }
+
+		// Calls fn(const row_t&) for every record in order; returns the row count
+		template <class F>
+		size_t for_each_row(F fn) const
+		{
+			row_t row;
+			auto each = [&fn](const row_t& r, unsigned) { fn(r); };
+			return rows(cursor_t(), 0, m_data.size(), row, each, 0);
+		}
+
+		// Calls fn(const row_t&, unsigned thread) from up to threads threads (one
+		// per chunk at most); rows are in order within each thread
+		template <class F>
+		size_t for_each_row(F fn, unsigned threads) const
+		{
+			if (m_chunks.empty())
+				return 0;
+			if (threads == 0)
+				threads = std::thread::hardware_concurrency();
+			size_t parts = m_chunks.size() < threads ? m_chunks.size() : threads;
+			if (parts <= 1) {
+				row_t row;
+				return rows(cursor_t(), 0, m_data.size(), row, fn, 0);
+			}
+
+			// Part t gets the rows that start in [m_chunks[first].begin, next part's begin)
+			std::vector<size_t> counts(parts, 0);
+			cpu_helper::run_parallel(parts, [&](size_t t) {
+				const size_t first = m_chunks.size() * t / parts;
+				const size_t last = m_chunks.size() * (t + 1) / parts;
+				const size_t limit = last == m_chunks.size() ? m_data.size() : m_chunks[last].begin;
+				cursor_t at;
+				size_t start;
+				if (!first_row(first, at, start) || start >= limit)
+					return;
+				row_t row;
+				counts[t] = rows(at, start, limit, row, fn, (unsigned)t);
+			});
+			size_t total = 0;
+			for (size_t t = 0; t < parts; ++t)
+				total += counts[t];
+			return total;
+		}
+
+	private:
+		reader_t(const reader_t&);
+		reader_t& operator= (const reader_t&);
+
+		static const size_t kMinChunk = 1 << 20;
+		static const size_t kMaxChunk = (size_t)1 << 30;
+
+		struct chunk_t
+		{
+			size_t begin;
+			size_t end;
+			bool inquote;
+			std::vector<uint32_t> index;
+		};
+
+		struct cursor_t
+		{
+			cursor_t() : chunk(0), i(0) {}
+			size_t chunk;
+			size_t i;
+		};
+
+		// Next structural offset at or after the cursor
+		bool next(cursor_t& at, size_t& pos) const
+		{
+			while (at.chunk < m_chunks.size()) {
+				const chunk_t& c = m_chunks[at.chunk];
+				if (at.i < c.index.size()) {
+					pos = c.begin + c.index[at.i++];
+					return true;
+				}
+				++at.chunk;
+				at.i = 0;
+			}
+			return false;
+		}
+
+		// Finds the first record starting at or after chunk `chunk`
+		bool first_row(size_t chunk, cursor_t& at, size_t& start) const
+		{
+			const size_t begin = m_chunks[chunk].begin;
+			if (chunk == 0) {
+				start = 0;
+				return true;
+			}
+			// A record starts right at begin if the previous chunk ends with a newline
+			const chunk_t& prev = m_chunks[chunk - 1];
+			if (!prev.index.empty() && prev.begin + prev.index.back() == begin - 1 && m_data[begin - 1] == '\n') {
+				at.chunk = chunk;
+				at.i = 0;
+				start = begin;
+				return true;
+			}
+			at.chunk = chunk;
+			at.i = 0;
+			size_t pos;
+			while (next(at, pos)) {
+				if (m_data[pos] == '\n') {
+					start = pos + 1;
+					return true;
+				}
+			}
+			return false;
+		}
+
+		std::string_view field(size_t begin, size_t end, row_t& row) const
+		{
+			const char* p = m_data.data();
+			if (end > begin && p[begin] == m_quote) {
+				++begin;
+				if (end > begin && p[end - 1] == m_quote)
+					--end;
+				if (memchr(p + begin, m_quote, end - begin) != NULL) {
+					// "" inside a quoted field stands for one quote
+					const size_t out = row.m_scratch.size();
+					for (size_t i = begin; i < end; ++i) {
+						row.m_scratch.push_back(p[i]);
+						if (p[i] == m_quote && i + 1 < end && p[i + 1] == m_quote)
+							++i;
+					}
+					return std::string_view(row.m_scratch.data() + out, row.m_scratch.size() - out);
+				}
+			}
+			return std::string_view(p + begin, end - begin);
+		}
+
+		// Emits the records starting in [start, limit) using the structural
+		// offsets from at onwards; the last record may run to the end of data
+		template <class F>
+		size_t rows(cursor_t at, size_t start, size_t limit, row_t& row, F& fn, unsigned thread) const
+		{
+			const size_t size = m_data.size();
+			size_t count = 0;
+			size_t field_begin = start;
+			size_t pos;
+			bool fresh = true;
+
+			while (start < limit) {
+				if (fresh) {
+					row.m_fields.clear();
+					row.m_spans.clear();
+					row.m_scratch.clear();
+					row.m_offset = start;
+					fresh = false;
+				}
+
+				const bool more = next(at, pos);
+				if (!more)
+					pos = size;
+				if (pos < start)
+					continue;
+				const bool record_end = !more || m_data[pos] == '\n';
+				size_t field_end = pos;
+				if (record_end && field_end > field_begin && m_data[field_end - 1] == '\r')
+					--field_end;
+				row.m_spans.push_back(std::make_pair(field_begin, field_end));
+				field_begin = pos + 1;
+				if (!record_end)
+					continue;
+
+				// Blank lines produce no row
+				if (row.m_spans.size() > 1 || field_end > row.m_spans[0].first) {
+					// Unescaped text is never longer than the record, so one
+					// reservation keeps every view into the scratch buffer valid
+					row.m_scratch.reserve(pos - start);
+					for (size_t i = 0; i < row.m_spans.size(); ++i)
+						row.m_fields.push_back(field(row.m_spans[i].first, row.m_spans[i].second, row));
+					fn((const row_t&)row, thread);
+					++count;
+				}
+				if (!more)
+					break;
+				start = pos + 1;
+				fresh = true;
+			}
+			return count;
+		}
+
+		char m_delimiter;
+		char m_quote;
+		std::string_view m_data;
+		std::vector<chunk_t> m_chunks;
+		mmap_helper::mapped_file_t m_file;
+	};
+}
+
+#endif // _CSV_HELPER_HPP_INCLUDED_
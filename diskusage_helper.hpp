@@ -0,0 +1,611 @@
+/*
+* Author: LowBoyTeam (https://github.com/LowBoyTeam)
+* License: Code Project Open License
+* Disclaimer: The software is provided "as-is". No claim of suitability, guarantee, or any warranty whatsoever is provided.
+* Copyright (c) 2016-2017.
+*/
+
+#ifndef _DISKUSAGE_HELPER_HPP_INCLUDED_
+#define _DISKUSAGE_HELPER_HPP_INCLUDED_
+
+#include <Windows.h>
+#include <stdint.h>
+#include <string.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <algorithm>
+
+#include "filefinder_helper.hpp"
+
+////////////////////////////////////////////////////////
+// Parallel disk usage
+//
+//  scanner_t walks a directory tree on several threads and rolls up, for
+//  every directory, the logical size, the allocated size and the file and
+//  directory counts of its whole subtree.
+//
+//  Directories are compact nodes that hold a parent index and a name, never
+//  a full path; path() rebuilds one on demand. Nodes live in chunks that do
+//  not move, and their totals are atomics that a worker adds to (up the
+//  parent chain) as soon as it has listed a directory. usage() and top()
+//  can therefore be called from another thread while the scan runs, and
+//  show the largest subtrees found so far.
+//
+//  Directories are listed with GetFileInformationByHandleEx, which returns
+//  sizes, allocation and file ids for a whole batch of entries without
+//  opening any file. On file systems that do not support it the walk falls
+//  back to filefinder_helper, which provides sizes only (allocated = size,
+//  no hard-link detection). Directory reparse points (junctions, symlinks,
+//  mount points) are not followed.
+//
+//  With dedup_links, a file with several hard links is counted once, by the
+//  first directory that reaches it. That keeps every file id seen, about
+//  16 bytes per file.
+//
+//  Usage:
+//    diskusage_helper::scanner_t scan;
+//    scan.start(L"D:\\data");
+//    while (!scan.wait(500)) {
+//        for (auto& t : scan.top(10))
+//            wprintf(L"%llu %s\n", t.usage.allocated, scan.path(t.node).c_str());
+//    }
+//    diskusage_helper::usage_t total = scan.totals();
+
+namespace diskusage_helper
+{
+	struct usage_t
+	{
+		uint64_t size;			// sum of file lengths
+		uint64_t allocated;		// bytes the files take on disk
+		uint64_t files;
+		uint64_t dirs;			// subdirectories, not counting the directory itself
+	};
+
+	struct subtree_t
+	{
+		uint32_t node;
+		usage_t usage;
+	};
+
+	namespace detail
+	{
+		inline unsigned log2(uint32_t v)
+		{
+#ifdef _MSC_VER
+			unsigned long index;
+			_BitScanReverse(&index, v);
+			return (unsigned)index;
+#else
+			return 31u - (unsigned)__builtin_clz(v);
+#endif
+		}
+
+		inline uint64_t mix(uint64_t h)
+		{
+			h ^= h >> 33;
+			h *= 0xFF51AFD7ED558CCDULL;
+			h ^= h >> 33;
+			h *= 0xC4CEB9FE1A85EC53ULL;
+			h ^= h >> 33;
+			return h;
+		}
+
+		// Set of 64-bit file ids, split into shards so workers rarely share a lock
+		class id_set_t
+		{
+		public:
+			id_set_t() {}
+
+			// True if id was not in the set yet
+			bool insert(uint64_t id)
+			{
+				const uint64_t h = mix(id);
+				shard_t& shard = m_shards[h >> (64 - kShardBits)];
+				std::lock_guard<std::mutex> guard(shard.lock);
+				if ((shard.count + 1) * 2 > shard.slots.size())
+					grow(shard);
+				const size_t mask = shard.slots.size() - 1;
+				for (size_t i = (size_t)h & mask;; i = (i + 1) & mask) {
+					if (shard.slots[i] == id)
+						return false;
+					if (shard.slots[i] == 0) {
+						shard.slots[i] = id;
+						++shard.count;
+						return true;
+					}
+				}
+			}
+
+			void clear()
+			{
+				for (size_t s = 0; s < kShards; ++s) {
+					std::vector<uint64_t>().swap(m_shards[s].slots);
+					m_shards[s].count = 0;
+				}
+			}
+
+		private:
+			id_set_t(const id_set_t&);
+			id_set_t& operator= (const id_set_t&);
+
+			enum { kShardBits = 6, kShards = 1 << kShardBits };
+
+			struct alignas(64) shard_t
+			{
+				shard_t() : count(0) {}
+				std::mutex lock;
+				std::vector<uint64_t> slots;	// 0 means empty
+				size_t count;
+			};
+
+			static void grow(shard_t& shard)
+			{
+				std::vector<uint64_t> old;
+				old.swap(shard.slots);
+				shard.slots.assign(old.empty() ? 1024 : old.size() * 2, 0);
+				const size_t mask = shard.slots.size() - 1;
+				for (size_t k = 0; k < old.size(); ++k) {
+					if (old[k] == 0)
+						continue;
+					size_t i = (size_t)mix(old[k]) & mask;
+					while (shard.slots[i] != 0)
+						i = (i + 1) & mask;
+					shard.slots[i] = old[k];
+				}
+			}
+
+			shard_t m_shards[kShards];
+		};
+	}
+
+	class scanner_t
+	{
+	public:
+		static const uint32_t kNoParent = 0xFFFFFFFFu;
+
+		scanner_t() : m_count(0), m_used(0), m_capacity(0), m_pending(0), m_active(0), m_cancel(false), m_errors(0), m_dedup(true)
+		{
+			for (size_t k = 0; k < kMaxChunks; ++k)
+				m_chunks[k].store(NULL, std::memory_order_relaxed);
+		}
+
+		~scanner_t()
+		{
+			cancel();
+			wait();
+			clear();
+		}
+
+		// Starts scanning pszRoot in the background; threads = 0 uses every core.
+		// Returns FALSE if a scan is already running or the root cannot be resolved.
+		BOOL start(LPCWSTR pszRoot, unsigned threads = 0, bool dedup_links = true)
+		{
+			if (running())
+				return FALSE;
+			wait();
+			clear();
+
+			DWORD dwLength = ::GetFullPathNameW(pszRoot, 0, NULL, NULL);
+			if (dwLength == 0)
+				return FALSE;
+			std::wstring full(dwLength, L'\0');
+			dwLength = ::GetFullPathNameW(pszRoot, dwLength, &full[0], NULL);
+			if (dwLength == 0)
+				return FALSE;
+			full.resize(dwLength);
+			while (full.size() > 3 && (full.back() == L'\\' || full.back() == L'/'))
+				full.pop_back();
+
+			// The \\?\ form lifts the MAX_PATH limit for everything below the root
+			if (full.compare(0, 4, L"\\\\?\\") == 0)
+				m_root = full;
+			else if (full.compare(0, 2, L"\\\\") == 0)
+				m_root = L"\\\\?\\UNC\\" + full.substr(2);
+			else
+				m_root = L"\\\\?\\" + full;
+			m_display_root = full;
+
+			m_dedup = dedup_links;
+			m_cancel.store(false);
+			m_errors.store(0);
+
+			const wchar_t* empty = L"";
+			add_nodes(kNoParent, &empty, NULL, 1);
+			{
+				std::lock_guard<std::mutex> guard(m_queue_lock);
+				m_queue.push_back(0);
+				m_pending = 1;
+			}
+
+			if (threads == 0)
+				threads = std::thread::hardware_concurrency();
+			if (threads == 0)
+				threads = 1;
+			m_active.store(threads);
+			for (unsigned t = 0; t < threads; ++t)
+				m_workers.emplace_back(&scanner_t::worker, this);
+			return TRUE;
+		}
+
+		// Waits up to dwMilliseconds for the scan to finish; TRUE once it has
+		BOOL wait(DWORD dwMilliseconds = INFINITE)
+		{
+			{
+				std::unique_lock<std::mutex> lock(m_queue_lock);
+				if (dwMilliseconds == INFINITE)
+					m_done.wait(lock, [this] { return m_active.load() == 0; });
+				else if (!m_done.wait_for(lock, std::chrono::milliseconds(dwMilliseconds), [this] { return m_active.load() == 0; }))
+					return FALSE;
+			}
+			for (size_t t = 0; t < m_workers.size(); ++t)
+				m_workers[t].join();
+			m_workers.clear();
+			m_ids.clear();
+			return TRUE;
+		}
+
+		// Stops the workers at the next directory; totals stay as far as they got
+		void cancel()
+		{
+			m_cancel.store(true);
+			m_ready.notify_all();
+		}
+
+		bool running() const { return m_active.load() != 0; }
+
+		// Directories that could not be listed (access denied, removed meanwhile)
+		size_t errors() const { return m_errors.load(std::memory_order_relaxed); }
+
+		// Directories found so far; node 0 is the root
+		size_t node_count() const { return m_count.load(std::memory_order_acquire); }
+
+		uint32_t parent(uint32_t node) const { return get(node).parent; }
+
+		// Subtree totals of node; safe while the scan runs
+		usage_t usage(uint32_t node) const
+		{
+			const node_t& n = get(node);
+			usage_t u;
+			u.size = n.size.load(std::memory_order_relaxed);
+			u.allocated = n.allocated.load(std::memory_order_relaxed);
+			u.files = n.files.load(std::memory_order_relaxed);
+			u.dirs = n.dirs.load(std::memory_order_relaxed);
+			return u;
+		}
+
+		usage_t totals() const
+		{
+			if (node_count() == 0) {
+				usage_t u = { 0, 0, 0, 0 };
+				return u;
+			}
+			return usage(0);
+		}
+
+		// Full path of node, as given to start() (without the \\?\ prefix)
+		std::wstring path(uint32_t node) const
+		{
+			return build_path(node, m_display_root);
+		}
+
+		// The n largest subtrees so far, largest first, by allocated size or by
+		// logical size. Ancestors are included: the root always comes first.
+		std::vector<subtree_t> top(size_t n, bool by_allocated = true) const
+		{
+			std::vector<subtree_t> best;
+			if (n == 0)
+				return best;
+			const size_t count = node_count();
+			best.reserve(n + 1);
+			auto smaller = [by_allocated](const subtree_t& a, const subtree_t& b) {
+				return by_allocated ? a.usage.allocated > b.usage.allocated : a.usage.size > b.usage.size;
+			};
+			// Min-heap of the current best n
+			for (size_t i = 0; i < count; ++i) {
+				subtree_t s;
+				s.node = (uint32_t)i;
+				s.usage = usage((uint32_t)i);
+				if (best.size() < n) {
+					best.push_back(s);
+					std::push_heap(best.begin(), best.end(), smaller);
+				}
+				else if (smaller(s, best.front())) {
+					std::pop_heap(best.begin(), best.end(), smaller);
+					best.back() = s;
+					std::push_heap(best.begin(), best.end(), smaller);
+				}
+			}
+			std::sort_heap(best.begin(), best.end(), smaller);
+			return best;
+		}
+
+	private:
+		scanner_t(const scanner_t&);
+		scanner_t& operator= (const scanner_t&);
+
+		enum
+		{
+			kChunkBits = 10,				// the first node chunk holds 1024 nodes, each next one twice as many
+			kMaxChunks = 32 - kChunkBits,
+			kNameBlock = 64 * 1024,			// characters
+			kListBuffer = 64 * 1024			// bytes per GetFileInformationByHandleEx call
+		};
+
+		struct node_t
+		{
+			uint32_t parent;
+			uint32_t name_length;
+			const wchar_t* name;
+			std::atomic<uint64_t> size;
+			std::atomic<uint64_t> allocated;
+			std::atomic<uint64_t> files;
+			std::atomic<uint64_t> dirs;
+		};
+
+		// Totals of the files directly inside one directory
+		struct local_t
+		{
+			uint64_t size;
+			uint64_t allocated;
+			uint64_t files;
+		};
+
+		const node_t& get(uint32_t node) const
+		{
+			const uint32_t i = node + (1u << kChunkBits);
+			const unsigned k = detail::log2(i) - kChunkBits;
+			return m_chunks[k].load(std::memory_order_acquire)[i - (1u << (k + kChunkBits))];
+		}
+
+		node_t& get(uint32_t node)
+		{
+			return const_cast<node_t&>(static_cast<const scanner_t*>(this)->get(node));
+		}
+
+		// Adds count child nodes under parent and returns the first index.
+		// lengths may be NULL for NUL-terminated names.
+		uint32_t add_nodes(uint32_t parent, const wchar_t* const* names, const uint32_t* lengths, size_t count)
+		{
+			std::lock_guard<std::mutex> guard(m_nodes_lock);
+			const uint32_t first = (uint32_t)m_count.load(std::memory_order_relaxed);
+			for (size_t c = 0; c < count; ++c) {
+				const uint32_t index = first + (uint32_t)c;
+				const uint32_t i = index + (1u << kChunkBits);
+				const unsigned k = detail::log2(i) - kChunkBits;
+				node_t* chunk = m_chunks[k].load(std::memory_order_relaxed);
+				if (chunk == NULL) {
+					chunk = new node_t[(size_t)1 << (k + kChunkBits)];
+					m_chunks[k].store(chunk, std::memory_order_release);
+				}
+				node_t& n = chunk[i - (1u << (k + kChunkBits))];
+
+				// Names go into an arena that never moves
+				const size_t length = lengths ? lengths[c] : wcslen(names[c]);
+				if (m_names.empty() || m_capacity - m_used < length) {
+					// An oversized name gets a block of its own size
+					m_capacity = length > kNameBlock ? length : (size_t)kNameBlock;
+					m_names.push_back(std::unique_ptr<wchar_t[]>(new wchar_t[m_capacity]));
+					m_used = 0;
+				}
+				wchar_t* copy = m_names.back().get() + m_used;
+				memcpy(copy, names[c], length * sizeof(wchar_t));
+				m_used += length;
+
+				n.parent = parent;
+				n.name = copy;
+				n.name_length = (uint32_t)length;
+				n.size.store(0, std::memory_order_relaxed);
+				n.allocated.store(0, std::memory_order_relaxed);
+				n.files.store(0, std::memory_order_relaxed);
+				n.dirs.store(0, std::memory_order_relaxed);
+			}
+			// Readers only look below m_count, so publish after the nodes are set
+			m_count.store(first + count, std::memory_order_release);
+			return first;
+		}
+
+		std::wstring build_path(uint32_t node, const std::wstring& root) const
+		{
+			std::vector<uint32_t> chain;
+			for (uint32_t n = node; n != 0 && n != kNoParent; n = get(n).parent)
+				chain.push_back(n);
+			std::wstring path = root;
+			for (size_t i = chain.size(); i-- > 0;) {
+				const node_t& n = get(chain[i]);
+				if (path.empty() || path.back() != L'\\')
+					path += L'\\';
+				path.append(n.name, n.name_length);
+			}
+			return path;
+		}
+
+		// Adds totals to node and every ancestor
+		void roll_up(uint32_t node, const local_t& local, uint64_t dirs)
+		{
+			if (local.files == 0 && dirs == 0)
+				return;
+			for (uint32_t n = node; n != kNoParent; n = get(n).parent) {
+				node_t& target = get(n);
+				target.size.fetch_add(local.size, std::memory_order_relaxed);
+				target.allocated.fetch_add(local.allocated, std::memory_order_relaxed);
+				target.files.fetch_add(local.files, std::memory_order_relaxed);
+				target.dirs.fetch_add(dirs, std::memory_order_relaxed);
+			}
+		}
+
+		void worker()
+		{
+			std::unique_ptr<unsigned char[]> buffer(new unsigned char[kListBuffer]);
+			std::wstring scratch;
+			std::vector<size_t> offsets;
+			std::vector<const wchar_t*> names;
+			std::vector<uint32_t> lengths;
+
+			for (;;) {
+				uint32_t dir;
+				{
+					std::unique_lock<std::mutex> lock(m_queue_lock);
+					m_ready.wait(lock, [this] { return !m_queue.empty() || m_pending == 0 || m_cancel.load(); });
+					if (m_queue.empty() || m_cancel.load())
+						break;
+					dir = m_queue.back();
+					m_queue.pop_back();
+				}
+
+				// Subdirectory names are collected in scratch, one string per
+				// directory, and copied into the node arena by add_nodes
+				scratch.clear();
+				offsets.clear();
+				local_t local = { 0, 0, 0 };
+				bool unsupported = false;
+				if (!list(build_path(dir, m_root), buffer.get(), local, scratch, offsets, unsupported)) {
+					if (!unsupported || !list_fallback(dir, local, scratch, offsets))
+						m_errors.fetch_add(1, std::memory_order_relaxed);
+				}
+
+				names.clear();
+				lengths.clear();
+				for (size_t c = 0; c < offsets.size(); ++c) {
+					const size_t end = c + 1 < offsets.size() ? offsets[c + 1] : scratch.size();
+					names.push_back(scratch.data() + offsets[c]);
+					lengths.push_back((uint32_t)(end - offsets[c]));
+				}
+				uint32_t first = 0;
+				if (!names.empty())
+					first = add_nodes(dir, names.data(), lengths.data(), names.size());
+				roll_up(dir, local, names.size());
+
+				std::lock_guard<std::mutex> guard(m_queue_lock);
+				for (size_t c = 0; c < names.size(); ++c)
+					m_queue.push_back(first + (uint32_t)c);
+				m_pending += names.size();
+				--m_pending;
+				if (!names.empty() || m_pending == 0)
+					m_ready.notify_all();
+			}
+
+			std::lock_guard<std::mutex> guard(m_queue_lock);
+			if (m_active.fetch_sub(1) == 1)
+				m_done.notify_all();
+			m_ready.notify_all();
+		}
+
+		void count_file(uint64_t id, uint64_t size, uint64_t allocated, local_t& local)
+		{
+			if (m_dedup && id != 0 && !m_ids.insert(id))
+				return;
+			local.size += size;
+			local.allocated += allocated;
+			++local.files;
+		}
+
+		static bool is_dots(const wchar_t* name, size_t length)
+		{
+			return name[0] == L'.' && (length == 1 || (length == 2 && name[1] == L'.'));
+		}
+
+		// Lists one directory, a 64 KB batch of entries per call. Partial results
+		// are kept when the listing breaks off; when the file system does not
+		// support it at all, unsupported is set and nothing is returned.
+		bool list(const std::wstring& path, unsigned char* buffer, local_t& local, std::wstring& scratch, std::vector<size_t>& offsets, bool& unsupported)
+		{
+			HANDLE hDir = ::CreateFileW(path.c_str(), FILE_LIST_DIRECTORY, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS, NULL);
+			if (hDir == INVALID_HANDLE_VALUE)
+				return false;
+
+			FILE_INFO_BY_HANDLE_CLASS cls = FileIdBothDirectoryRestartInfo;
+			while (::GetFileInformationByHandleEx(hDir, cls, buffer, kListBuffer)) {
+				cls = FileIdBothDirectoryInfo;
+				for (const unsigned char* p = buffer;;) {
+					const FILE_ID_BOTH_DIR_INFO* info = (const FILE_ID_BOTH_DIR_INFO*)p;
+					const size_t length = info->FileNameLength / sizeof(WCHAR);
+					if (!(info->FileAttributes & FILE_ATTRIBUTE_DIRECTORY)) {
+						count_file((uint64_t)info->FileId.QuadPart, (uint64_t)info->EndOfFile.QuadPart, (uint64_t)info->AllocationSize.QuadPart, local);
+					}
+					else if (!(info->FileAttributes & FILE_ATTRIBUTE_REPARSE_POINT) && !is_dots(info->FileName, length)) {
+						offsets.push_back(scratch.size());
+						scratch.append(info->FileName, length);
+					}
+					if (info->NextEntryOffset == 0)
+						break;
+					p += info->NextEntryOffset;
+				}
+			}
+			const DWORD dwError = ::GetLastError();
+			::CloseHandle(hDir);
+			if (dwError == ERROR_NO_MORE_FILES)
+				return true;
+			if (cls == FileIdBothDirectoryRestartInfo && (dwError == ERROR_INVALID_PARAMETER || dwError == ERROR_NOT_SUPPORTED))
+				unsupported = true;
+			return false;
+		}
+
+		// filefinder_helper listing, for file systems without FileIdBothDirectoryInfo
+		bool list_fallback(uint32_t dir, local_t& local, std::wstring& scratch, std::vector<size_t>& offsets)
+		{
+			const std::wstring pattern = build_path(dir, m_display_root) + L"\\*";
+			if (pattern.size() >= MAX_PATH)
+				return false;
+			filefinder_helper finder;
+			BOOL bFound = finder.FindFile(pattern.c_str());
+			if (!bFound)
+				return false;
+			while (bFound) {
+				if (!finder.IsDirectory()) {
+					const uint64_t size = ((uint64_t)finder.m_fd.nFileSizeHigh << 32) | finder.m_fd.nFileSizeLow;
+					count_file(0, size, size, local);
+				}
+				else if (!finder.IsDots() && !finder.MatchesMask(FILE_ATTRIBUTE_REPARSE_POINT)) {
+					offsets.push_back(scratch.size());
+					scratch.append(finder.m_fd.cFileName);
+				}
+				bFound = finder.FindNextFile();
+			}
+			return true;
+		}
+
+		void clear()
+		{
+			for (size_t k = 0; k < kMaxChunks; ++k) {
+				delete[] m_chunks[k].load(std::memory_order_relaxed);
+				m_chunks[k].store(NULL, std::memory_order_relaxed);
+			}
+			m_count.store(0);
+			m_names.clear();
+			m_used = 0;
+			m_capacity = 0;
+			m_queue.clear();
+			m_pending = 0;
+		}
+
+		std::atomic<node_t*> m_chunks[kMaxChunks];
+		std::atomic<size_t> m_count;
+		std::mutex m_nodes_lock;
+		std::vector<std::unique_ptr<wchar_t[]> > m_names;
+		size_t m_used;		// characters used in m_names.back()
+		size_t m_capacity;	// characters m_names.back() holds
+
+		std::mutex m_queue_lock;
+		std::condition_variable m_ready;
+		std::condition_variable m_done;
+		std::vector<uint32_t> m_queue;		// used as a stack: depth first keeps it short
+		size_t m_pending;					// queued or being listed
+		std::atomic<unsigned> m_active;
+		std::atomic<bool> m_cancel;
+		std::vector<std::thread> m_workers;
+
+		std::atomic<size_t> m_errors;
+		bool m_dedup;
+		detail::id_set_t m_ids;
+		std::wstring m_root;
+		std::wstring m_display_root;
+	};
+}
+
+#endif // _DISKUSAGE_HELPER_HPP_INCLUDED_
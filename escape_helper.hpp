@@ -0,0 +1,681 @@
+/*
+* Author: LowBoyTeam (https://github.com/LowBoyTeam)
+* License: Code Project Open License
+* Disclaimer: The software is provided "as-is". No claim of suitability, guarantee, or any warranty whatsoever is provided.
+* Copyright (c) 2016-2017.
+*/
+
+#ifndef _ESCAPE_HELPER_HPP_INCLUDED_
+#define _ESCAPE_HELPER_HPP_INCLUDED_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <string>
+#include <string_view>
+
+#include "cpu_helper.hpp"
+
+////////////////////////////////////////////////////////
+// JSON and C string literal escaping
+//
+//  One pass in each direction instead of a chain of string_helper::replace
+//  calls. Runs of bytes that need no escaping are found 16 or 32 bytes at a
+//  time (SSE2, or AVX2 chosen at run time through cpu_helper) and copied in
+//  bulk; only the bytes that need escaping are handled one at a time.
+//
+//  json_mode escapes '"', '\\' and control characters and passes UTF-8
+//  through. json_ascii_mode also writes DEL and every non-ASCII character as
+//  \uXXXX, with a surrogate pair above U+FFFF, and invalid UTF-8 bytes as
+//  \ufffd.
+//  c_mode writes a C string literal body: the usual \n-style escapes, and
+//  three-digit octal for other control bytes and DEL, so that a following
+//  digit is never taken as part of the escape.
+//
+//  escape() writes into a caller buffer of exactly escaped_length() bytes
+//  (max_escaped_length() is a bound that needs no pass over the input).
+//  unescape() writes at most len bytes and may work in place. It returns
+//  npos for a malformed escape. A \u escape that is half of a surrogate pair
+//  without its other half becomes U+FFFD. The string overloads append to
+//  out, and escape_if_needed / unescape_if_needed return the input itself,
+//  without copying, when it has nothing to change.
+//
+//  Usage:
+//    std::string line;
+//    escape_helper::escape(message, line);
+//
+//    std::string storage;
+//    std::string_view value = escape_helper::escape_if_needed<escape_helper::c_mode>(name, storage);
+//
+//    size_t n = escape_helper::unescape(&text[0], text.size(), &text[0]);
+//    if (n == escape_helper::npos)
+//        return false;
+//    text.resize(n);
+
+namespace escape_helper
+{
+	static const size_t npos = (size_t)-1;
+
+	namespace detail
+	{
+		struct byte_class_t
+		{
+			unsigned char width[256];	// escaped size: 1 unchanged, 2 \n-style, 4 octal, 6 \u00XX, 0 non-ASCII to decode
+			char letter[256];			// the letter after '\\' for width 2
+		};
+
+		constexpr byte_class_t make_byte_class(bool ascii, bool c_syntax)
+		{
+			byte_class_t t = {};
+			for (int c = 0; c < 256; ++c) {
+				char letter = 0;
+				switch (c) {
+				case '"': letter = '"'; break;
+				case '\\': letter = '\\'; break;
+				case '\b': letter = 'b'; break;
+				case '\f': letter = 'f'; break;
+				case '\n': letter = 'n'; break;
+				case '\r': letter = 'r'; break;
+				case '\t': letter = 't'; break;
+				case '\a': letter = c_syntax ? 'a' : 0; break;
+				case '\v': letter = c_syntax ? 'v' : 0; break;
+				}
+				t.letter[c] = letter;
+				if (letter)
+					t.width[c] = 2;
+				else if (c < 0x20 || (c == 0x7F && (c_syntax || ascii)))
+					t.width[c] = c_syntax ? 4 : 6;
+				else if (c >= 0x80 && ascii)
+					t.width[c] = 0;
+				else
+					t.width[c] = 1;
+			}
+			return t;
+		}
+	}
+
+	// RFC 8259 string contents; UTF-8 is copied as is
+	struct json_mode
+	{
+		static constexpr bool ascii = false;
+		static constexpr bool c_syntax = false;
+		static constexpr detail::byte_class_t table = detail::make_byte_class(false, false);
+	};
+
+	// RFC 8259 with every character above U+007F as \uXXXX, for ASCII-only sinks
+	struct json_ascii_mode
+	{
+		static constexpr bool ascii = true;
+		static constexpr bool c_syntax = false;
+		static constexpr detail::byte_class_t table = detail::make_byte_class(true, false);
+	};
+
+	// C/C++ string literal contents, also used for log lines
+	struct c_mode
+	{
+		static constexpr bool ascii = false;
+		static constexpr bool c_syntax = true;
+		static constexpr detail::byte_class_t table = detail::make_byte_class(false, true);
+	};
+
+	namespace detail
+	{
+		////////////////////////////////////////////////////////
+		// Byte sets for the scanners: what escape() and unescape() stop at
+
+		template <class Mode>
+		struct special_set
+		{
+			static bool hit(unsigned char c) { return Mode::table.width[c] != 1; }
+
+#ifdef CPU_HELPER_HAS_SSE2
+			static unsigned mask(__m128i v)
+			{
+				// Signed, bytes from 0x80 up are below 0x20 too; unsigned, they are not
+				__m128i m = Mode::ascii ? _mm_cmplt_epi8(v, _mm_set1_epi8(0x20))
+					: _mm_cmpeq_epi8(_mm_max_epu8(v, _mm_set1_epi8(0x1F)), _mm_set1_epi8(0x1F));
+				m = _mm_or_si128(m, _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('"')), _mm_cmpeq_epi8(v, _mm_set1_epi8('\\'))));
+				if (Mode::c_syntax || Mode::ascii)
+					m = _mm_or_si128(m, _mm_cmpeq_epi8(v, _mm_set1_epi8(0x7F)));
+				return (unsigned)_mm_movemask_epi8(m);
+			}
+#endif
+#ifdef CPU_HELPER_X86
+			CPU_HELPER_TARGET_AVX2 static unsigned mask(__m256i v)
+			{
+				__m256i m = Mode::ascii ? _mm256_cmpgt_epi8(_mm256_set1_epi8(0x20), v)
+					: _mm256_cmpeq_epi8(_mm256_max_epu8(v, _mm256_set1_epi8(0x1F)), _mm256_set1_epi8(0x1F));
+				m = _mm256_or_si256(m, _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('"')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8('\\'))));
+				if (Mode::c_syntax || Mode::ascii)
+					m = _mm256_or_si256(m, _mm256_cmpeq_epi8(v, _mm256_set1_epi8(0x7F)));
+				return (unsigned)_mm256_movemask_epi8(m);
+			}
+#endif
+		};
+
+		struct backslash_set
+		{
+			static bool hit(unsigned char c) { return c == '\\'; }
+
+#ifdef CPU_HELPER_HAS_SSE2
+			static unsigned mask(__m128i v)
+			{
+				return (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8('\\')));
+			}
+#endif
+#ifdef CPU_HELPER_X86
+			CPU_HELPER_TARGET_AVX2 static unsigned mask(__m256i v)
+			{
+				return (unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\\')));
+			}
+#endif
+		};
+
+		// First byte of [p, end) in Set, or end
+		template <class Set>
+		inline const char* scan_scalar(const char* p, const char* end)
+		{
+			while (p < end && !Set::hit((unsigned char)*p))
+				++p;
+			return p;
+		}
+
+		template <class Set>
+		inline const char* scan_sse2(const char* p, const char* end)
+		{
+#ifdef CPU_HELPER_HAS_SSE2
+			for (; end - p >= 16; p += 16) {
+				const unsigned mask = Set::mask(_mm_loadu_si128((const __m128i*)p));
+				if (mask != 0)
+					return p + cpu_helper::ctz32(mask);
+			}
+#endif
+			return scan_scalar<Set>(p, end);
+		}
+
+#ifdef CPU_HELPER_X86
+		template <class Set>
+		CPU_HELPER_TARGET_AVX2 inline const char* scan_avx2(const char* p, const char* end)
+		{
+			for (; end - p >= 32; p += 32) {
+				const unsigned mask = Set::mask(_mm256_loadu_si256((const __m256i*)p));
+				if (mask != 0)
+					return p + _tzcnt_u32(mask);
+			}
+			return scan_sse2<Set>(p, end);
+		}
+#endif
+
+		typedef const char* scan_fn(const char*, const char*);
+
+		// As in url_helper: short runs stay on the inline SSE2 path
+		enum { kDispatchThreshold = 64 };
+
+		template <class Set>
+		inline cpu_helper::dispatch_t<scan_fn>& scan_kernel()
+		{
+			static cpu_helper::dispatch_t<scan_fn> kernel = {
+#ifdef CPU_HELPER_X86
+				{ cpu_helper::kAVX2 | cpu_helper::kBMI1, scan_avx2<Set> },
+#endif
+#ifdef CPU_HELPER_HAS_SSE2
+				{ cpu_helper::kSSE2, scan_sse2<Set> },
+#endif
+				{ 0, scan_scalar<Set> } };
+			return kernel;
+		}
+
+		// Runs between escapes are usually short, so the first block is always
+		// looked at inline and only a longer run pays for the indirect call
+		template <class Set>
+		inline const char* scan(const char* p, const char* end)
+		{
+#ifdef CPU_HELPER_HAS_SSE2
+			if (end - p >= 16) {
+				const unsigned mask = Set::mask(_mm_loadu_si128((const __m128i*)p));
+				if (mask != 0)
+					return p + cpu_helper::ctz32(mask);
+				p += 16;
+			}
+#endif
+			if (end - p < kDispatchThreshold)
+				return scan_sse2<Set>(p, end);
+			return scan_kernel<Set>()(p, end);
+		}
+
+		////////////////////////////////////////////////////////
+		// UTF-8
+
+		// Length of the valid UTF-8 sequence at p, or 0
+		inline size_t decode_utf8(const unsigned char* p, const unsigned char* end, uint32_t& cp)
+		{
+			const unsigned c = p[0];
+			size_t length;
+			uint32_t min;
+			if (c >= 0xC2 && c <= 0xDF) {
+				length = 2;
+				cp = c & 0x1F;
+				min = 0x80;
+			}
+			else if (c >= 0xE0 && c <= 0xEF) {
+				length = 3;
+				cp = c & 0x0F;
+				min = 0x800;
+			}
+			else if (c >= 0xF0 && c <= 0xF4) {
+				length = 4;
+				cp = c & 0x07;
+				min = 0x10000;
+			}
+			else {
+				return 0;
+			}
+			if ((size_t)(end - p) < length)
+				return 0;
+			for (size_t i = 1; i < length; ++i) {
+				if ((p[i] & 0xC0) != 0x80)
+					return 0;
+				cp = (cp << 6) | (p[i] & 0x3F);
+			}
+			if (cp < min || cp > 0x10FFFF || (cp >= 0xD800 && cp <= 0xDFFF))
+				return 0;
+			return length;
+		}
+
+		inline char* put_utf8(uint32_t cp, char* dst)
+		{
+			if (cp < 0x80) {
+				*dst++ = (char)cp;
+			}
+			else if (cp < 0x800) {
+				*dst++ = (char)(0xC0 | (cp >> 6));
+				*dst++ = (char)(0x80 | (cp & 0x3F));
+			}
+			else if (cp < 0x10000) {
+				*dst++ = (char)(0xE0 | (cp >> 12));
+				*dst++ = (char)(0x80 | ((cp >> 6) & 0x3F));
+				*dst++ = (char)(0x80 | (cp & 0x3F));
+			}
+			else {
+				*dst++ = (char)(0xF0 | (cp >> 18));
+				*dst++ = (char)(0x80 | ((cp >> 12) & 0x3F));
+				*dst++ = (char)(0x80 | ((cp >> 6) & 0x3F));
+				*dst++ = (char)(0x80 | (cp & 0x3F));
+			}
+			return dst;
+		}
+
+		inline char* put_u_escape(uint32_t unit, char* dst)
+		{
+			static const char hexchars[] = "0123456789abcdef";
+			dst[0] = '\\';
+			dst[1] = 'u';
+			dst[2] = hexchars[(unit >> 12) & 15];
+			dst[3] = hexchars[(unit >> 8) & 15];
+			dst[4] = hexchars[(unit >> 4) & 15];
+			dst[5] = hexchars[unit & 15];
+			return dst + 6;
+		}
+
+		inline int hexval(unsigned char c)
+		{
+			if (c >= '0' && c <= '9')
+				return c - '0';
+			c |= 0x20;
+			if (c >= 'a' && c <= 'f')
+				return c - 'a' + 10;
+			return -1;
+		}
+
+		// Value of the digits hex digits at p, or -1; p must have digits bytes
+		inline long read_hex(const char* p, size_t digits)
+		{
+			long value = 0;
+			for (size_t i = 0; i < digits; ++i) {
+				const int h = hexval((unsigned char)p[i]);
+				if (h < 0)
+					return -1;
+				value = (value << 4) | h;
+			}
+			return value;
+		}
+
+		////////////////////////////////////////////////////////
+		// Engines
+
+		// Escapes the byte (or, in json_ascii_mode, the character) at p, which
+		// is not copied as is. Returns the input that follows it.
+		template <class Mode, bool Write>
+		inline const char* escape_one(const char* p, const char* end, char*& to, size_t& total)
+		{
+			const unsigned char c = (unsigned char)*p;
+			const unsigned width = Mode::table.width[c];
+			if (width != 0) {
+				if (Write) {
+					to[0] = '\\';
+					if (width == 2) {
+						to[1] = Mode::table.letter[c];
+					}
+					else if (width == 4) {
+						to[1] = (char)('0' + (c >> 6));
+						to[2] = (char)('0' + ((c >> 3) & 7));
+						to[3] = (char)('0' + (c & 7));
+					}
+					else {
+						put_u_escape(c, to);
+					}
+					to += width;
+				}
+				total += width;
+				return p + 1;
+			}
+
+			// json_ascii_mode: one character above U+007F, or one invalid byte
+			uint32_t cp;
+			size_t length = decode_utf8((const unsigned char*)p, (const unsigned char*)end, cp);
+			if (length == 0) {
+				cp = 0xFFFD;
+				length = 1;
+			}
+			if (cp < 0x10000) {
+				if (Write)
+					to = put_u_escape(cp, to);
+				total += 6;
+			}
+			else {
+				if (Write) {
+					to = put_u_escape(0xD800 + ((cp - 0x10000) >> 10), to);
+					to = put_u_escape(0xDC00 + ((cp - 0x10000) & 0x3FF), to);
+				}
+				total += 12;
+			}
+			return p + length;
+		}
+
+		template <bool Write>
+		inline void copy_run(const char* from, const char* to_end, char*& to, size_t& total)
+		{
+			const size_t n = (size_t)(to_end - from);
+			if (Write) {
+				// Most runs inside a block are a few bytes: not worth a memcpy call
+				if (n < 16) {
+					for (size_t i = 0; i < n; ++i)
+						to[i] = from[i];
+				}
+				else {
+					memcpy(to, from, n);
+				}
+				to += n;
+			}
+			total += n;
+		}
+
+		// Escapes [src, src + len). With Write false nothing is stored and dst
+		// may be NULL; either way the escaped size is returned.
+		template <class Mode, bool Write>
+		inline size_t escape(const char* src, size_t len, char* dst)
+		{
+			typedef special_set<Mode> set;
+			const char* p = src;
+			const char* const end = src + len;
+			char* to = dst;
+			size_t total = 0;
+
+#ifdef CPU_HELPER_HAS_SSE2
+			// Like url_helper::encode_sse2: escape the marked bytes of a block in
+			// turn and copy the runs between them
+			while (end - p >= 16) {
+				unsigned mask = set::mask(_mm_loadu_si128((const __m128i*)p));
+				if (mask == 0) {
+					const char* run = p;
+					p = scan<set>(p + 16, end);
+					copy_run<Write>(run, p, to, total);
+					continue;
+				}
+				const char* const block = p;
+				do {
+					const char* q = block + cpu_helper::ctz32(mask);
+					mask &= mask - 1;
+					// A multi-byte character escaped before may have covered q
+					if (q < p)
+						continue;
+					copy_run<Write>(p, q, to, total);
+					p = escape_one<Mode, Write>(q, end, to, total);
+				} while (mask);
+				if (p < block + 16) {
+					copy_run<Write>(p, block + 16, to, total);
+					p = block + 16;
+				}
+			}
+#endif
+			while (p < end) {
+				if (Mode::table.width[(unsigned char)*p] != 1) {
+					p = escape_one<Mode, Write>(p, end, to, total);
+					continue;
+				}
+				if (Write)
+					*to++ = *p;
+				++total;
+				++p;
+			}
+			return total;
+		}
+
+		template <class Mode>
+		inline size_t unescape(const char* src, size_t len, char* dst)
+		{
+			const char* p = src;
+			const char* const end = src + len;
+			char* to = dst;
+
+			for (;;) {
+				// Escapes often follow one another: look before scanning
+				if (p < end && *p != '\\') {
+					const char* run = p;
+					p = scan<backslash_set>(p, end);
+					// to never runs ahead of run, so a forward copy is safe in place too
+					const size_t n = (size_t)(p - run);
+					if (n < 16) {
+						for (size_t i = 0; i < n; ++i)
+							to[i] = run[i];
+					}
+					else if (to != run) {
+						memmove(to, run, n);
+					}
+					to += n;
+				}
+				if (p == end)
+					break;
+				if (end - p < 2)
+					return npos;
+
+				const char e = p[1];
+				p += 2;
+				switch (e) {
+				case '"': case '\\':
+					*to++ = e;
+					continue;
+				case 'b': *to++ = '\b'; continue;
+				case 'f': *to++ = '\f'; continue;
+				case 'n': *to++ = '\n'; continue;
+				case 'r': *to++ = '\r'; continue;
+				case 't': *to++ = '\t'; continue;
+				case 'u': {
+					if (end - p < 4)
+						return npos;
+					long cp = read_hex(p, 4);
+					if (cp < 0)
+						return npos;
+					p += 4;
+					if (cp >= 0xD800 && cp <= 0xDBFF && end - p >= 6 && p[0] == '\\' && p[1] == 'u') {
+						const long low = read_hex(p + 2, 4);
+						if (low >= 0xDC00 && low <= 0xDFFF) {
+							cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+							p += 6;
+						}
+					}
+					if (cp >= 0xD800 && cp <= 0xDFFF)
+						cp = 0xFFFD;
+					to = put_utf8((uint32_t)cp, to);
+					continue;
+				}
+				}
+
+				if (!Mode::c_syntax) {
+					if (e != '/')
+						return npos;
+					*to++ = e;
+					continue;
+				}
+
+				switch (e) {
+				case '\'': case '?':
+					*to++ = e;
+					continue;
+				case 'a': *to++ = '\a'; continue;
+				case 'v': *to++ = '\v'; continue;
+				case 'x': {
+					// At most two digits, so the value is always one byte
+					int value = -1;
+					for (int i = 0; i < 2 && p < end && hexval((unsigned char)*p) >= 0; ++i, ++p)
+						value = (value < 0 ? 0 : value << 4) | hexval((unsigned char)*p);
+					if (value < 0)
+						return npos;
+					*to++ = (char)value;
+					continue;
+				}
+				case 'U': {
+					if (end - p < 8)
+						return npos;
+					const long cp = read_hex(p, 8);
+					if (cp < 0 || cp > 0x10FFFF || (cp >= 0xD800 && cp <= 0xDFFF))
+						return npos;
+					p += 8;
+					to = put_utf8((uint32_t)cp, to);
+					continue;
+				}
+				}
+
+				if (e < '0' || e > '7')
+					return npos;
+				unsigned value = (unsigned)(e - '0');
+				for (int i = 0; i < 2 && p < end && *p >= '0' && *p <= '7'; ++i, ++p)
+					value = (value << 3) | (unsigned)(*p - '0');
+				if (value > 0xFF)
+					return npos;
+				*to++ = (char)value;
+			}
+			return (size_t)(to - dst);
+		}
+	}
+
+	// True if escaping src[0, len) with Mode would change it
+	template <class Mode = json_mode>
+	inline bool needs_escaping(const char* src, size_t len)
+	{
+		return detail::scan<detail::special_set<Mode> >(src, src + len) != src + len;
+	}
+
+	// Exact number of bytes escape<Mode> produces for src[0, len)
+	template <class Mode = json_mode>
+	inline size_t escaped_length(const char* src, size_t len)
+	{
+		return detail::escape<Mode, false>(src, len, NULL);
+	}
+
+	// Bound on escaped_length<Mode> for any len bytes, without looking at them
+	template <class Mode = json_mode>
+	inline size_t max_escaped_length(size_t len)
+	{
+		return len * (Mode::c_syntax ? 4 : 6);
+	}
+
+	// Escapes src[0, len) into dst, which must hold escaped_length<Mode>(src, len)
+	// bytes. No terminator is written. Returns the number of bytes written.
+	template <class Mode = json_mode>
+	inline size_t escape(const char* src, size_t len, char* dst)
+	{
+		return detail::escape<Mode, true>(src, len, dst);
+	}
+
+	// Unescapes src[0, len) into dst, which must hold len bytes; dst may be src
+	// to unescape in place. Returns the number of bytes written, or npos if src
+	// holds a malformed escape.
+	template <class Mode = json_mode>
+	inline size_t unescape(const char* src, size_t len, char* dst)
+	{
+		return detail::unescape<Mode>(src, len, dst);
+	}
+
+	// Appends the escaped form of src to out, growing it exactly once
+	template <class Mode = json_mode>
+	inline std::string& escape(std::string_view src, std::string& out)
+	{
+		const char* end = src.data() + src.size();
+		const char* first = detail::scan<detail::special_set<Mode> >(src.data(), end);
+		const size_t clean = (size_t)(first - src.data());
+		if (first == end) {
+			out.append(src.data(), src.size());
+			return out;
+		}
+		const size_t pos = out.size();
+		const size_t rest = escaped_length<Mode>(first, (size_t)(end - first));
+		out.resize(pos + clean + rest);
+		memcpy(&out[pos], src.data(), clean);
+		detail::escape<Mode, true>(first, (size_t)(end - first), &out[pos + clean]);
+		return out;
+	}
+
+	template <class Mode = json_mode>
+	inline std::string escape(std::string_view src)
+	{
+		std::string out;
+		return escape<Mode>(src, out);
+	}
+
+	// Returns src itself when it needs no escaping; otherwise escapes it into
+	// storage and returns that
+	template <class Mode = json_mode>
+	inline std::string_view escape_if_needed(std::string_view src, std::string& storage)
+	{
+		if (!needs_escaping<Mode>(src.data(), src.size()))
+			return src;
+		storage.clear();
+		return escape<Mode>(src, storage);
+	}
+
+	// Appends the unescaped form of src to out. On a malformed escape out is
+	// left as it was and false is returned.
+	template <class Mode = json_mode>
+	inline bool unescape(std::string_view src, std::string& out)
+	{
+		const size_t pos = out.size();
+		out.resize(pos + src.size());
+		const size_t n = unescape<Mode>(src.data(), src.size(), &out[pos]);
+		if (n == npos) {
+			out.resize(pos);
+			return false;
+		}
+		out.resize(pos + n);
+		return true;
+	}
+
+	// Sets result to src itself when it holds no escapes; otherwise unescapes
+	// it into storage and sets result to that. Returns false on a malformed
+	// escape.
+	template <class Mode = json_mode>
+	inline bool unescape_if_needed(std::string_view src, std::string& storage, std::string_view& result)
+	{
+		if (detail::scan<detail::backslash_set>(src.data(), src.data() + src.size()) == src.data() + src.size()) {
+			result = src;
+			return true;
+		}
+		storage.clear();
+		if (!unescape<Mode>(src, storage))
+			return false;
+		result = storage;
+		return true;
+	}
+}
+
+#endif // _ESCAPE_HELPER_HPP_INCLUDED_
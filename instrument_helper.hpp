@@ -0,0 +1,271 @@
+/*
+* Author: LowBoyTeam (https://github.com/LowBoyTeam)
+* License: Code Project Open License
+* Disclaimer: The software is provided "as-is". No claim of suitability, guarantee, or any warranty whatsoever is provided.
+* Copyright (c) 2016-2017.
+*/
+
+#ifndef _INSTRUMENT_HELPER_HPP_INCLUDED_
+#define _INSTRUMENT_HELPER_HPP_INCLUDED_
+
+#include <stdint.h>
+#include <string.h>
+
+#ifdef CPP_UTILS_INSTRUMENT
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <vector>
+#include <algorithm>
+#endif
+
+////////////////////////////////////////////////////////
+// Hot-path instrumentation for the helpers
+//
+//  Define CPP_UTILS_INSTRUMENT (for every translation unit) to count calls,
+//  bytes processed, allocations and elapsed nanoseconds of the helper
+//  functions listed in site_t. Without the define the probe macros expand
+//  to nothing and snapshot() returns zeros, so instrumented helpers cost
+//  exactly what they did before.
+//
+//  Counters live in per-thread, cache-line aligned blocks that only their
+//  own thread writes; snapshot() sums every live thread plus the totals of
+//  threads that have exited.
+//
+//  Usage:
+//    instrument_helper::snapshot_t s = instrument_helper::snapshot();
+//    printf("split: %llu calls\n", s.sites[instrument_helper::kSplit].calls);
+//
+//  Trace spans: set_trace_hooks(on_begin, on_end, context) has on_begin /
+//  on_end called around every probed call, e.g. to feed ETW or a tracer.
+
+namespace instrument_helper
+{
+	enum site_t
+	{
+		kSplit,
+		kReplace,
+		kJoin,
+		kUrlEncode,
+		kUrlDecode,
+		kCryptoUpdate,
+		kFileFind,
+		kSiteCount
+	};
+
+	inline const char* site_name(site_t site)
+	{
+		static const char* names[kSiteCount] = {
+			"string_helper::split", "string_helper::replace", "string_helper::join",
+			"url_helper::url_encode", "url_helper::url_decode",
+			"cryptohash_t::update", "filefinder_helper::find" };
+		return names[site];
+	}
+
+	struct counters_t
+	{
+		uint64_t calls;
+		uint64_t bytes;
+		uint64_t allocations;
+		uint64_t nanoseconds;
+	};
+
+	struct snapshot_t
+	{
+		counters_t sites[kSiteCount];
+	};
+
+	typedef void (*span_begin_fn)(site_t site, void* context);
+	typedef void (*span_end_fn)(site_t site, uint64_t bytes, uint64_t nanoseconds, void* context);
+
+#ifdef CPP_UTILS_INSTRUMENT
+
+	namespace detail
+	{
+		struct alignas(64) site_counters_t
+		{
+			std::atomic<uint64_t> calls;
+			std::atomic<uint64_t> bytes;
+			std::atomic<uint64_t> allocations;
+			std::atomic<uint64_t> nanoseconds;
+		};
+
+		// Single writer (the owning thread), so updates are a relaxed load and
+		// store rather than a locked read-modify-write
+		inline void bump(std::atomic<uint64_t>& counter, uint64_t value)
+		{
+			counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+		}
+
+		inline void add_to(counters_t& total, const site_counters_t& c)
+		{
+			total.calls += c.calls.load(std::memory_order_relaxed);
+			total.bytes += c.bytes.load(std::memory_order_relaxed);
+			total.allocations += c.allocations.load(std::memory_order_relaxed);
+			total.nanoseconds += c.nanoseconds.load(std::memory_order_relaxed);
+		}
+
+		struct thread_block_t;
+
+		struct registry_t
+		{
+			std::mutex lock;
+			std::vector<thread_block_t*> threads;
+			snapshot_t retired;
+			std::atomic<span_begin_fn> on_begin;
+			std::atomic<span_end_fn> on_end;
+			std::atomic<void*> context;
+
+			registry_t() : on_begin(nullptr), on_end(nullptr), context(nullptr) { memset(&retired, 0, sizeof(retired)); }
+		};
+
+		inline registry_t& registry()
+		{
+			static registry_t r;
+			return r;
+		}
+
+		struct thread_block_t
+		{
+			site_counters_t sites[kSiteCount];
+
+			thread_block_t()
+			{
+				for (int i = 0; i < kSiteCount; ++i) {
+					sites[i].calls.store(0);
+					sites[i].bytes.store(0);
+					sites[i].allocations.store(0);
+					sites[i].nanoseconds.store(0);
+				}
+				registry_t& r = registry();
+				std::lock_guard<std::mutex> guard(r.lock);
+				r.threads.push_back(this);
+			}
+
+			~thread_block_t()
+			{
+				registry_t& r = registry();
+				std::lock_guard<std::mutex> guard(r.lock);
+				for (int i = 0; i < kSiteCount; ++i)
+					add_to(r.retired.sites[i], sites[i]);
+				r.threads.erase(std::remove(r.threads.begin(), r.threads.end(), this), r.threads.end());
+			}
+		};
+
+		inline thread_block_t& this_thread()
+		{
+			static thread_local thread_block_t block;
+			return block;
+		}
+
+		inline uint64_t now_ns()
+		{
+			return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+		}
+	}
+
+	// Times one probed call; created by CPP_UTILS_PROBE
+	class scope_t
+	{
+	public:
+		scope_t(site_t site, uint64_t bytes) : m_site(site), m_bytes(bytes)
+		{
+			detail::registry_t& r = detail::registry();
+			span_begin_fn on_begin = r.on_begin.load(std::memory_order_relaxed);
+			if (on_begin)
+				on_begin(site, r.context.load(std::memory_order_relaxed));
+			m_start = detail::now_ns();
+		}
+
+		~scope_t()
+		{
+			uint64_t elapsed = detail::now_ns() - m_start;
+			detail::site_counters_t& c = detail::this_thread().sites[m_site];
+			detail::bump(c.calls, 1);
+			detail::bump(c.bytes, m_bytes);
+			detail::bump(c.nanoseconds, elapsed);
+
+			detail::registry_t& r = detail::registry();
+			span_end_fn on_end = r.on_end.load(std::memory_order_relaxed);
+			if (on_end)
+				on_end(m_site, m_bytes, elapsed, r.context.load(std::memory_order_relaxed));
+		}
+
+	private:
+		scope_t(const scope_t&);
+		scope_t& operator= (const scope_t&);
+
+		site_t m_site;
+		uint64_t m_bytes;
+		uint64_t m_start;
+	};
+
+	inline void count_allocations(site_t site, uint64_t count)
+	{
+		detail::bump(detail::this_thread().sites[site].allocations, count);
+	}
+
+	inline snapshot_t snapshot()
+	{
+		detail::registry_t& r = detail::registry();
+		std::lock_guard<std::mutex> guard(r.lock);
+		snapshot_t s = r.retired;
+		for (size_t t = 0; t < r.threads.size(); ++t) {
+			for (int i = 0; i < kSiteCount; ++i)
+				detail::add_to(s.sites[i], r.threads[t]->sites[i]);
+		}
+		return s;
+	}
+
+	// Forgets the totals of exited threads. Live counters are never reset;
+	// use delta() on two snapshots to measure an interval.
+	inline void reset_retired()
+	{
+		detail::registry_t& r = detail::registry();
+		std::lock_guard<std::mutex> guard(r.lock);
+		memset(&r.retired, 0, sizeof(r.retired));
+	}
+
+	inline void set_trace_hooks(span_begin_fn on_begin, span_end_fn on_end, void* context)
+	{
+		detail::registry_t& r = detail::registry();
+		r.context.store(context);
+		r.on_end.store(on_end);
+		r.on_begin.store(on_begin);
+	}
+
+#define CPP_UTILS_PROBE(site, bytes) instrument_helper::scope_t _cpp_utils_probe_scope_(instrument_helper::site, (uint64_t)(bytes))
+#define CPP_UTILS_COUNT_ALLOC(site, count) instrument_helper::count_allocations(instrument_helper::site, (uint64_t)(count))
+
+#else
+
+	inline snapshot_t snapshot()
+	{
+		snapshot_t s;
+		memset(&s, 0, sizeof(s));
+		return s;
+	}
+
+	inline void reset_retired() {}
+	inline void set_trace_hooks(span_begin_fn, span_end_fn, void*) {}
+
+#define CPP_UTILS_PROBE(site, bytes) ((void)0)
+#define CPP_UTILS_COUNT_ALLOC(site, count) ((void)0)
+
+#endif
+
+	// Difference of two snapshots, e.g. taken before and after a request
+	inline snapshot_t delta(const snapshot_t& before, const snapshot_t& after)
+	{
+		snapshot_t d;
+		for (int i = 0; i < kSiteCount; ++i) {
+			d.sites[i].calls = after.sites[i].calls - before.sites[i].calls;
+			d.sites[i].bytes = after.sites[i].bytes - before.sites[i].bytes;
+			d.sites[i].allocations = after.sites[i].allocations - before.sites[i].allocations;
+			d.sites[i].nanoseconds = after.sites[i].nanoseconds - before.sites[i].nanoseconds;
+		}
+		return d;
+	}
+}
+
+#endif // _INSTRUMENT_HELPER_HPP_INCLUDED_
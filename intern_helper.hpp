@@ -0,0 +1,355 @@
+/*
+* Author: LowBoyTeam (https://github.com/LowBoyTeam)
+* License: Code Project Open License
+* Disclaimer: The software is provided "as-is". No claim of suitability, guarantee, or any warranty whatsoever is provided.
+* Copyright (c) 2016-2017.
+*/
+
+#ifndef _INTERN_HELPER_HPP_INCLUDED_
+#define _INTERN_HELPER_HPP_INCLUDED_
+
+#include <stdint.h>
+#include <string.h>
+#include <atomic>
+#include <mutex>
+#include <memory>
+#include <vector>
+#include <string_view>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+////////////////////////////////////////////////////////
+// Concurrent string interning
+//
+//  intern_table_t maps strings to stable 32-bit ids. Each distinct string is
+//  copied once into an arena and never moves, so view(id) stays valid for
+//  the lifetime of the table and equal tokens compare as equal integers.
+//
+//  The table is split into shards chosen by hash. Inserts lock only their
+//  shard; find(), view() and the lookup half of intern() take no lock at all.
+//  Slots and entries are published with release stores, and a grown slot
+//  array is kept alive until the table is destroyed because readers may
+//  still be probing it.
+//
+//  Usage:
+//    intern_helper::intern_table_t table;
+//    uint32_t get = table.intern("GET");
+//    std::string_view s = table.view(get);
+//
+//    std::vector<uint32_t> ids;
+//    intern_helper::split_interned(table, log_line, " ", ids);
+//    if (ids[0] == get) ...
+
+namespace intern_helper
+{
+	static const uint32_t invalid_id = 0xFFFFFFFFu;
+
+	namespace detail
+	{
+		inline unsigned log2(uint32_t v)
+		{
+#ifdef _MSC_VER
+			unsigned long index;
+			_BitScanReverse(&index, v);
+			return (unsigned)index;
+#else
+			return 31u - (unsigned)__builtin_clz(v);
+#endif
+		}
+
+		inline uint64_t read64(const char* p)
+		{
+			uint64_t v;
+			memcpy(&v, p, sizeof(v));
+			return v;
+		}
+
+		inline uint64_t mix(uint64_t h)
+		{
+			h ^= h >> 33;
+			h *= 0xFF51AFD7ED558CCDULL;
+			h ^= h >> 33;
+			h *= 0xC4CEB9FE1A85EC53ULL;
+			h ^= h >> 33;
+			return h;
+		}
+
+		// Eight bytes per step; tokens are short, so no wider loop is needed
+		inline uint64_t hash(const char* p, size_t n)
+		{
+			uint64_t h = 0x9E3779B97F4A7C15ULL ^ (n * 0xC2B2AE3D27D4EB4FULL);
+			while (n >= 8) {
+				h = (h ^ mix(read64(p))) * 0x9FB21C651E98DF25ULL;
+				p += 8;
+				n -= 8;
+			}
+			uint64_t tail = 0;
+			memcpy(&tail, p, n);
+			return mix(h ^ tail);
+		}
+	}
+
+	class intern_table_t
+	{
+	public:
+		// shard_bits: log2 of the shard count; more shards, less insert contention
+		explicit intern_table_t(unsigned shard_bits = 4) : m_shard_bits(shard_bits > 8 ? 8 : shard_bits)
+		{
+			m_shards.reset(new shard_t[(size_t)1 << m_shard_bits]);
+		}
+
+		~intern_table_t()
+		{
+			for (size_t s = 0; s < shard_count(); ++s) {
+				shard_t& shard = m_shards[s];
+				for (size_t k = 0; k < kMaxChunks; ++k)
+					delete[] shard.chunks[k].load(std::memory_order_relaxed);
+			}
+		}
+
+		// Id of str, adding it if it is new. Returns invalid_id if the shard is
+		// full or str is 4 GB or longer.
+		uint32_t intern(std::string_view str)
+		{
+			const uint64_t h = detail::hash(str.data(), str.size());
+			shard_t& shard = shard_for(h);
+			uint32_t id = lookup(shard, h, str);
+			if (id != invalid_id)
+				return id;
+
+			std::lock_guard<std::mutex> guard(shard.lock);
+			// Another thread may have added it while we were waiting
+			id = lookup(shard, h, str);
+			if (id != invalid_id)
+				return id;
+			return insert(shard, h, str);
+		}
+
+		// Id of str, or invalid_id if it was never interned. Lock-free.
+		uint32_t find(std::string_view str) const
+		{
+			const uint64_t h = detail::hash(str.data(), str.size());
+			return lookup(shard_for(h), h, str);
+		}
+
+		// The interned string; valid until the table is destroyed. Lock-free.
+		// id must have come from intern() on this table.
+		std::string_view view(uint32_t id) const
+		{
+			const entry_t& e = entry(m_shards[id & shard_mask()], id >> m_shard_bits);
+			return std::string_view(e.data, e.size);
+		}
+
+		size_t size() const
+		{
+			size_t n = 0;
+			for (size_t s = 0; s < shard_count(); ++s)
+				n += m_shards[s].count.load(std::memory_order_relaxed);
+			return n;
+		}
+
+	private:
+		intern_table_t(const intern_table_t&);
+		intern_table_t& operator= (const intern_table_t&);
+
+		enum
+		{
+			kChunkBits = 8,					// the first entry chunk holds 256 entries, each next one twice as many
+			kMaxChunks = 32 - kChunkBits,
+			kInitialSlots = 64,
+			kArenaBlock = 64 * 1024
+		};
+
+		struct entry_t
+		{
+			const char* data;
+			uint32_t size;
+		};
+
+		// A slot packs the upper 32 hash bits with id + 1; 0 means empty
+		struct table_t
+		{
+			std::unique_ptr<std::atomic<uint64_t>[]> slots;
+			size_t mask;
+		};
+
+		struct alignas(64) shard_t
+		{
+			shard_t() : current(NULL), count(0), used(0), block_size(0)
+			{
+				for (size_t k = 0; k < kMaxChunks; ++k)
+					chunks[k].store(NULL, std::memory_order_relaxed);
+			}
+
+			std::atomic<table_t*> current;
+			std::atomic<entry_t*> chunks[kMaxChunks];
+			std::atomic<uint32_t> count;
+
+			// Only touched with lock held
+			std::mutex lock;
+			std::vector<std::unique_ptr<table_t> > tables;	// every slot array ever published
+			std::vector<std::unique_ptr<char[]> > blocks;
+			size_t used;
+			size_t block_size;
+		};
+
+		size_t shard_count() const { return (size_t)1 << m_shard_bits; }
+		uint32_t shard_mask() const { return (uint32_t)shard_count() - 1; }
+
+		shard_t& shard_for(uint64_t h) const
+		{
+			// Low bits pick the slot, so the shard comes from the top
+			return m_shards[m_shard_bits ? (size_t)(h >> (64 - m_shard_bits)) : 0];
+		}
+
+		static const entry_t& entry(const shard_t& shard, uint32_t local)
+		{
+			const uint32_t i = local + (1u << kChunkBits);
+			const unsigned k = detail::log2(i) - kChunkBits;
+			return shard.chunks[k].load(std::memory_order_acquire)[i - (1u << (k + kChunkBits))];
+		}
+
+		uint32_t lookup(const shard_t& shard, uint64_t h, std::string_view str) const
+		{
+			const table_t* table = shard.current.load(std::memory_order_acquire);
+			if (table == NULL)
+				return invalid_id;
+
+			const uint32_t tag = (uint32_t)(h >> 32);
+			for (size_t i = (size_t)h & table->mask;; i = (i + 1) & table->mask) {
+				const uint64_t slot = table->slots[i].load(std::memory_order_acquire);
+				if (slot == 0)
+					return invalid_id;
+				if ((uint32_t)(slot >> 32) == tag) {
+					const uint32_t local = (uint32_t)slot - 1;
+					const entry_t& e = entry(shard, local);
+					if (e.size == str.size() && memcmp(e.data, str.data(), str.size()) == 0)
+						return (local << m_shard_bits) | (uint32_t)(&shard - m_shards.get());
+				}
+			}
+		}
+
+		uint32_t insert(shard_t& shard, uint64_t h, std::string_view str)
+		{
+			const uint32_t local = shard.count.load(std::memory_order_relaxed);
+			// Local indices must leave room for the shard bits and the chunk offset
+			if (str.size() > 0xFFFFFFFFu || local >= ((uint64_t)1 << (32 - m_shard_bits)) - (1u << kChunkBits))
+				return invalid_id;
+
+			// Keep the load factor at or below one half
+			table_t* table = shard.current.load(std::memory_order_relaxed);
+			if (table == NULL || (size_t)(local + 1) * 2 > table->mask + 1)
+				table = grow(shard, table);
+
+			// Copy the text into the arena
+			const char* data = "";
+			if (!str.empty()) {
+				if (shard.blocks.empty() || shard.block_size - shard.used < str.size()) {
+					shard.block_size = str.size() > kArenaBlock ? str.size() : (size_t)kArenaBlock;
+					shard.blocks.push_back(std::unique_ptr<char[]>(new char[shard.block_size]));
+					shard.used = 0;
+				}
+				char* copy = shard.blocks.back().get() + shard.used;
+				shard.used += str.size();
+				memcpy(copy, str.data(), str.size());
+				data = copy;
+			}
+
+			// Entry first, so a reader that sees the slot also sees the entry
+			const uint32_t i = local + (1u << kChunkBits);
+			const unsigned k = detail::log2(i) - kChunkBits;
+			entry_t* chunk = shard.chunks[k].load(std::memory_order_relaxed);
+			if (chunk == NULL) {
+				chunk = new entry_t[(size_t)1 << (k + kChunkBits)];
+				shard.chunks[k].store(chunk, std::memory_order_release);
+			}
+			entry_t& e = chunk[i - (1u << (k + kChunkBits))];
+			e.data = data;
+			e.size = (uint32_t)str.size();
+
+			place(*table, h, local);
+			shard.count.store(local + 1, std::memory_order_relaxed);
+			return (local << m_shard_bits) | (uint32_t)(&shard - m_shards.get());
+		}
+
+		static void place(table_t& table, uint64_t h, uint32_t local)
+		{
+			size_t i = (size_t)h & table.mask;
+			while (table.slots[i].load(std::memory_order_relaxed) != 0)
+				i = (i + 1) & table.mask;
+			table.slots[i].store(((h >> 32) << 32) | (local + 1), std::memory_order_release);
+		}
+
+		table_t* grow(shard_t& shard, table_t* old)
+		{
+			const size_t size = old ? (old->mask + 1) * 2 : (size_t)kInitialSlots;
+			std::unique_ptr<table_t> table(new table_t);
+			table->slots.reset(new std::atomic<uint64_t>[size]);
+			table->mask = size - 1;
+			for (size_t i = 0; i < size; ++i)
+				table->slots[i].store(0, std::memory_order_relaxed);
+
+			// Rehash from the stored text; ids do not change
+			const uint32_t count = shard.count.load(std::memory_order_relaxed);
+			for (uint32_t local = 0; local < count; ++local) {
+				const entry_t& e = entry(shard, local);
+				place(*table, detail::hash(e.data, e.size), local);
+			}
+
+			table_t* published = table.get();
+			shard.tables.push_back(std::move(table));
+			shard.current.store(published, std::memory_order_release);
+			return published;
+		}
+
+		unsigned m_shard_bits;
+		std::unique_ptr<shard_t[]> m_shards;
+	};
+
+	// Like string_helper::split, but appends the id of every token to ids
+	// instead of building strings. A token the table cannot take gets
+	// invalid_id. Returns the number of ids appended.
+	inline size_t split_interned(intern_table_t& table, std::string_view str, std::string_view delim, std::vector<uint32_t>& ids, bool trim_empty = false)
+	{
+		const size_t before = ids.size();
+		size_t pos, last_pos = 0;
+		while (true) {
+			pos = delim.empty() ? std::string_view::npos : str.find(delim, last_pos);
+			if (pos == std::string_view::npos)
+				pos = str.size();
+			if (!trim_empty || pos != last_pos)
+				ids.push_back(table.intern(str.substr(last_pos, pos - last_pos)));
+			if (pos == str.size())
+				break;
+			last_pos = pos + delim.size();
+		}
+		return ids.size() - before;
+	}
+
+	// Interned views of the tokens, for code that wants text but not copies.
+	// A token the table cannot take (see intern()) is appended as a view into
+	// str instead, valid only as long as str is.
+	inline size_t split_interned(intern_table_t& table, std::string_view str, std::string_view delim, std::vector<std::string_view>& tokens, bool trim_empty = false)
+	{
+		const size_t before = tokens.size();
+		size_t pos, last_pos = 0;
+		while (true) {
+			pos = delim.empty() ? std::string_view::npos : str.find(delim, last_pos);
+			if (pos == std::string_view::npos)
+				pos = str.size();
+			if (!trim_empty || pos != last_pos) {
+				const std::string_view token = str.substr(last_pos, pos - last_pos);
+				const uint32_t id = table.intern(token);
+				tokens.push_back(id != invalid_id ? table.view(id) : token);
+			}
+			if (pos == str.size())
+				break;
+			last_pos = pos + delim.size();
+		}
+		return tokens.size() - before;
+	}
+}
+
+#endif // _INTERN_HELPER_HPP_INCLUDED_
@@ -0,0 +1,621 @@
+/*
+* Author: LowBoyTeam (https://github.com/LowBoyTeam)
+* License: Code Project Open License
+* Disclaimer: The software is provided "as-is". No claim of suitability, guarantee, or any warranty whatsoever is provided.
+* Copyright (c) 2016-2017.
+*/
+
+#ifndef _LINEINDEX_HELPER_HPP_INCLUDED_
+#define _LINEINDEX_HELPER_HPP_INCLUDED_
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "cpu_helper.hpp"
+#include "mmap_helper.hpp"
+
+////////////////////////////////////////////////////////
+// Line-offset index for large text files
+//
+//  line_index_t records where every 64th line starts, so line N is found
+//  by jumping to the start of line N - N % 64 and stepping over at most 63
+//  newlines, instead of splitting the whole file. The sampled offsets are
+//  kept as varint gaps (LEB128), one or two bytes each for typical log
+//  lines, with an absolute offset every 64 samples so a lookup decodes at
+//  most 63 of them. A 10 GB log of 100-byte lines needs about 4 MB.
+//
+//  Building maps nothing itself; it scans a buffer in parallel chunks. A
+//  first pass counts the newlines of every chunk (SSE2, or AVX2 chosen at
+//  run time through cpu_helper), which numbers the lines at each chunk
+//  start; a second pass collects the samples of every chunk. extend()
+//  indexes only the bytes added since the last build.
+//
+//  indexed_file_t maps a file and keeps the index in a sidecar file next to
+//  it (<path>.lidx by default). open() loads the sidecar when it matches
+//  the file, indexes only what was appended since it was written, and
+//  rebuilds it when the file was replaced or truncated; a file counts as
+//  the same when its first and last indexed 4 KB hash the same. The
+//  sidecar is written to a temporary file and renamed over the old one.
+//  If it cannot be written the index still works from memory.
+//
+//  Lines end at '\n'; line() drops a '\r' before it. A final line without
+//  '\n' counts as a line.
+//
+//  Usage:
+//    lineindex_helper::indexed_file_t log;
+//    if (!log.open(L"D:\\logs\\service.log", 0))   // 0 = every core
+//        return false;
+//    std::string_view line = log.line(1234567);
+//    std::string_view page = log.range(1000, 50);   // lines 1000..1049, newlines included
+//    ...
+//    log.refresh();                                 // pick up lines appended since;
+//                                                   // line and page last until the next refresh()
+
+namespace lineindex_helper
+{
+	namespace detail
+	{
+		// Number of '\n' in [p, p + n)
+		typedef uint64_t count_fn(const char* p, size_t n);
+
+		// Appends base + i + 1 to out for the newline at i that is the skip-th
+		// (from 0) in [p, p + n) and for every 64th one after it. Returns how
+		// many newlines the next buffer has to skip to continue the series.
+		typedef uint64_t sample_fn(const char* p, size_t n, uint64_t base, uint64_t skip, std::vector<uint64_t>& out);
+
+		inline uint64_t count_scalar(const char* p, size_t n)
+		{
+			uint64_t count = 0;
+			for (size_t i = 0; i < n; ++i)
+				count += p[i] == '\n';
+			return count;
+		}
+
+		// Takes the samples out of one block's newline mask
+		inline uint64_t sample_block(uint64_t mask, uint64_t base, uint64_t skip, std::vector<uint64_t>& out)
+		{
+			uint64_t count = cpu_helper::popcount64(mask);
+			while (skip < count) {
+				for (uint64_t j = 0; j < skip; ++j)
+					mask &= mask - 1;
+				out.push_back(base + cpu_helper::ctz64(mask) + 1);
+				mask &= mask - 1;
+				count -= skip + 1;
+				skip = 63;
+			}
+			return skip - count;
+		}
+
+		inline uint64_t sample_scalar(const char* p, size_t n, uint64_t base, uint64_t skip, std::vector<uint64_t>& out)
+		{
+			for (size_t i = 0; i < n; ++i) {
+				if (p[i] != '\n')
+					continue;
+				if (skip == 0) {
+					out.push_back(base + i + 1);
+					skip = 63;
+				}
+				else {
+					--skip;
+				}
+			}
+			return skip;
+		}
+
+		inline uint64_t count_sse2(const char* p, size_t n)
+		{
+			uint64_t count = 0;
+			size_t i = 0;
+#ifdef CPU_HELPER_HAS_SSE2
+			// Per-byte counters (cmpeq gives -1, subtracting it adds one), folded
+			// into count with SAD before any of them can reach 256
+			const __m128i nl = _mm_set1_epi8('\n');
+			while (i + 16 <= n) {
+				__m128i acc = _mm_setzero_si128();
+				for (int k = 0; k < 255 && i + 16 <= n; ++k, i += 16)
+					acc = _mm_sub_epi8(acc, _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(p + i)), nl));
+				const __m128i sums = _mm_sad_epu8(acc, _mm_setzero_si128());
+				count += (uint64_t)_mm_cvtsi128_si32(sums) + (uint64_t)_mm_cvtsi128_si32(_mm_srli_si128(sums, 8));
+			}
+#endif
+			return count + count_scalar(p + i, n - i);
+		}
+
+		inline uint64_t sample_sse2(const char* p, size_t n, uint64_t base, uint64_t skip, std::vector<uint64_t>& out)
+		{
+			size_t i = 0;
+#ifdef CPU_HELPER_HAS_SSE2
+			const __m128i nl = _mm_set1_epi8('\n');
+			for (; i + 64 <= n; i += 64) {
+				uint64_t mask = 0;
+				for (int k = 0; k < 4; ++k)
+					mask |= (uint64_t)(unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(p + i + 16 * k)), nl)) << (16 * k);
+				if (mask)
+					skip = sample_block(mask, base + i, skip, out);
+			}
+#endif
+			return sample_scalar(p + i, n - i, base + i, skip, out);
+		}
+
+#ifdef CPU_HELPER_X86
+		CPU_HELPER_TARGET_AVX2 inline uint64_t count_avx2(const char* p, size_t n)
+		{
+			uint64_t count = 0;
+			size_t i = 0;
+			const __m256i nl = _mm256_set1_epi8('\n');
+			while (i + 32 <= n) {
+				__m256i acc = _mm256_setzero_si256();
+				for (int k = 0; k < 255 && i + 32 <= n; ++k, i += 32)
+					acc = _mm256_sub_epi8(acc, _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(p + i)), nl));
+				const __m256i sad = _mm256_sad_epu8(acc, _mm256_setzero_si256());
+				const __m128i sums = _mm_add_epi32(_mm256_castsi256_si128(sad), _mm256_extracti128_si256(sad, 1));
+				count += (uint64_t)_mm_cvtsi128_si32(sums) + (uint64_t)_mm_cvtsi128_si32(_mm_srli_si128(sums, 8));
+			}
+			return count + count_sse2(p + i, n - i);
+		}
+
+		CPU_HELPER_TARGET_AVX2 inline uint64_t sample_avx2(const char* p, size_t n, uint64_t base, uint64_t skip, std::vector<uint64_t>& out)
+		{
+			size_t i = 0;
+			const __m256i nl = _mm256_set1_epi8('\n');
+			for (; i + 64 <= n; i += 64) {
+				const uint64_t mask = (uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(p + i)), nl))
+					| ((uint64_t)(uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(p + i + 32)), nl)) << 32);
+				if (mask)
+					skip = sample_block(mask, base + i, skip, out);
+			}
+			return sample_scalar(p + i, n - i, base + i, skip, out);
+		}
+#endif
+
+		inline cpu_helper::dispatch_t<count_fn>& count_kernel()
+		{
+			static cpu_helper::dispatch_t<count_fn> kernel = {
+#ifdef CPU_HELPER_X86
+				{ cpu_helper::kAVX2, count_avx2 },
+#endif
+#ifdef CPU_HELPER_HAS_SSE2
+				{ cpu_helper::kSSE2, count_sse2 },
+#endif
+				{ 0, count_scalar } };
+			return kernel;
+		}
+
+		inline cpu_helper::dispatch_t<sample_fn>& sample_kernel()
+		{
+			static cpu_helper::dispatch_t<sample_fn> kernel = {
+#ifdef CPU_HELPER_X86
+				{ cpu_helper::kAVX2, sample_avx2 },
+#endif
+#ifdef CPU_HELPER_HAS_SSE2
+				{ cpu_helper::kSSE2, sample_sse2 },
+#endif
+				{ 0, sample_scalar } };
+			return kernel;
+		}
+
+		// FNV-1a, to recognise the file an index was built from
+		inline uint64_t fnv1a(const char* p, size_t n)
+		{
+			uint64_t h = 0xCBF29CE484222325ULL;
+			for (size_t i = 0; i < n; ++i) {
+				h ^= (unsigned char)p[i];
+				h *= 0x100000001B3ULL;
+			}
+			return h;
+		}
+
+		inline void put_varint(std::string& out, uint64_t v)
+		{
+			while (v >= 0x80) {
+				out.push_back((char)(v | 0x80));
+				v >>= 7;
+			}
+			out.push_back((char)v);
+		}
+
+		inline uint64_t get_varint(const char*& p)
+		{
+			uint64_t v = 0;
+			for (unsigned shift = 0;; shift += 7) {
+				const unsigned char c = (unsigned char)*p++;
+				v |= (uint64_t)(c & 0x7F) << shift;
+				if (c < 0x80)
+					return v;
+			}
+		}
+
+		inline void put64(std::string& out, uint64_t v)
+		{
+			for (int i = 0; i < 8; ++i)
+				out.push_back((char)(v >> (8 * i)));
+		}
+
+		inline uint64_t get64(const char* p)
+		{
+			uint64_t v = 0;
+			for (int i = 0; i < 8; ++i)
+				v |= (uint64_t)(unsigned char)p[i] << (8 * i);
+			return v;
+		}
+	}
+
+	class line_index_t
+	{
+	public:
+		static const size_t kStride = 64;
+		static const size_t kFingerprint = 4096;
+
+		line_index_t()
+		{
+			clear();
+		}
+
+		void clear()
+		{
+			m_size = 0;
+			m_newlines = 0;
+			m_samples = 0;
+			m_last_sample = 0;
+			m_ends_with_newline = true;
+			m_head_hash = m_tail_hash = detail::fnv1a(NULL, 0);
+			m_anchors.clear();
+			m_stream.clear();
+			add_sample(0);
+		}
+
+		// Indexes data from scratch; threads = 0 uses every core
+		void build(std::string_view data, unsigned threads = 1)
+		{
+			clear();
+			extend(data, threads);
+		}
+
+		// Indexes what data holds past size(); data must start with the bytes
+		// that were indexed (matches() tells whether it does)
+		void extend(std::string_view data, unsigned threads = 1)
+		{
+			if (data.size() <= m_size)
+				return;
+			const char* p = data.data();
+			const size_t begin = (size_t)m_size, end = data.size();
+
+			const size_t count = cpu_helper::chunk_count(end - begin, threads, kMinChunk);
+			std::vector<size_t> bounds(count + 1);
+			for (size_t c = 0; c <= count; ++c)
+				bounds[c] = begin + (end - begin) / count * c;
+			bounds[count] = end;
+
+			// Pass 1: newlines per chunk give the line number at every chunk start
+			std::vector<uint64_t> first(count + 1, m_newlines);
+			if (count > 1) {
+				detail::count_fn* newlines = detail::count_kernel().get();
+				std::vector<uint64_t> counts(count, 0);
+				cpu_helper::run_parallel(count, [&](size_t c) {
+					counts[c] = newlines(p + bounds[c], bounds[c + 1] - bounds[c]);
+				});
+				for (size_t c = 0; c < count; ++c)
+					first[c + 1] = first[c] + counts[c];
+			}
+
+			// Pass 2: the samples of every chunk. Newline k starts line k + 1, and
+			// lines that are a multiple of kStride are sampled.
+			detail::sample_fn* sample = detail::sample_kernel().get();
+			std::vector<std::vector<uint64_t> > samples(count);
+			std::vector<uint64_t> skips(count, 0);
+			cpu_helper::run_parallel(count, [&](size_t c) {
+				const uint64_t skip = (kStride - 1) - first[c] % kStride;
+				samples[c].reserve((bounds[c + 1] - bounds[c]) / 4096);
+				skips[c] = sample(p + bounds[c], bounds[c + 1] - bounds[c], bounds[c], skip, samples[c]);
+			});
+
+			for (size_t c = 0; c < count; ++c) {
+				for (size_t i = 0; i < samples[c].size(); ++i)
+					add_sample(samples[c][i]);
+			}
+			// Without pass 1 the total follows from the samples and where the
+			// series stopped
+			if (count == 1)
+				m_newlines = (m_samples - 1) * kStride + (kStride - 1 - skips[0]);
+			else
+				m_newlines = first[count];
+
+			m_size = end;
+			m_ends_with_newline = p[end - 1] == '\n';
+			const size_t head = end < kFingerprint ? end : kFingerprint;
+			m_head_hash = detail::fnv1a(p, head);
+			m_tail_hash = detail::fnv1a(p + end - head, head);
+		}
+
+		// True if data starts with the bytes this index was built from, as far
+		// as the first and last kFingerprint of them tell
+		bool matches(std::string_view data) const
+		{
+			if (data.size() < m_size)
+				return false;
+			const size_t head = m_size < kFingerprint ? (size_t)m_size : kFingerprint;
+			return detail::fnv1a(data.data(), head) == m_head_hash && detail::fnv1a(data.data() + m_size - head, head) == m_tail_hash;
+		}
+
+		// Bytes indexed
+		uint64_t size() const { return m_size; }
+
+		uint64_t lines() const
+		{
+			return m_newlines + (m_ends_with_newline ? 0 : 1);
+		}
+
+		// Offset of the start of line n (n <= lines()) in data, the buffer the
+		// index was built from. lines() itself gives the end of the last line.
+		uint64_t offset(std::string_view data, uint64_t n) const
+		{
+			if (n >= lines())
+				return m_size;
+			uint64_t at = sample(n / kStride);
+			for (uint64_t r = n % kStride; r > 0; --r) {
+				const char* nl = (const char*)memchr(data.data() + at, '\n', (size_t)(m_size - at));
+				at = (uint64_t)(nl - data.data()) + 1;
+			}
+			return at;
+		}
+
+		// Line n of data without its "\n" or "\r\n"; empty past the last line
+		std::string_view line(std::string_view data, uint64_t n) const
+		{
+			if (n >= lines())
+				return std::string_view();
+			const size_t start = (size_t)offset(data, n);
+			const char* nl = (const char*)memchr(data.data() + start, '\n', (size_t)m_size - start);
+			size_t end = nl ? (size_t)(nl - data.data()) : (size_t)m_size;
+			if (end > start && data[end - 1] == '\r')
+				--end;
+			return data.substr(start, end - start);
+		}
+
+		// Lines [first, first + count) of data as one view, newlines included
+		std::string_view range(std::string_view data, uint64_t first, uint64_t count) const
+		{
+			if (first > lines())
+				first = lines();
+			const uint64_t last = count < lines() - first ? first + count : lines();
+			const size_t begin = (size_t)offset(data, first);
+			return data.substr(begin, (size_t)offset(data, last) - begin);
+		}
+
+		// Sidecar form: header, anchors, varint gaps, then a checksum of all that
+		void save(std::string& out) const
+		{
+			out.clear();
+			out.append(kMagic, 4);
+			detail::put64(out, kVersion | ((uint64_t)kStride << 32));
+			detail::put64(out, m_size);
+			detail::put64(out, m_newlines);
+			detail::put64(out, m_ends_with_newline ? 1 : 0);
+			detail::put64(out, m_head_hash);
+			detail::put64(out, m_tail_hash);
+			detail::put64(out, m_samples);
+			detail::put64(out, m_last_sample);
+			detail::put64(out, m_stream.size());
+			for (size_t i = 0; i < m_anchors.size(); ++i)
+				detail::put64(out, m_anchors[i]);
+			out.append(m_stream);
+			detail::put64(out, detail::fnv1a(out.data(), out.size()));
+		}
+
+		// Reads what save() wrote; false (and an empty index) if it is not that
+		bool load(std::string_view in)
+		{
+			clear();
+			const size_t header = 4 + 9 * 8;
+			if (in.size() < header + 8 || memcmp(in.data(), kMagic, 4) != 0)
+				return false;
+			if (detail::get64(in.data() + in.size() - 8) != detail::fnv1a(in.data(), in.size() - 8))
+				return false;
+			const char* p = in.data() + 4;
+			if (detail::get64(p) != (kVersion | ((uint64_t)kStride << 32)))
+				return false;
+			const uint64_t samples = detail::get64(p + 48), stream = detail::get64(p + 64);
+			const uint64_t anchors = (samples + kStride - 1) / kStride;
+			if (samples == 0 || anchors > (in.size() - header) / 16 || header + anchors * 16 + stream + 8 != in.size())
+				return false;
+
+			m_size = detail::get64(p + 8);
+			m_newlines = detail::get64(p + 16);
+			m_ends_with_newline = detail::get64(p + 24) != 0;
+			m_head_hash = detail::get64(p + 32);
+			m_tail_hash = detail::get64(p + 40);
+			m_samples = samples;
+			m_last_sample = detail::get64(p + 56);
+			m_anchors.resize((size_t)anchors * 2);
+			for (size_t i = 0; i < m_anchors.size(); ++i)
+				m_anchors[i] = detail::get64(in.data() + header + 8 * i);
+			m_stream.assign(in.data() + header + anchors * 16, (size_t)stream);
+			bool valid = m_newlines / kStride + 1 == m_samples && m_last_sample <= m_size;
+			for (size_t i = 0; i < m_anchors.size(); i += 2)
+				valid = valid && m_anchors[i] <= m_size && m_anchors[i + 1] <= stream;
+			if (!valid) {
+				clear();
+				return false;
+			}
+			return true;
+		}
+
+	private:
+		static constexpr char kMagic[5] = "LIDX";
+		enum { kVersion = 1 };
+		static const size_t kMinChunk = 1 << 20;
+
+		void add_sample(uint64_t offset)
+		{
+			if (m_samples % kStride == 0) {
+				m_anchors.push_back(offset);
+				m_anchors.push_back(m_stream.size());
+			}
+			else {
+				detail::put_varint(m_stream, offset - m_last_sample);
+			}
+			m_last_sample = offset;
+			++m_samples;
+		}
+
+		// Start of line k * kStride
+		uint64_t sample(uint64_t k) const
+		{
+			const size_t a = (size_t)(k / kStride) * 2;
+			uint64_t at = m_anchors[a];
+			const char* p = m_stream.data() + m_anchors[a + 1];
+			for (uint64_t r = k % kStride; r > 0; --r)
+				at += detail::get_varint(p);
+			return at;
+		}
+
+		uint64_t m_size;
+		uint64_t m_newlines;
+		uint64_t m_samples;
+		uint64_t m_last_sample;
+		bool m_ends_with_newline;
+		uint64_t m_head_hash;
+		uint64_t m_tail_hash;
+		std::vector<uint64_t> m_anchors;	// per kStride samples: offset, then position in m_stream
+		std::string m_stream;				// gaps between consecutive samples, LEB128
+	};
+
+	class indexed_file_t
+	{
+	public:
+		indexed_file_t() : m_threads(1), m_file(new mmap_helper::mapped_file_t) {}
+
+		// Maps the file and brings the index up to date from the sidecar,
+		// rebuilding or extending it as needed; threads = 0 uses every core
+#ifdef _WIN32
+		BOOL open(LPCWSTR pszPath, unsigned threads = 1)
+		{
+			return open(pszPath, (std::wstring(pszPath) + L".lidx").c_str(), threads);
+		}
+
+		BOOL open(LPCWSTR pszPath, LPCWSTR pszSidecar, unsigned threads = 1)
+		{
+			m_path = pszPath;
+			m_sidecar = pszSidecar;
+			m_threads = threads;
+			mmap_helper::mapped_file_t sidecar;
+			if (sidecar.open(pszSidecar))
+				m_index.load(sidecar.view());
+			return refresh();
+		}
+#else
+		bool open(const char* path, unsigned threads = 1)
+		{
+			return open(path, (std::string(path) + ".lidx").c_str(), threads);
+		}
+
+		bool open(const char* path, const char* sidecar_path, unsigned threads = 1)
+		{
+			m_path = path;
+			m_sidecar = sidecar_path;
+			m_threads = threads;
+			mmap_helper::mapped_file_t sidecar;
+			if (sidecar.open(sidecar_path))
+				m_index.load(sidecar.view());
+			return refresh();
+		}
+#endif
+
+		// Maps the file again and indexes what was appended to it (or all of
+		// it, if it was replaced); saves the sidecar if anything changed.
+		// Views returned before refresh() point into the old mapping, which
+		// is kept until the next refresh() or until this object is destroyed.
+		bool refresh()
+		{
+			m_previous = std::move(m_file);
+			m_file.reset(new mmap_helper::mapped_file_t);
+			if (!m_file->open(m_path.c_str())) {
+				m_index.clear();
+				return false;
+			}
+			const std::string_view data = m_file->view();
+			bool changed = false;
+			if (!m_index.matches(data)) {
+				m_index.clear();
+				changed = true;
+			}
+			if (data.size() > m_index.size()) {
+				m_index.extend(data, m_threads);
+				changed = true;
+			}
+			if (changed)
+				save();
+			return true;
+		}
+
+		uint64_t lines() const { return m_index.lines(); }
+		std::string_view line(uint64_t n) const { return m_index.line(m_file->view(), n); }
+		std::string_view range(uint64_t first, uint64_t count) const { return m_index.range(m_file->view(), first, count); }
+		uint64_t offset(uint64_t n) const { return m_index.offset(m_file->view(), n); }
+
+		const line_index_t& index() const { return m_index; }
+		std::string_view data() const { return m_file->view(); }
+
+	private:
+		indexed_file_t(const indexed_file_t&);
+		indexed_file_t& operator= (const indexed_file_t&);
+
+		// Best effort: written beside the target, then renamed over it
+		bool save() const
+		{
+			std::string bytes;
+			m_index.save(bytes);
+#ifdef _WIN32
+			const std::wstring temp = m_sidecar + L".tmp";
+			HANDLE hFile = ::CreateFileW(temp.c_str(), GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+			if (hFile == INVALID_HANDLE_VALUE)
+				return false;
+			DWORD cbDone = 0;
+			const BOOL bWritten = ::WriteFile(hFile, bytes.data(), (DWORD)bytes.size(), &cbDone, NULL) && cbDone == bytes.size();
+			::CloseHandle(hFile);
+			if (!bWritten || !::MoveFileExW(temp.c_str(), m_sidecar.c_str(), MOVEFILE_REPLACE_EXISTING)) {
+				::DeleteFileW(temp.c_str());
+				return false;
+			}
+			return true;
+#else
+			const std::string temp = m_sidecar + ".tmp";
+			const int fd = ::open(temp.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+			if (fd < 0)
+				return false;
+			size_t done = 0;
+			while (done < bytes.size()) {
+				const ssize_t n = ::write(fd, bytes.data() + done, bytes.size() - done);
+				if (n <= 0)
+					break;
+				done += (size_t)n;
+			}
+			::close(fd);
+			if (done != bytes.size() || ::rename(temp.c_str(), m_sidecar.c_str()) != 0) {
+				::unlink(temp.c_str());
+				return false;
+			}
+			return true;
+#endif
+		}
+
+#ifdef _WIN32
+		std::wstring m_path;
+		std::wstring m_sidecar;
+#else
+		std::string m_path;
+		std::string m_sidecar;
+#endif
+		unsigned m_threads;
+		std::unique_ptr<mmap_helper::mapped_file_t> m_file;
+		std::unique_ptr<mmap_helper::mapped_file_t> m_previous;	// what views from before the last refresh() point into
+		line_index_t m_index;
+	};
+}
+
+#endif // _LINEINDEX_HELPER_HPP_INCLUDED_
@@ -0,0 +1,254 @@
+/*
+* Author: LowBoyTeam (https://github.com/LowBoyTeam)
+* License: Code Project Open License
+* Disclaimer: The software is provided "as-is". No claim of suitability, guarantee, or any warranty whatsoever is provided.
+* Copyright (c) 2016-2017.
+*/
+
+#ifndef _MATCHER_HELPER_HPP_INCLUDED_
+#define _MATCHER_HELPER_HPP_INCLUDED_
+
+#include <stdint.h>
+#include <string.h>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <map>
+#include <algorithm>
+
+#include "cpu_helper.hpp"
+
+////////////////////////////////////////////////////////
+// Compiled prefix / suffix sets
+//
+//  Testing a string against hundreds of string_helper::is_start_with rules
+//  costs one comparison per rule. prefix_matcher_t compiles the rules into a
+//  path-compressed trie instead, so a lookup costs one step per input byte
+//  no matter how many rules there are. Nodes with up to 16 children keep
+//  their edge bytes in one 16-byte block that is searched with a single
+//  SSE2 compare; busier nodes (typically the root) use a 256-entry table.
+//
+//  suffix_matcher_t does the same for is_end_with, walking the input from
+//  its end. Rule ids are the indices of the patterns as given; a repeated
+//  pattern keeps its first id.
+//
+//  Usage:
+//    matcher_helper::prefix_matcher_t routes(std::vector<std::string>{ "/api/", "/api/v2/", "/static/" });
+//    size_t rule = routes.longest(path);             // 1 for "/api/v2/users"
+//    if (rule != matcher_helper::npos) ...
+//
+//    std::vector<size_t> rules;
+//    routes.all(path, rules);                        // { 0, 1 }, shortest first
+
+namespace matcher_helper
+{
+	static const size_t npos = (size_t)-1;
+
+	template <bool Suffix>
+	class basic_matcher_t
+	{
+	public:
+		basic_matcher_t() {}
+
+		// patterns: any container of strings or string views
+		template <class Patterns>
+		explicit basic_matcher_t(const Patterns& patterns)
+		{
+			assign(patterns);
+		}
+
+		template <class Patterns>
+		void assign(const Patterns& patterns)
+		{
+			m_patterns.clear();
+			for (const auto& p : patterns)
+				m_patterns.push_back(std::string(p.data(), p.size()));
+			compile();
+		}
+
+		size_t size() const { return m_patterns.size(); }
+		const std::string& pattern(size_t rule) const { return m_patterns[rule]; }
+
+		// The longest matching rule, or npos
+		size_t longest(std::string_view str) const
+		{
+			size_t result = npos;
+			walk(str, [&result](uint32_t rule) { result = rule; });
+			return result;
+		}
+
+		bool matches(std::string_view str) const
+		{
+			return longest(str) != npos;
+		}
+
+		// Appends every matching rule, shortest pattern first; returns how many
+		size_t all(std::string_view str, std::vector<size_t>& rules) const
+		{
+			const size_t before = rules.size();
+			walk(str, [&rules](uint32_t rule) { rules.push_back(rule); });
+			return rules.size() - before;
+		}
+
+	private:
+		enum { kSmallNode = 16 };
+		static const uint32_t kNoRule = 0xFFFFFFFFu;
+
+		struct node_t
+		{
+			uint32_t label_offset;	// bytes after the edge byte that must also match
+			uint32_t label_length;
+			uint32_t rule;
+			uint32_t child_begin;	// into m_children
+			uint32_t key_offset;	// into m_keys, small nodes only
+			uint16_t child_count;
+			bool dense;				// m_children holds 256 entries indexed by byte
+		};
+
+		// Uncompressed trie used while compiling
+		struct build_node_t
+		{
+			std::map<unsigned char, uint32_t> next;
+			uint32_t rule;
+		};
+
+		void compile()
+		{
+			m_nodes.clear();
+			m_children.clear();
+			m_keys.clear();
+			m_labels.clear();
+
+			std::vector<build_node_t> trie(1);
+			trie[0].rule = kNoRule;
+			for (size_t r = 0; r < m_patterns.size(); ++r) {
+				const std::string& p = m_patterns[r];
+				uint32_t t = 0;
+				for (size_t i = 0; i < p.size(); ++i) {
+					const unsigned char c = (unsigned char)(Suffix ? p[p.size() - 1 - i] : p[i]);
+					auto it = trie[t].next.find(c);
+					if (it == trie[t].next.end()) {
+						build_node_t n;
+						n.rule = kNoRule;
+						trie.push_back(n);
+						it = trie[t].next.insert(std::make_pair(c, (uint32_t)(trie.size() - 1))).first;
+					}
+					t = it->second;
+				}
+				if (trie[t].rule == kNoRule)
+					trie[t].rule = (uint32_t)r;
+			}
+			emit(trie, 0);
+		}
+
+		// Flattens the subtree at t, merging chains of single-child, rule-less
+		// nodes into one label. Returns the index of the flat node.
+		uint32_t emit(const std::vector<build_node_t>& trie, uint32_t t)
+		{
+			std::string label;
+			while (trie[t].rule == kNoRule && trie[t].next.size() == 1) {
+				label += (char)trie[t].next.begin()->first;
+				t = trie[t].next.begin()->second;
+			}
+			// The walk for a suffix set meets the label back to front, so store it
+			// in text order and compare it against the bytes just before the cursor
+			if (Suffix)
+				std::reverse(label.begin(), label.end());
+
+			const uint32_t index = (uint32_t)m_nodes.size();
+			node_t node;
+			node.label_offset = (uint32_t)m_labels.size();
+			node.label_length = (uint32_t)label.size();
+			node.rule = trie[t].rule;
+			node.child_count = (uint16_t)trie[t].next.size();
+			node.dense = node.child_count > kSmallNode;
+			node.child_begin = (uint32_t)m_children.size();
+			node.key_offset = 0;
+			m_labels += label;
+
+			// Reserve the child slots before recursing so they stay contiguous
+			if (node.dense) {
+				m_children.resize(m_children.size() + 256, 0);
+			}
+			else if (node.child_count) {
+				m_children.resize(m_children.size() + node.child_count, 0);
+				node.key_offset = (uint32_t)m_keys.size();
+				m_keys.resize(m_keys.size() + kSmallNode, 0);
+				size_t k = 0;
+				for (auto it = trie[t].next.begin(); it != trie[t].next.end(); ++it)
+					m_keys[node.key_offset + k++] = it->first;
+			}
+			m_nodes.push_back(node);
+
+			size_t k = 0;
+			for (auto it = trie[t].next.begin(); it != trie[t].next.end(); ++it, ++k) {
+				const uint32_t child = emit(trie, it->second);
+				m_children[node.child_begin + (node.dense ? it->first : k)] = child;
+			}
+			return index;
+		}
+
+		// Index of the child reached by byte c, or 0 (the root is nobody's child)
+		uint32_t child(const node_t& node, unsigned char c) const
+		{
+			if (node.dense)
+				return m_children[node.child_begin + c];
+#ifdef CPU_HELPER_HAS_SSE2
+			const __m128i keys = _mm_loadu_si128((const __m128i*)(m_keys.data() + node.key_offset));
+			const unsigned mask = (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(keys, _mm_set1_epi8((char)c))) & ((1u << node.child_count) - 1);
+			if (mask == 0)
+				return 0;
+			return m_children[node.child_begin + cpu_helper::ctz32(mask)];
+#else
+			const unsigned char* keys = m_keys.data() + node.key_offset;
+			for (unsigned k = 0; k < node.child_count; ++k) {
+				if (keys[k] == c)
+					return m_children[node.child_begin + k];
+			}
+			return 0;
+#endif
+		}
+
+		// Calls on_rule for every rule that matches, shortest first
+		template <class F>
+		void walk(std::string_view str, F on_rule) const
+		{
+			if (m_nodes.empty())
+				return;
+			const char* s = str.data();
+			const size_t len = str.size();
+			size_t pos = 0;		// bytes consumed, from the front or from the back
+			uint32_t n = 0;
+			for (;;) {
+				const node_t& node = m_nodes[n];
+				if (node.label_length) {
+					if (len - pos < node.label_length)
+						return;
+					const char* at = Suffix ? s + len - pos - node.label_length : s + pos;
+					if (memcmp(at, m_labels.data() + node.label_offset, node.label_length) != 0)
+						return;
+					pos += node.label_length;
+				}
+				if (node.rule != kNoRule)
+					on_rule(node.rule);
+				if (pos == len || node.child_count == 0)
+					return;
+				n = child(node, (unsigned char)(Suffix ? s[len - 1 - pos] : s[pos]));
+				if (n == 0)
+					return;
+				++pos;
+			}
+		}
+
+		std::vector<std::string> m_patterns;
+		std::vector<node_t> m_nodes;
+		std::vector<uint32_t> m_children;
+		std::vector<unsigned char> m_keys;
+		std::string m_labels;
+	};
+
+	typedef basic_matcher_t<false> prefix_matcher_t;
+	typedef basic_matcher_t<true> suffix_matcher_t;
+}
+
+#endif // _MATCHER_HELPER_HPP_INCLUDED_
@@ -0,0 +1,155 @@
+/*
+* Author: LowBoyTeam (https://github.com/LowBoyTeam)
+* License: Code Project Open License
+* Disclaimer: The software is provided "as-is". No claim of suitability, guarantee, or any warranty whatsoever is provided.
+* Copyright (c) 2016-2017.
+*/
+
+#ifndef _MMAP_HELPER_HPP_INCLUDED_
+#define _MMAP_HELPER_HPP_INCLUDED_
+
+#include <stddef.h>
+#include <string_view>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+////////////////////////////////////////////////////////
+// Read-only memory-mapped file
+//
+//  Maps a whole file into memory so parsers can work on it as one buffer.
+//  An empty file opens successfully with size() == 0 and data() == NULL.
+//  The file stays open to writers, so a log can be mapped while it grows;
+//  the mapping covers the size it had at open().
+//
+//  Usage:
+//    mmap_helper::mapped_file_t file;
+//    if (file.open(L"C:\\logs\\access.csv"))
+//        parse(file.view());
+
+namespace mmap_helper
+{
+	class mapped_file_t
+	{
+	public:
+		mapped_file_t() : m_data(NULL), m_size(0)
+#ifdef _WIN32
+			, m_hFile(INVALID_HANDLE_VALUE), m_hMap(NULL)
+#endif
+		{
+		}
+
+		~mapped_file_t()
+		{
+			close();
+		}
+
+#ifdef _WIN32
+		BOOL open(LPCWSTR pszPath)
+		{
+			close();
+			m_hFile = ::CreateFileW(pszPath, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+			if (m_hFile == INVALID_HANDLE_VALUE)
+				return FALSE;
+
+			LARGE_INTEGER size;
+			if (!::GetFileSizeEx(m_hFile, &size)) {
+				close();
+				return FALSE;
+			}
+			if (size.QuadPart == 0)
+				return TRUE;
+			if ((ULONGLONG)size.QuadPart > (SIZE_T)-1) {
+				close();
+				::SetLastError(ERROR_NOT_ENOUGH_MEMORY);
+				return FALSE;
+			}
+
+			m_hMap = ::CreateFileMappingW(m_hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+			if (m_hMap == NULL) {
+				close();
+				return FALSE;
+			}
+			m_data = (const char*)::MapViewOfFile(m_hMap, FILE_MAP_READ, 0, 0, 0);
+			if (m_data == NULL) {
+				close();
+				return FALSE;
+			}
+			m_size = (size_t)size.QuadPart;
+			return TRUE;
+		}
+
+		void close()
+		{
+			if (m_data != NULL)
+				::UnmapViewOfFile(m_data);
+			if (m_hMap != NULL)
+				::CloseHandle(m_hMap);
+			if (m_hFile != INVALID_HANDLE_VALUE)
+				::CloseHandle(m_hFile);
+			m_data = NULL;
+			m_size = 0;
+			m_hMap = NULL;
+			m_hFile = INVALID_HANDLE_VALUE;
+		}
+#else
+		bool open(const char* path)
+		{
+			close();
+			int fd = ::open(path, O_RDONLY);
+			if (fd < 0)
+				return false;
+
+			struct stat st;
+			if (::fstat(fd, &st) != 0) {
+				::close(fd);
+				return false;
+			}
+			if (st.st_size > 0) {
+				void* p = ::mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+				if (p == MAP_FAILED) {
+					::close(fd);
+					return false;
+				}
+				::madvise(p, (size_t)st.st_size, MADV_SEQUENTIAL);
+				m_data = (const char*)p;
+				m_size = (size_t)st.st_size;
+			}
+			// The mapping keeps the file referenced on its own
+			::close(fd);
+			return true;
+		}
+
+		void close()
+		{
+			if (m_data != NULL)
+				::munmap((void*)m_data, m_size);
+			m_data = NULL;
+			m_size = 0;
+		}
+#endif
+
+		const char* data() const { return m_data; }
+		size_t size() const { return m_size; }
+		std::string_view view() const { return std::string_view(m_data, m_size); }
+
+	private:
+		mapped_file_t(const mapped_file_t&);
+		mapped_file_t& operator= (const mapped_file_t&);
+
+		const char* m_data;
+		size_t m_size;
+#ifdef _WIN32
+		HANDLE m_hFile;
+		HANDLE m_hMap;
+#endif
+	};
+}
+
+#endif // _MMAP_HELPER_HPP_INCLUDED_
@@ -0,0 +1,320 @@
+/*
+* Author: LowBoyTeam (https://github.com/LowBoyTeam)
+* License: Code Project Open License
+* Disclaimer: The software is provided "as-is". No claim of suitability, guarantee, or any warranty whatsoever is provided.
+* Copyright (c) 2016-2017.
+*/
+
+#ifndef _QUERY_HELPER_HPP_INCLUDED_
+#define _QUERY_HELPER_HPP_INCLUDED_
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <stdint.h>
+#include <string.h>
+
+#include "url_helper.hpp"
+
+////////////////////////////////////////////////////////
+// Query string / form body parsing
+//
+//  query_t splits "a=1&b=x%20y&a=2" into key/value views without copying.
+//  Keys and values point into the parsed buffer; a value is only decoded
+//  when it contains '%' or '+', and only the first time it is read. Decoded
+//  text lives in an arena owned by the query_t, so after clear() a reused
+//  parser does not allocate at all.
+//
+//  The key index is built by parse() and finish(), so find(), count() and
+//  equal_range() only read and may be called from several threads at once.
+//  value() and get() write the lazily decoded value into the object: call
+//  decode_values() first if one query_t is read from several threads.
+//
+//  Usage:
+//    query_helper::query_t q;
+//    q.parse(request_query);               // request_query must outlive q
+//    std::string_view id = q.get("id");
+//
+//  or, for an application/x-www-form-urlencoded body arriving in pieces:
+//    query_helper::query_t form;
+//    while (recv(chunk)) form.feed(chunk); // chunks are copied
+//    form.finish();
+
+namespace query_helper
+{
+	// Bump allocator; memory is released all at once by clear() or the destructor
+	class arena_t
+	{
+	public:
+		explicit arena_t(size_t block_size = 4096) : m_block_size(block_size), m_current(0), m_used(0) {}
+
+		char* allocate(size_t size)
+		{
+			while (m_current < m_blocks.size())
+			{
+				block_t& block = m_blocks[m_current];
+				if (block.size - m_used >= size)
+				{
+					char* p = block.data.get() + m_used;
+					m_used += size;
+					return p;
+				}
+				++m_current;
+				m_used = 0;
+			}
+
+			block_t block;
+			block.size = size > m_block_size ? size : m_block_size;
+			block.data.reset(new char[block.size]);
+			m_blocks.push_back(std::move(block));
+			m_current = m_blocks.size() - 1;
+			m_used = size;
+			return m_blocks.back().data.get();
+		}
+
+		// Makes all memory available again without returning it to the heap
+		void clear()
+		{
+			m_current = 0;
+			m_used = 0;
+		}
+
+	private:
+		arena_t(const arena_t&);
+		arena_t& operator= (const arena_t&);
+
+		struct block_t
+		{
+			std::unique_ptr<char[]> data;
+			size_t size;
+		};
+
+		std::vector<block_t> m_blocks;
+		size_t m_block_size;
+		size_t m_current;
+		size_t m_used;
+	};
+
+	class query_t
+	{
+	public:
+		static constexpr size_t npos = (size_t)-1;
+
+		explicit query_t(char separator = '&') : m_separator(separator) {}
+
+		// Parses a query string (a leading '?' is skipped). The entries refer to
+		// query directly, so the buffer must stay alive and unchanged.
+		void parse(std::string_view query)
+		{
+			if (!query.empty() && query[0] == '?')
+				query.remove_prefix(1);
+			parse_block(query.data(), query.size());
+			build_index();
+		}
+
+		// Incremental parsing of a body that arrives in pieces. Complete pairs are
+		// copied into the arena with one memcpy per chunk; a pair cut by the chunk
+		// boundary waits for the next feed() or for finish(). Lookups by key
+		// see the fed pairs once finish() has been called.
+		void feed(std::string_view chunk)
+		{
+			size_t last = chunk.rfind(m_separator);
+			if (last == std::string_view::npos)
+			{
+				m_pending.append(chunk.data(), chunk.size());
+				return;
+			}
+
+			size_t size = m_pending.size() + last;
+			char* block = m_arena.allocate(size);
+			memcpy(block, m_pending.data(), m_pending.size());
+			memcpy(block + m_pending.size(), chunk.data(), last);
+			m_pending.assign(chunk.data() + last + 1, chunk.size() - last - 1);
+			parse_block(block, size);
+		}
+
+		void finish()
+		{
+			if (!m_pending.empty())
+			{
+				char* block = m_arena.allocate(m_pending.size());
+				memcpy(block, m_pending.data(), m_pending.size());
+				parse_block(block, m_pending.size());
+				m_pending.clear();
+			}
+			build_index();
+		}
+
+		// Drops all entries but keeps every buffer for the next request
+		void clear()
+		{
+			m_entries.clear();
+			m_index.clear();
+			m_pending.clear();
+			m_arena.clear();
+		}
+
+		size_t size() const { return m_entries.size(); }
+		bool empty() const { return m_entries.empty(); }
+
+		// Decoded key of entry i
+		std::string_view key(size_t i) const { return std::string_view(m_entries[i].key, m_entries[i].key_len); }
+
+		// Value of entry i exactly as it appears in the input
+		std::string_view raw_value(size_t i) const { return std::string_view(m_entries[i].value, m_entries[i].value_len); }
+
+		// Decoded value of entry i. Escaped values are decoded on first access,
+		// which is not safe from several threads unless decode_values() ran.
+		std::string_view value(size_t i) const
+		{
+			const entry_t& e = m_entries[i];
+			if (e.flags & kValueEscaped)
+			{
+				if (!e.decoded)
+					decode(e);
+				return std::string_view(e.decoded, e.decoded_len);
+			}
+			return std::string_view(e.value, e.value_len);
+		}
+
+		// Decodes every escaped value now, after which value() and get() only read
+		void decode_values()
+		{
+			for (size_t i = 0; i < m_entries.size(); ++i)
+			{
+				const entry_t& e = m_entries[i];
+				if ((e.flags & kValueEscaped) && !e.decoded)
+					decode(e);
+			}
+		}
+
+		// Index of the first entry named key, or npos
+		size_t find(std::string_view key) const
+		{
+			std::pair<const uint32_t*, const uint32_t*> range = equal_range(key);
+			return range.first != range.second ? *range.first : npos;
+		}
+
+		bool contains(std::string_view key) const { return find(key) != npos; }
+
+		size_t count(std::string_view key) const
+		{
+			std::pair<const uint32_t*, const uint32_t*> range = equal_range(key);
+			return range.second - range.first;
+		}
+
+		// Decoded value of the first entry named key, or def
+		std::string_view get(std::string_view key, std::string_view def = std::string_view()) const
+		{
+			size_t i = find(key);
+			return i != npos ? value(i) : def;
+		}
+
+		// Indices of all entries named key, in input order
+		std::pair<const uint32_t*, const uint32_t*> equal_range(std::string_view key) const
+		{
+			const uint32_t* first = m_index.data();
+			const uint32_t* last = first + m_index.size();
+			if (m_index.size() <= kLinearLimit)
+			{
+				// For a handful of keys a scan beats the binary search; the index is
+				// still sorted so the matches are adjacent.
+				while (first != last && this->key(*first) != key)
+					++first;
+				const uint32_t* end = first;
+				while (end != last && this->key(*end) == key)
+					++end;
+				return std::make_pair(first, end);
+			}
+
+			first = std::lower_bound(first, last, key, [this](uint32_t i, std::string_view k) { return this->key(i) < k; });
+			last = std::upper_bound(first, last, key, [this](std::string_view k, uint32_t i) { return k < this->key(i); });
+			return std::make_pair(first, last);
+		}
+
+	private:
+		query_t(const query_t&);
+		query_t& operator= (const query_t&);
+
+		enum { kValueEscaped = 1 };
+		enum { kLinearLimit = 8 };
+
+		struct entry_t
+		{
+			const char* key;
+			const char* value;
+			mutable const char* decoded;
+			uint32_t key_len;
+			uint32_t value_len;
+			mutable uint32_t decoded_len;
+			uint32_t flags;
+		};
+
+		static bool is_escaped(const char* p, size_t n)
+		{
+			return memchr(p, '%', n) != NULL || memchr(p, '+', n) != NULL;
+		}
+
+		void parse_block(const char* p, size_t n)
+		{
+			const char* end = p + n;
+			while (p < end)
+			{
+				const char* amp = (const char*)memchr(p, m_separator, end - p);
+				if (amp == NULL)
+					amp = end;
+
+				if (amp != p)
+				{
+					const char* eq = (const char*)memchr(p, '=', amp - p);
+					const char* key_end = eq ? eq : amp;
+
+					entry_t e;
+					e.key = p;
+					e.key_len = (uint32_t)(key_end - p);
+					e.value = eq ? eq + 1 : amp;
+					e.value_len = (uint32_t)(amp - e.value);
+					e.decoded = NULL;
+					e.decoded_len = 0;
+					e.flags = is_escaped(e.value, e.value_len) ? kValueEscaped : 0;
+
+					// Keys are needed for every lookup, so escaped ones are decoded right away
+					if (is_escaped(e.key, e.key_len))
+					{
+						char* out = m_arena.allocate(e.key_len);
+						e.key_len = (uint32_t)url_helper::url_decode(e.key, e.key_len, out);
+						e.key = out;
+					}
+
+					m_entries.push_back(e);
+				}
+				p = amp + 1;
+			}
+		}
+
+		void build_index()
+		{
+			m_index.resize(m_entries.size());
+			for (size_t i = 0; i < m_index.size(); ++i)
+				m_index[i] = (uint32_t)i;
+			std::stable_sort(m_index.begin(), m_index.end(), [this](uint32_t a, uint32_t b) { return key(a) < key(b); });
+		}
+
+		void decode(const entry_t& e) const
+		{
+			char* out = m_arena.allocate(e.value_len);
+			e.decoded = out;
+			e.decoded_len = (uint32_t)url_helper::url_decode(e.value, e.value_len, out);
+		}
+
+		char m_separator;
+		std::vector<entry_t> m_entries;
+		std::vector<uint32_t> m_index;
+		mutable arena_t m_arena;
+		std::string m_pending;
+	};
+}
+
+#endif // _QUERY_HELPER_HPP_INCLUDED_
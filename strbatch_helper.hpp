@@ -0,0 +1,625 @@
+/*
+* Author: LowBoyTeam (https://github.com/LowBoyTeam)
+* License: Code Project Open License
+* Disclaimer: The software is provided "as-is". No claim of suitability, guarantee, or any warranty whatsoever is provided.
+* Copyright (c) 2016-2017.
+*/
+
+#ifndef _STRBATCH_HELPER_HPP_INCLUDED_
+#define _STRBATCH_HELPER_HPP_INCLUDED_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "cpu_helper.hpp"
+#include "url_helper.hpp"
+
+////////////////////////////////////////////////////////
+// Columnar string batches
+//
+//  batch_t holds a column of strings the way Arrow does: every value's
+//  characters back to back in one buffer, and count + 1 offsets into it, so
+//  value i is [offsets[i], offsets[i + 1]). Offsets are 64-bit, as in
+//  Arrow's LargeString layout.
+//
+//  The operations below take a whole column and return a new one. Each
+//  makes one pass to size every output value and one to write them, so the
+//  result costs one allocation for the offsets and one for the characters,
+//  not one per value. Tolower and Toupper do not change any length: they
+//  copy the offsets and convert the character buffer in one SSE2 sweep.
+//
+//  threads = 1 (the default) runs on the calling thread. Any other value
+//  splits the column into runs of whole values of roughly equal size, one
+//  per thread; 0 uses every core. As with string_helper::find_all, no
+//  thread gets less than 1 MB of characters, so small batches stay serial.
+//
+//  Case conversion and trim are ASCII only, like string_helper under the
+//  "C" locale. replace() replaces non-overlapping matches left to right, as
+//  string_helper::replace does; an empty target leaves the values as they
+//  are. url_encode / url_decode are url_helper's, value by value.
+//
+//  split() turns a column into a column of lists, laid out as Arrow's
+//  list<string>: list_batch_t holds one batch_t of every piece of every
+//  value, and size() + 1 offsets into it, so the pieces of value i are
+//  values()[offsets()[i]] to values()[offsets()[i + 1] - 1]. It is sized
+//  and written in two passes like the other operations, with one
+//  allocation for each of the three arrays.
+//
+//  Usage:
+//    strbatch_helper::builder_t builder;
+//    for (size_t i = 0; i < rows.size(); ++i)
+//        builder.append(rows[i][3]);
+//    strbatch_helper::batch_t names = builder.finish();
+//
+//    names = strbatch_helper::Tolower(strbatch_helper::trim(names), 0);
+//    std::vector<uint8_t> api = strbatch_helper::is_start_with(names, "api.");
+//    for (size_t i = 0; i < names.size(); ++i)
+//        use(names[i]);
+//
+//    strbatch_helper::list_batch_t parts = strbatch_helper::split(names, ".");
+//    for (size_t j = 0; j < parts.count(0); ++j)
+//        use(parts.at(0, j));                       // the pieces of names[0]
+
+namespace strbatch_helper
+{
+	class batch_t;
+	class builder_t;
+	class list_batch_t;
+
+	template <class Measure, class Write>
+	batch_t transform(const batch_t& in, unsigned threads, Measure measure, Write write);
+
+	namespace detail
+	{
+		inline batch_t convert_case(const batch_t& in, unsigned threads, bool upper);
+		inline list_batch_t split(const batch_t& in, std::string_view delim, unsigned threads);
+	}
+
+	class batch_t
+	{
+	public:
+		batch_t() : m_offsets(1, 0), m_bytes(0) {}
+
+		batch_t(batch_t&& other) noexcept : m_offsets(std::move(other.m_offsets)), m_data(std::move(other.m_data)), m_bytes(other.m_bytes)
+		{
+			other.m_offsets.assign(1, 0);
+			other.m_bytes = 0;
+		}
+
+		batch_t& operator= (batch_t&& other) noexcept
+		{
+			if (this != &other) {
+				m_offsets = std::move(other.m_offsets);
+				m_data = std::move(other.m_data);
+				m_bytes = other.m_bytes;
+				other.m_offsets.assign(1, 0);
+				other.m_bytes = 0;
+			}
+			return *this;
+		}
+
+		// Number of values
+		size_t size() const { return m_offsets.size() - 1; }
+		bool empty() const { return size() == 0; }
+
+		std::string_view operator[](size_t i) const
+		{
+			return std::string_view(m_data.get() + m_offsets[i], (size_t)(m_offsets[i + 1] - m_offsets[i]));
+		}
+
+		// Total characters over all values
+		size_t bytes() const { return m_bytes; }
+
+		// The character buffer and the size() + 1 offsets into it. The buffer
+		// is followed by kPadding readable bytes.
+		const char* data() const { return m_data.get(); }
+		const uint64_t* offsets() const { return m_offsets.data(); }
+
+		enum { kPadding = 16 };
+
+	private:
+		batch_t(const batch_t&);
+		batch_t& operator= (const batch_t&);
+
+		friend class builder_t;
+		template <class Measure, class Write>
+		friend batch_t transform(const batch_t&, unsigned, Measure, Write);
+		friend batch_t detail::convert_case(const batch_t&, unsigned, bool);
+		friend list_batch_t detail::split(const batch_t&, std::string_view, unsigned);
+
+		// Characters for bytes values plus the padding, left uninitialized
+		void allocate(size_t bytes)
+		{
+			m_data.reset(new char[bytes + kPadding]);
+			memset(m_data.get() + bytes, 0, kPadding);
+			m_bytes = bytes;
+		}
+
+		std::vector<uint64_t> m_offsets;
+		std::unique_ptr<char[]> m_data;
+		size_t m_bytes;
+	};
+
+	// Builds a batch_t one value at a time
+	class builder_t
+	{
+	public:
+		builder_t() : m_offsets(1, 0), m_size(0), m_capacity(0) {}
+
+		// Room for count more values holding bytes more characters
+		void reserve(size_t count, size_t bytes)
+		{
+			m_offsets.reserve(m_offsets.size() + count);
+			grow(m_size + bytes);
+		}
+
+		void append(std::string_view value)
+		{
+			if (m_size + value.size() > m_capacity)
+				grow(std::max(m_size + value.size(), m_capacity * 2));
+			if (!value.empty())
+				memcpy(m_data.get() + m_size, value.data(), value.size());
+			m_size += value.size();
+			m_offsets.push_back(m_size);
+		}
+
+		size_t size() const { return m_offsets.size() - 1; }
+
+		// Hands the values over as a batch; the builder starts again empty
+		batch_t finish()
+		{
+			batch_t batch;
+			if (m_capacity == 0)
+				grow(0);
+			memset(m_data.get() + m_size, 0, batch_t::kPadding);
+			batch.m_offsets.swap(m_offsets);
+			batch.m_data = std::move(m_data);
+			batch.m_bytes = m_size;
+			m_offsets.assign(1, 0);
+			m_size = 0;
+			m_capacity = 0;
+			return batch;
+		}
+
+	private:
+		builder_t(const builder_t&);
+		builder_t& operator= (const builder_t&);
+
+		void grow(size_t capacity)
+		{
+			if (m_data && capacity <= m_capacity)
+				return;
+			std::unique_ptr<char[]> data(new char[capacity + batch_t::kPadding]);
+			if (m_size)
+				memcpy(data.get(), m_data.get(), m_size);
+			m_data = std::move(data);
+			m_capacity = capacity;
+		}
+
+		std::vector<uint64_t> m_offsets;
+		std::unique_ptr<char[]> m_data;
+		size_t m_size;
+		size_t m_capacity;
+	};
+
+	// A column of lists of strings, as returned by split()
+	class list_batch_t
+	{
+	public:
+		list_batch_t() : m_offsets(1, 0) {}
+
+		list_batch_t(list_batch_t&& other) noexcept : m_values(std::move(other.m_values)), m_offsets(std::move(other.m_offsets))
+		{
+			other.m_offsets.assign(1, 0);
+		}
+
+		list_batch_t& operator= (list_batch_t&& other) noexcept
+		{
+			if (this != &other) {
+				m_values = std::move(other.m_values);
+				m_offsets = std::move(other.m_offsets);
+				other.m_offsets.assign(1, 0);
+			}
+			return *this;
+		}
+
+		// Number of lists
+		size_t size() const { return m_offsets.size() - 1; }
+		bool empty() const { return size() == 0; }
+
+		// Number of pieces in list i
+		size_t count(size_t i) const { return (size_t)(m_offsets[i + 1] - m_offsets[i]); }
+
+		// Piece j of list i
+		std::string_view at(size_t i, size_t j) const { return m_values[(size_t)m_offsets[i] + j]; }
+
+		// Every piece of every list, in order, and the size() + 1 offsets into it
+		const batch_t& values() const { return m_values; }
+		const uint64_t* offsets() const { return m_offsets.data(); }
+
+	private:
+		list_batch_t(const list_batch_t&);
+		list_batch_t& operator= (const list_batch_t&);
+
+		friend list_batch_t detail::split(const batch_t&, std::string_view, unsigned);
+
+		batch_t m_values;
+		std::vector<uint64_t> m_offsets;
+	};
+
+	// values: any container of strings or string views
+	template <class Values>
+	inline batch_t make_batch(const Values& values)
+	{
+		size_t bytes = 0;
+		for (const auto& v : values)
+			bytes += std::string_view(v).size();
+		builder_t builder;
+		builder.reserve(values.size(), bytes);
+		for (const auto& v : values)
+			builder.append(std::string_view(v));
+		return builder.finish();
+	}
+
+	namespace detail
+	{
+		// Splits values [0, count) into runs of whole values with about the same
+		// number of characters, no run under 1 MB. bounds gets runs + 1 indices.
+		inline void partition(const batch_t& batch, unsigned threads, std::vector<size_t>& bounds)
+		{
+			const size_t count = batch.size();
+			const size_t weight = batch.bytes() + count;
+			const size_t runs = cpu_helper::chunk_count(weight, threads);
+
+			bounds.assign(1, 0);
+			const uint64_t* offsets = batch.offsets();
+			for (size_t t = 1; t < runs; ++t) {
+				// Value where the characters (plus one per value) reach t / runs of the total
+				const uint64_t target = (uint64_t)(weight / runs * t);
+				size_t lo = bounds.back(), hi = count;
+				while (lo < hi) {
+					const size_t mid = lo + (hi - lo) / 2;
+					if (offsets[mid] + mid < target)
+						lo = mid + 1;
+					else
+						hi = mid;
+				}
+				if (lo > bounds.back() && lo < count)
+					bounds.push_back(lo);
+			}
+			bounds.push_back(count);
+		}
+
+		inline bool is_space(unsigned char c)
+		{
+			return c == ' ' || (c >= '\t' && c <= '\r');
+		}
+
+		inline std::string_view trimmed(std::string_view s)
+		{
+			size_t b = 0, e = s.size();
+			while (b < e && is_space((unsigned char)s[b]))
+				++b;
+			while (e > b && is_space((unsigned char)s[e - 1]))
+				--e;
+			return s.substr(b, e - b);
+		}
+
+		// Copies n bytes, adding 0x20 to those in [lo, hi]: ASCII case in either direction
+		inline void convert_case(char* dst, const char* src, size_t n, char lo, char hi)
+		{
+			size_t i = 0;
+#ifdef CPU_HELPER_HAS_SSE2
+			// Signed compares: bytes of 0x80 and up are negative, so below lo
+			const __m128i below = _mm_set1_epi8((char)(lo - 1)), above = _mm_set1_epi8((char)(hi + 1)), bit = _mm_set1_epi8(0x20);
+			for (; i + 16 <= n; i += 16) {
+				const __m128i v = _mm_loadu_si128((const __m128i*)(src + i));
+				const __m128i hit = _mm_and_si128(_mm_cmpgt_epi8(v, below), _mm_cmplt_epi8(v, above));
+				_mm_storeu_si128((__m128i*)(dst + i), _mm_xor_si128(v, _mm_and_si128(hit, bit)));
+			}
+#endif
+			for (; i < n; ++i) {
+				const char c = src[i];
+				dst[i] = c >= lo && c <= hi ? (char)(c ^ 0x20) : c;
+			}
+		}
+
+		inline uint64_t load8(const char* p)
+		{
+			uint64_t v;
+			memcpy(&v, p, 8);
+			return v;
+		}
+
+		// Mask of the first n bytes of a little- or big-endian 64-bit load
+		inline uint64_t first_bytes(size_t n)
+		{
+			uint64_t mask = 0;
+			memset(&mask, 0xFF, n);
+			return mask;
+		}
+
+		inline size_t count_matches(std::string_view s, std::string_view target)
+		{
+			size_t n = 0;
+			for (size_t pos = s.find(target); pos != std::string_view::npos; pos = s.find(target, pos + target.size()))
+				++n;
+			return n;
+		}
+
+		// Exact length url_helper::url_decode gives s
+		inline size_t url_decoded_length(std::string_view s)
+		{
+			size_t n = s.size();
+			for (size_t i = 0; i + 2 < s.size(); ++i) {
+				if (s[i] == '%' && url_helper::detail::hexval((unsigned char)s[i + 1]) >= 0 && url_helper::detail::hexval((unsigned char)s[i + 2]) >= 0) {
+					n -= 2;
+					i += 2;
+				}
+			}
+			return n;
+		}
+	}
+
+	// The engine behind every operation that changes lengths: measure(value)
+	// gives the exact output length of a value and write(value, dst) writes it
+	template <class Measure, class Write>
+	inline batch_t transform(const batch_t& in, unsigned threads, Measure measure, Write write)
+	{
+		const size_t count = in.size();
+		std::vector<size_t> bounds;
+		detail::partition(in, threads, bounds);
+		const size_t runs = bounds.size() - 1;
+
+		batch_t out;
+		out.m_offsets.resize(count + 1);
+		uint64_t* offsets = out.m_offsets.data();
+		offsets[0] = 0;
+
+		// Pass 1: every output length, summed per run
+		std::vector<uint64_t> totals(runs + 1, 0);
+		cpu_helper::run_parallel(runs, [&](size_t r) {
+			uint64_t total = 0;
+			for (size_t i = bounds[r]; i < bounds[r + 1]; ++i) {
+				const uint64_t length = measure(in[i]);
+				offsets[i + 1] = length;
+				total += length;
+			}
+			totals[r + 1] = total;
+		});
+		for (size_t r = 0; r < runs; ++r)
+			totals[r + 1] += totals[r];
+		out.allocate((size_t)totals[runs]);
+
+		// Pass 2: lengths become offsets, and values are written in place
+		char* data = out.m_data.get();
+		cpu_helper::run_parallel(runs, [&](size_t r) {
+			uint64_t at = totals[r];
+			for (size_t i = bounds[r]; i < bounds[r + 1]; ++i) {
+				write(in[i], data + at);
+				at += offsets[i + 1];
+				offsets[i + 1] = at;
+			}
+		});
+		return out;
+	}
+
+	inline batch_t detail::convert_case(const batch_t& in, unsigned threads, bool upper)
+	{
+		batch_t out;
+		out.m_offsets = in.m_offsets;
+		out.allocate(in.bytes());
+
+		std::vector<size_t> bounds;
+		detail::partition(in, threads, bounds);
+		const uint64_t* offsets = in.offsets();
+		cpu_helper::run_parallel(bounds.size() - 1, [&](size_t r) {
+			const size_t begin = (size_t)offsets[bounds[r]], end = (size_t)offsets[bounds[r + 1]];
+			detail::convert_case(out.m_data.get() + begin, in.data() + begin, end - begin, upper ? 'a' : 'A', upper ? 'z' : 'Z');
+		});
+		return out;
+	}
+
+	inline list_batch_t detail::split(const batch_t& in, std::string_view delim, unsigned threads)
+	{
+		const size_t count = in.size();
+		std::vector<size_t> bounds;
+		detail::partition(in, threads, bounds);
+		const size_t runs = bounds.size() - 1;
+
+		list_batch_t out;
+		out.m_offsets.resize(count + 1);
+		uint64_t* lists = out.m_offsets.data();
+		lists[0] = 0;
+
+		// Pass 1: pieces per value, and pieces and characters summed per run
+		std::vector<uint64_t> pieces(runs + 1, 0), bytes(runs + 1, 0);
+		cpu_helper::run_parallel(runs, [&](size_t r) {
+			uint64_t n = 0, size = 0;
+			for (size_t i = bounds[r]; i < bounds[r + 1]; ++i) {
+				const std::string_view s = in[i];
+				const size_t matches = delim.empty() ? 0 : detail::count_matches(s, delim);
+				lists[i + 1] = matches + 1;
+				n += matches + 1;
+				size += s.size() - matches * delim.size();
+			}
+			pieces[r + 1] = n;
+			bytes[r + 1] = size;
+		});
+		for (size_t r = 0; r < runs; ++r) {
+			pieces[r + 1] += pieces[r];
+			bytes[r + 1] += bytes[r];
+		}
+		batch_t& values = out.m_values;
+		values.m_offsets.resize((size_t)pieces[runs] + 1);
+		values.m_offsets[0] = 0;
+		values.allocate((size_t)bytes[runs]);
+
+		// Pass 2: piece counts become list offsets, and the pieces are written
+		// in place together with their own offsets
+		char* data = values.m_data.get();
+		uint64_t* offsets = values.m_offsets.data();
+		cpu_helper::run_parallel(runs, [&](size_t r) {
+			uint64_t piece = pieces[r], at = bytes[r];
+			for (size_t i = bounds[r]; i < bounds[r + 1]; ++i) {
+				const std::string_view s = in[i];
+				size_t from = 0;
+				if (!delim.empty()) {
+					for (size_t pos = s.find(delim); pos != std::string_view::npos; pos = s.find(delim, from)) {
+						memcpy(data + at, s.data() + from, pos - from);
+						at += pos - from;
+						offsets[++piece] = at;
+						from = pos + delim.size();
+					}
+				}
+				if (from < s.size())
+					memcpy(data + at, s.data() + from, s.size() - from);
+				at += s.size() - from;
+				offsets[++piece] = at;
+				lists[i + 1] = piece;
+			}
+		});
+		return out;
+	}
+
+	inline batch_t Tolower(const batch_t& in, unsigned threads = 1)
+	{
+		return detail::convert_case(in, threads, false);
+	}
+
+	inline batch_t Toupper(const batch_t& in, unsigned threads = 1)
+	{
+		return detail::convert_case(in, threads, true);
+	}
+
+	// Strips ASCII whitespace (space, \t \n \v \f \r) from both ends of every value
+	inline batch_t trim(const batch_t& in, unsigned threads = 1)
+	{
+		return transform(in, threads,
+			[](std::string_view s) { return detail::trimmed(s).size(); },
+			[](std::string_view s, char* dst) {
+				const std::string_view t = detail::trimmed(s);
+				if (!t.empty())
+					memcpy(dst, t.data(), t.size());
+			});
+	}
+
+	inline batch_t replace(const batch_t& in, std::string_view target, std::string_view replacement, unsigned threads = 1)
+	{
+		if (target.empty())
+			return transform(in, threads, [](std::string_view s) { return s.size(); },
+				[](std::string_view s, char* dst) {
+					if (!s.empty())
+						memcpy(dst, s.data(), s.size());
+				});
+		return transform(in, threads,
+			[&](std::string_view s) {
+				const size_t matches = detail::count_matches(s, target);
+				return s.size() - matches * target.size() + matches * replacement.size();
+			},
+			[&](std::string_view s, char* dst) {
+				size_t from = 0;
+				for (size_t pos = s.find(target); pos != std::string_view::npos; pos = s.find(target, from)) {
+					memcpy(dst, s.data() + from, pos - from);
+					dst += pos - from;
+					if (!replacement.empty())
+						memcpy(dst, replacement.data(), replacement.size());
+					dst += replacement.size();
+					from = pos + target.size();
+				}
+				if (from < s.size())
+					memcpy(dst, s.data() + from, s.size() - from);
+			});
+	}
+
+	// url_helper::url_encode<Mode> of every value
+	template <class Mode = url_helper::form_mode>
+	inline batch_t url_encode(const batch_t& in, unsigned threads = 1)
+	{
+		return transform(in, threads,
+			[](std::string_view s) { return url_helper::url_encode_length<Mode>(s.data(), s.size()); },
+			[](std::string_view s, char* dst) { url_helper::url_encode<Mode>(s.data(), s.size(), dst); });
+	}
+
+	// url_helper::url_decode of every value
+	inline batch_t url_decode(const batch_t& in, unsigned threads = 1)
+	{
+		return transform(in, threads,
+			[](std::string_view s) { return detail::url_decoded_length(s); },
+			[](std::string_view s, char* dst) { url_helper::url_decode(s.data(), s.size(), dst); });
+	}
+
+	// string_helper::split of every value, empty pieces included: a value with
+	// n matches of delim has n + 1 pieces. An empty delim gives every value
+	// as a single piece.
+	inline list_batch_t split(const batch_t& in, std::string_view delim, unsigned threads = 1)
+	{
+		return detail::split(in, delim, threads);
+	}
+
+	// One byte per value, 1 where the value starts with prefix
+	inline std::vector<uint8_t> is_start_with(const batch_t& in, std::string_view prefix, unsigned threads = 1)
+	{
+		std::vector<uint8_t> hits(in.size());
+		std::vector<size_t> bounds;
+		detail::partition(in, threads, bounds);
+		const uint64_t* offsets = in.offsets();
+		const char* data = in.data();
+		const size_t n = prefix.size();
+
+		cpu_helper::run_parallel(bounds.size() - 1, [&](size_t r) {
+			if (n <= 8) {
+				// One masked 8-byte compare per value; the padding keeps the load in bounds
+				char buffer[8] = {};
+				memcpy(buffer, prefix.data(), n);
+				const uint64_t mask = detail::first_bytes(n), want = detail::load8(buffer);
+				for (size_t i = bounds[r]; i < bounds[r + 1]; ++i)
+					hits[i] = (uint8_t)((offsets[i + 1] - offsets[i] >= n) & ((detail::load8(data + offsets[i]) & mask) == want));
+			}
+			else {
+				for (size_t i = bounds[r]; i < bounds[r + 1]; ++i)
+					hits[i] = (uint8_t)(offsets[i + 1] - offsets[i] >= n && memcmp(data + offsets[i], prefix.data(), n) == 0);
+			}
+		});
+		return hits;
+	}
+
+	// One byte per value, 1 where the value ends with suffix
+	inline std::vector<uint8_t> is_end_with(const batch_t& in, std::string_view suffix, unsigned threads = 1)
+	{
+		std::vector<uint8_t> hits(in.size());
+		std::vector<size_t> bounds;
+		detail::partition(in, threads, bounds);
+		const uint64_t* offsets = in.offsets();
+		const char* data = in.data();
+		const size_t n = suffix.size();
+
+		cpu_helper::run_parallel(bounds.size() - 1, [&](size_t r) {
+			if (n <= 8) {
+				char buffer[8] = {};
+				memcpy(buffer, suffix.data(), n);
+				const uint64_t mask = detail::first_bytes(n), want = detail::load8(buffer);
+				for (size_t i = bounds[r]; i < bounds[r + 1]; ++i) {
+					// A value shorter than the suffix would start the load before
+					// the buffer, so it reads from the value's own start instead
+					const bool fits = offsets[i + 1] - offsets[i] >= n;
+					const char* at = data + (fits ? offsets[i + 1] - n : offsets[i]);
+					hits[i] = (uint8_t)(fits & ((detail::load8(at) & mask) == want));
+				}
+			}
+			else {
+				for (size_t i = bounds[r]; i < bounds[r + 1]; ++i)
+					hits[i] = (uint8_t)(offsets[i + 1] - offsets[i] >= n && memcmp(data + offsets[i + 1] - n, suffix.data(), n) == 0);
+			}
+		});
+		return hits;
+	}
+}
+
+#endif // _STRBATCH_HELPER_HPP_INCLUDED_
@@ -0,0 +1,303 @@
+/*
+* Author: LowBoyTeam (https://github.com/LowBoyTeam)
+* License: Code Project Open License
+* Disclaimer: The software is provided "as-is". No claim of suitability, guarantee, or any warranty whatsoever is provided.
+* Copyright (c) 2016-2017.
+*/
+
+#ifndef _STRBUILDER_HELPER_HPP_INCLUDED_
+#define _STRBUILDER_HELPER_HPP_INCLUDED_
+
+#include <stdio.h>
+#include <string.h>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <charconv>
+#include <type_traits>
+#include <utility>
+
+#if !defined(_WIN32)
+#include <sys/uio.h>
+#endif
+
+////////////////////////////////////////////////////////
+// Segmented string builder
+//
+//  builder_t collects output as a list of segments instead of one growing
+//  string. Appended text is copied into chunks that are never reallocated,
+//  so nothing already written is ever moved; append_ref() adds a view
+//  without copying at all. The result is either flattened once with str(),
+//  or handed to writev / WSASend as a buffer list without being flattened.
+//
+//  Chunks start at the size hint (or 4 KB) and double up to 1 MB. Adjacent
+//  copies into the same chunk share one segment.
+//
+//  Usage:
+//    strbuilder_helper::builder_t b(expected_size);
+//    b.append("HTTP/1.1 200 OK\r\nContent-Length: ").append_number(body.size()).append("\r\n\r\n");
+//    b.append_ref(body);                        // body must outlive b
+//    std::vector<struct iovec> iov;
+//    b.to_iovecs(iov);
+//    writev(fd, iov.data(), (int)iov.size());
+
+namespace strbuilder_helper
+{
+	struct segment_t
+	{
+		const char* data;
+		size_t size;
+	};
+
+	class builder_t
+	{
+	public:
+		explicit builder_t(size_t size_hint = 0) : m_size(0), m_pos(0), m_cap(0), m_next_chunk(size_hint ? size_hint : (size_t)kMinChunk) {}
+
+		builder_t(builder_t&& other) : m_size(0), m_pos(0), m_cap(0), m_next_chunk(kMinChunk)
+		{
+			swap(other);
+		}
+
+		builder_t& operator= (builder_t&& other)
+		{
+			builder_t empty;
+			swap(empty);
+			swap(other);
+			return *this;
+		}
+
+		void swap(builder_t& other)
+		{
+			m_chunks.swap(other.m_chunks);
+			m_segments.swap(other.m_segments);
+			std::swap(m_size, other.m_size);
+			std::swap(m_pos, other.m_pos);
+			std::swap(m_cap, other.m_cap);
+			std::swap(m_next_chunk, other.m_next_chunk);
+		}
+
+		// Makes sure the next size bytes of copied text fit without a new chunk
+		void reserve(size_t size)
+		{
+			if (m_cap - m_pos < size)
+				new_chunk(size);
+		}
+
+		builder_t& append(std::string_view text)
+		{
+			if (text.empty())
+				return *this;
+			size_t done = 0;
+			if (m_cap > m_pos) {
+				done = text.size() < m_cap - m_pos ? text.size() : m_cap - m_pos;
+				write(text.data(), done);
+			}
+			if (done < text.size()) {
+				new_chunk(text.size() - done);
+				write(text.data() + done, text.size() - done);
+			}
+			return *this;
+		}
+
+		builder_t& append(char c)
+		{
+			if (m_cap == m_pos)
+				new_chunk(1);
+			write(&c, 1);
+			return *this;
+		}
+
+		// Adds text by reference; it must stay alive and unchanged until the
+		// builder's output has been used
+		builder_t& append_ref(std::string_view text)
+		{
+			if (text.size() < kMinRef)
+				return append(text);
+			segment_t s = { text.data(), text.size() };
+			m_segments.push_back(s);
+			m_size += text.size();
+			return *this;
+		}
+
+		template <class T>
+		builder_t& append_number(T value)
+		{
+			static_assert(std::is_arithmetic<T>::value && !std::is_same<T, bool>::value, "append_number needs an integer or floating point value, not bool");
+			char buffer[64];
+			return append(std::string_view(buffer, format_number(buffer, sizeof(buffer), value)));
+		}
+
+		builder_t& append_repeat(std::string_view text, size_t times)
+		{
+			reserve(text.size() * times);
+			for (size_t i = 0; i < times; ++i)
+				append(text);
+			return *this;
+		}
+
+		// Same result as string_helper::join, written straight into the builder
+		template <class Tokens>
+		builder_t& append_join(const Tokens& tokens, std::string_view delim)
+		{
+			bool first = true;
+			for (const auto& token : tokens) {
+				if (!first)
+					append(delim);
+				append(std::string_view(token.data(), token.size()));
+				first = false;
+			}
+			return *this;
+		}
+
+		// Same result as string_helper::replace, without the intermediate string
+		builder_t& append_replace(std::string_view source, std::string_view target, std::string_view replacement)
+		{
+			if (target.empty())
+				return append(source);
+			size_t pos, last_pos = 0;
+			while ((pos = source.find(target, last_pos)) != std::string_view::npos) {
+				append(source.substr(last_pos, pos - last_pos));
+				append(replacement);
+				last_pos = pos + target.size();
+			}
+			return append(source.substr(last_pos));
+		}
+
+		size_t size() const { return m_size; }
+		bool empty() const { return m_size == 0; }
+		const std::vector<segment_t>& segments() const { return m_segments; }
+
+		// Copies the whole output to dst, which must hold size() bytes
+		size_t copy_to(char* dst) const
+		{
+			for (size_t i = 0; i < m_segments.size(); ++i) {
+				memcpy(dst, m_segments[i].data, m_segments[i].size);
+				dst += m_segments[i].size;
+			}
+			return m_size;
+		}
+
+		// Appends the whole output to out with a single allocation
+		std::string& str(std::string& out) const
+		{
+			size_t pos = out.size();
+			out.resize(pos + m_size);
+			copy_to(&out[0] + pos);
+			return out;
+		}
+
+		std::string str() const
+		{
+			std::string out;
+			return str(out);
+		}
+
+#if !defined(_WIN32)
+		// Appends one iovec per segment, for writev
+		void to_iovecs(std::vector<struct iovec>& out) const
+		{
+			for (size_t i = 0; i < m_segments.size(); ++i) {
+				struct iovec v;
+				v.iov_base = (void*)m_segments[i].data;
+				v.iov_len = m_segments[i].size;
+				out.push_back(v);
+			}
+		}
+#elif defined(_WINSOCK2API_)
+		// Appends one WSABUF per segment, for WSASend. Segments over 4 GB are split.
+		void to_wsabufs(std::vector<WSABUF>& out) const
+		{
+			for (size_t i = 0; i < m_segments.size(); ++i) {
+				const char* p = m_segments[i].data;
+				size_t left = m_segments[i].size;
+				while (left > 0) {
+					WSABUF b;
+					b.len = left > 0xFFFFFFFFu ? 0xFFFFFFFFu : (ULONG)left;
+					b.buf = (CHAR*)p;
+					out.push_back(b);
+					p += b.len;
+					left -= b.len;
+				}
+			}
+		}
+#endif
+
+		// Drops the output but keeps the newest chunk for reuse
+		void clear()
+		{
+			m_segments.clear();
+			m_size = 0;
+			if (m_chunks.size() > 1) {
+				std::unique_ptr<char[]> last = std::move(m_chunks.back());
+				m_chunks.clear();
+				m_chunks.push_back(std::move(last));
+			}
+			m_pos = 0;
+		}
+
+	private:
+		builder_t(const builder_t&);
+		builder_t& operator= (const builder_t&);
+
+		enum
+		{
+			kMinChunk = 4096,
+			kMaxChunk = 1024 * 1024,
+			kMinRef = 64			// shorter views are cheaper to copy than to track
+		};
+
+		void new_chunk(size_t need)
+		{
+			size_t size = m_next_chunk > need ? m_next_chunk : need;
+			m_chunks.push_back(std::unique_ptr<char[]>(new char[size]));
+			m_pos = 0;
+			m_cap = size;
+			if (m_next_chunk < kMaxChunk)
+				m_next_chunk = m_next_chunk * 2 < (size_t)kMaxChunk ? m_next_chunk * 2 : (size_t)kMaxChunk;
+		}
+
+		// Copies into the current chunk, which has room for size bytes
+		void write(const char* data, size_t size)
+		{
+			char* dst = m_chunks.back().get() + m_pos;
+			memcpy(dst, data, size);
+			if (!m_segments.empty() && m_segments.back().data + m_segments.back().size == dst) {
+				m_segments.back().size += size;
+			}
+			else {
+				segment_t s = { dst, size };
+				m_segments.push_back(s);
+			}
+			m_pos += size;
+			m_size += size;
+		}
+
+		template <class T>
+		static size_t format_number(char* buffer, size_t size, T value)
+		{
+			if constexpr (std::is_integral<T>::value) {
+				return std::to_chars(buffer, buffer + size, value).ptr - buffer;
+			}
+			else {
+#if defined(__cpp_lib_to_chars) || (defined(_MSC_VER) && _MSC_VER >= 1924)
+				// Shortest text that reads back as the same value
+				return std::to_chars(buffer, buffer + size, value).ptr - buffer;
+#else
+				int n = snprintf(buffer, size, "%.17g", (double)value);
+				return n > 0 ? (size_t)n : 0;
+#endif
+			}
+		}
+
+		std::vector<std::unique_ptr<char[]> > m_chunks;
+		std::vector<segment_t> m_segments;
+		size_t m_size;
+		size_t m_pos;			// used bytes of the current chunk
+		size_t m_cap;			// size of the current chunk
+		size_t m_next_chunk;
+	};
+}
+
+#endif // _STRBUILDER_HELPER_HPP_INCLUDED_
@@ -1,427 +1,1543 @@
-/*
-* Author: LowBoyTeam (https://github.com/LowBoyTeam)
-* License: Code Project Open License
-* Disclaimer: The software is provided "as-is". No claim of suitability, guarantee, or any warranty whatsoever is provided.
-* Copyright (c) 2016-2017.
-*/
-
-#ifndef _STRING_HELPER_HPP_INCLUDED_
-#define _STRING_HELPER_HPP_INCLUDED_
-
-#include <stdarg.h>
-#include <string>
-#include <vector>
-#include <sstream>
-#include <fstream>
-#include <algorithm>
-#include <iomanip>
-
-namespace string_helper
-{
-	inline std::string format(const char *fmt, ...)
-	{
-		std::string strResult = "";
-		if (NULL != fmt)
-		{
-			va_list marker = NULL;
-			va_start(marker, fmt);
-
-			size_t nLength = _vscprintf(fmt, marker) + 1;
-			std::vector<char> vBuffer(nLength, '\0');
-
-			int nRet = _vsnprintf_s(&vBuffer[0], vBuffer.size(), nLength, fmt, marker);
-			if (nRet > 0)
-			{
-				strResult = &vBuffer[0];
-
-			}
-
-			va_end(marker);
-		}
-		return strResult;
-	}
-
-	inline std::wstring format(const wchar_t *fmt, ...)
-	{
-		std::wstring strResult = L"";
-		if (NULL != fmt)
-		{
-			va_list marker = NULL;
-			va_start(marker, fmt);
-
-			size_t nLength = _vscwprintf(fmt, marker) + 1;
-			std::vector<wchar_t> vBuffer(nLength, L'\0');
-
-			int nWritten = _vsnwprintf_s(&vBuffer[0], vBuffer.size(), nLength, fmt, marker);
-			if (nWritten > 0)
-			{
-				strResult = &vBuffer[0];
-			}
-
-			va_end(marker);
-		}
-		return strResult;
-	}
-
-	inline std::vector<std::string> compact(const std::vector<std::string> &tokens)
-	{
-		std::vector<std::string> compacted;
-		for (size_t i = 0; i < tokens.size(); ++i) {
-			if (!tokens[i].empty()) {
-				compacted.push_back(tokens[i]);
-			}
-		}
-		return compacted;
-	}
-
-	inline std::vector<std::wstring> compact(const std::vector<std::wstring> &tokens)
-	{
-		std::vector<std::wstring> compacted;
-		for (size_t i = 0; i < tokens.size(); ++i) {
-			if (!tokens[i].empty()) {
-				compacted.push_back(tokens[i]);
-			}
-		}
-		return compacted;
-	}
-	
-	inline std::vector<std::string> split(const std::string& str, const std::string& delim, const bool trim_empty = false)
-	{
-		size_t pos, last_pos = 0, len;
-		std::vector<std::string> tokens;
-		while (true) {
-			pos = str.find(delim, last_pos);
-			if (pos == std::string::npos) {
-				pos = str.size();
-			}
-			len = pos - last_pos;
-			if (!trim_empty || len != 0) {
-				tokens.push_back(str.substr(last_pos, len));
-			}
-			if (pos == str.size()) {
-				break;
-			}
-			else {
-				last_pos = pos + delim.size();
-			}
-		}
-		return tokens;
-	}
-
-	inline std::vector<std::wstring> split(const std::wstring& str, const std::wstring& delim, const bool trim_empty = false)
-	{
-		size_t pos, last_pos = 0, len;
-		std::vector<std::wstring> tokens;
-		while (true) {
-			pos = str.find(delim, last_pos);
-			if (pos == std::wstring::npos) {
-				pos = str.size();
-			}
-			len = pos - last_pos;
-			if (!trim_empty || len != 0) {
-				tokens.push_back(str.substr(last_pos, len));
-			}
-			if (pos == str.size()) {
-				break;
-			}
-			else {
-				last_pos = pos + delim.size();
-			}
-		}
-		return tokens;
-	}
-
-	inline std::string join(const std::vector<std::string> &tokens,const std::string& delim, const bool trim_empty = false)
-	{
-		if (trim_empty) {
-			return join(compact(tokens), delim, false);
-		}
-		else {
-			std::stringstream ss;
-			for (size_t i = 0; i < tokens.size() - 1; ++i) {
-				ss << tokens[i] << delim;
-			}
-			ss << tokens[tokens.size() - 1];
-			return ss.str();
-		}
-	}
-
-	inline std::wstring join(const std::vector<std::wstring> &tokens, const std::wstring& delim, const bool trim_empty = false)
-	{
-		if (trim_empty) {
-			return join(compact(tokens), delim, false);
-		}
-		else {
-			std::wstringstream ss;
-			for (size_t i = 0; i < tokens.size() - 1; ++i) {
-				ss << tokens[i] << delim;
-			}
-			ss << tokens[tokens.size() - 1];
-			return ss.str();
-		}
-	}
-	
-	inline std::string trim(const std::string& str)
-	{
-		if (str.empty()) {
-			return str;
-		}
-		std::string sstr(str);
-		std::string::iterator c;
-		// Erase whitespace before the string  
-		for (c = sstr.begin(); c != sstr.end() && iswspace(*c++);); sstr.erase(sstr.begin(), --c);
-		// Erase whitespace after the string  
-		for (c = sstr.end(); c != sstr.begin() && iswspace(*--c);); sstr.erase(++c, sstr.end());
-		return sstr;
-	}
-
-	inline std::wstring trim(const std::wstring& str)
-	{
-		if (str.empty()) {
-			return str;
-		}
-		std::wstring sstr(str);
-		std::wstring::iterator c;
-		// Erase whitespace before the string  
-		for (c = sstr.begin(); c != sstr.end() && iswspace(*c++);); sstr.erase(sstr.begin(), --c);
-		// Erase whitespace after the string  
-		for (c = sstr.end(); c != sstr.begin() && iswspace(*--c);); sstr.erase(++c, sstr.end());
-		return sstr;
-	}
-	
-	inline std::string repeat(const std::string& str, unsigned int times)
-	{
-		std::stringstream ss;
-		for (unsigned int i = 0; i < times; ++i) {
-			ss << str;
-		}
-		return ss.str();
-	}
-
-	inline std::wstring repeat(const std::wstring& str, unsigned int times)
-	{
-		std::wstringstream ss;
-		for (unsigned int i = 0; i < times; ++i) {
-			ss << str;
-		}
-		return ss.str();
-	}
-	
-	inline std::string Toupper(const std::string& str)
-	{
-		if (str.empty()) {
-			return str;
-		}
-		std::string s(str);
-		std::transform(s.begin(), s.end(), s.begin(), toupper);
-		return s;
-	}
-
-	inline std::wstring Toupper(const std::wstring& str)
-	{
-		if (str.empty()) {
-			return str;
-		}
-		std::wstring s(str);
-		std::transform(s.begin(), s.end(), s.begin(), toupper);
-		return s;
-	}
-
-	inline std::string Tolower(const std::string& str)
-	{
-		if (str.empty()) {
-			return str;
-		}
-		std::string s(str);
-		std::transform(s.begin(), s.end(), s.begin(), tolower);
-		return s;
-	}
-
-	inline std::wstring Tolower(const std::wstring& str)
-	{
-		if (str.empty()) {
-			return str;
-		}
-		std::wstring s(str);
-		std::transform(s.begin(), s.end(), s.begin(), tolower);
-		return s;
-	}
-	
-	inline std::string replace(const std::string& source,const std::string& target,const std::string& replacement)
-	{
-		std::string s(source);
-		std::string::size_type pos = 0;
-		std::string::size_type srclen = target.size();
-		std::string::size_type dstlen = replacement.size();
-		while ((pos = s.find(target, pos)) != std::string::npos)
-		{
-			s.replace(pos, srclen, replacement);
-			pos += dstlen;
-		}
-		return s;
-	}
-
-	inline std::wstring replace(const std::wstring& source, const std::wstring& target, const std::wstring& replacement)
-	{
-		std::wstring s(source);
-		std::wstring::size_type pos = 0;
-		std::wstring::size_type srclen = target.size();
-		std::wstring::size_type dstlen = replacement.size();
-		while ((pos = s.find(target, pos)) != std::wstring::npos)
-		{
-			s.replace(pos, srclen, replacement);
-			pos += dstlen;
-		}
-		return s;
-	}
-	
-	inline std::string between(const std::string& str, const std::string& left, const std::string& right) {
-		size_t left_pos, right_pos, last_pos = 0;
-		left_pos = str.find(left, last_pos);
-		if (left_pos == std::string::npos)
-			return std::string();
-		last_pos = left_pos + left.size();
-		right_pos = str.find(right, last_pos);
-		if (right_pos == std::string::npos)
-			return std::string();
-		return str.substr(left_pos + left.size(), right_pos - left_pos - left.size());
-	}
-
-	inline std::wstring between(const std::wstring& str, const std::wstring& left, const std::wstring& right) {
-		size_t left_pos, right_pos, last_pos = 0;
-		left_pos = str.find(left, last_pos);
-		if (left_pos == std::wstring::npos)
-			return std::wstring();
-		last_pos = left_pos + left.size();
-		right_pos = str.find(right, last_pos);
-		if (right_pos == std::string::npos)
-			return std::wstring();
-		return str.substr(left_pos + left.size(), right_pos - left_pos - left.size());
-	}
-	
-	inline std::vector<std::string> between_array(const std::string& str, const std::string& left, const std::string&right, const bool trim_empty = false)
-	{
-		size_t left_pos, right_pos, last_pos = 0, len;
-		std::vector<std::string> result;
-		while (true) {
-			left_pos = str.find(left, last_pos);
-			if (left_pos == std::string::npos) {
-				break;
-			}
-			else
-			{
-				last_pos = left_pos + left.size();
-				right_pos = str.find(right, last_pos);
-				if (right_pos == std::string::npos) {
-					break;
-				}
-				len = right_pos - left_pos - left.size();
-				if (len != 0 || !trim_empty)
-				{
-					result.push_back(str.substr(last_pos, len));
-				}
-			}
-			last_pos = right_pos + right.size();
-		}
-		return result;
-	}
-
-	inline std::vector<std::wstring> between_array(const std::wstring& str, const std::wstring& left, const std::wstring&right, const bool trim_empty = false)
-	{
-		size_t left_pos, right_pos, last_pos = 0, len;
-		std::vector<std::wstring> result;
-		while (true) {
-			left_pos = str.find(left, last_pos);
-			if (left_pos == std::wstring::npos) {
-				break;
-			}
-			else
-			{
-				last_pos = left_pos + left.size();
-				right_pos = str.find(right, last_pos);
-				if (right_pos == std::wstring::npos) {
-					break;
-				}
-				len = right_pos - left_pos - left.size();
-				if (len != 0 || !trim_empty)
-				{
-					result.push_back(str.substr(last_pos, len));
-				}
-			}
-			last_pos = right_pos + right.size();
-		}
-		return result;
-	}
-	
-	inline std::string left(const std::string& str, const std::string& left)
-	{
-		std::string s(str);
-		size_t pos, last_pos = 0;
-		pos = s.find(left, last_pos);
-		if (pos != std::string::npos)
-			return s.substr(0, pos);
-		else
-			return std::string();
-	}
-
-	inline std::wstring left(const std::wstring& str, const std::wstring& left)
-	{
-		std::wstring s(str);
-		size_t pos, last_pos = 0;
-		pos = s.find(left, last_pos);
-		if (pos != std::wstring::npos)
-			return s.substr(0, pos);
-		else
-			return std::wstring();
-	}
-	
-	inline std::string right(const std::string& str, const std::string& right)
-	{
-		std::string s(str);
-		size_t pos, last_pos = 0;
-		pos = s.find(right, last_pos);
-		if (pos != std::string::npos)
-		{
-			pos += right.length();
-			return s.substr(pos, str.length() - pos);
-		}
-		else
-			return std::string();
-	}
-
-	inline std::wstring right(const std::wstring& str, const std::wstring& right)
-	{
-		std::wstring s(str);
-		size_t pos, last_pos = 0;
-		pos = s.find(right, last_pos);
-		if (pos != std::wstring::npos)
-		{
-			pos += right.length();
-			return s.substr(pos, str.length() - pos);
-		}
-		else
-			return std::wstring();
-	}
-
-	inline bool is_start_with(const std::string& str, const std::string& src)
-	{
-		return str.compare(0, src.length(), src) == 0;
-	}
-
-	inline bool is_start_with(const std::wstring& str, const std::wstring& src)
-	{
-		return str.compare(0, src.length(), src) == 0;
-	}
-
-	inline bool is_end_with(const std::string& str, const std::string& src)
-	{
-		return str.compare(str.length() - src.length(), src.length(), src) == 0;
-	}
-
-	inline bool is_end_with(const std::wstring& str, const std::wstring& src)
-	{
-		return str.compare(str.length() - src.length(), src.length(), src) == 0;
-	}
-}
-
-#endif // _STRING_HELPER_HPP_INCLUDED_
+/*
+* Author: LowBoyTeam (https://github.com/LowBoyTeam)
+* License: Code Project Open License
+* Disclaimer: The software is provided "as-is". No claim of suitability, guarantee, or any warranty whatsoever is provided.
+* Copyright (c) 2016-2017.
+*/
+
+#ifndef _STRING_HELPER_HPP_INCLUDED_
+#define _STRING_HELPER_HPP_INCLUDED_
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <wchar.h>
+#include <wctype.h>
+#include <string>
+#include <vector>
+#include <sstream>
+#include <fstream>
+#include <algorithm>
+#include <iomanip>
+
+#if (defined(_MSVC_LANG) && _MSVC_LANG >= 201703L) || __cplusplus >= 201703L
+#include <errno.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string_view>
+#include <charconv>
+#include <limits>
+#include <system_error>
+#include <type_traits>
+#include "cpu_helper.hpp"
+#define STRING_HELPER_HAS_STRING_VIEW 1
+#if defined(__has_include)
+#if __has_include(<memory_resource>)
+#include <memory_resource>
+#define STRING_HELPER_HAS_PMR 1
+#endif
+#endif
+#endif
+
+// Compile-time patterns as template arguments (C++20 class-type NTTPs)
+#if defined(STRING_HELPER_HAS_STRING_VIEW) && defined(__cpp_nontype_template_args) && __cpp_nontype_template_args >= 201911L
+#define STRING_HELPER_HAS_FIXED_STRING 1
+#endif
+
+#include "instrument_helper.hpp"
+
+namespace string_helper
+{
+	inline std::string format(const char *fmt, ...)
+	{
+		std::string strResult = "";
+		if (NULL != fmt)
+		{
+			va_list marker;
+			va_start(marker, fmt);
+
+#ifdef _MSC_VER
+			size_t nLength = _vscprintf(fmt, marker) + 1;
+			std::vector<char> vBuffer(nLength, '\0');
+
+			int nRet = _vsnprintf_s(&vBuffer[0], vBuffer.size(), nLength, fmt, marker);
+#else
+			va_list counter;
+			va_copy(counter, marker);
+			size_t nLength = vsnprintf(NULL, 0, fmt, counter) + 1;
+			va_end(counter);
+			std::vector<char> vBuffer(nLength, '\0');
+
+			int nRet = vsnprintf(&vBuffer[0], vBuffer.size(), fmt, marker);
+#endif
+			if (nRet > 0)
+			{
+				strResult = &vBuffer[0];
+
+			}
+
+			va_end(marker);
+		}
+		return strResult;
+	}
+
+	inline std::wstring format(const wchar_t *fmt, ...)
+	{
+		std::wstring strResult = L"";
+		if (NULL != fmt)
+		{
+			va_list marker;
+			va_start(marker, fmt);
+
+#ifdef _MSC_VER
+			size_t nLength = _vscwprintf(fmt, marker) + 1;
+			std::vector<wchar_t> vBuffer(nLength, L'\0');
+
+			int nWritten = _vsnwprintf_s(&vBuffer[0], vBuffer.size(), nLength, fmt, marker);
+#else
+			// vswprintf cannot measure, so grow the buffer until the output fits
+			std::vector<wchar_t> vBuffer(256, L'\0');
+			int nWritten;
+			for (;;)
+			{
+				va_list attempt;
+				va_copy(attempt, marker);
+				nWritten = vswprintf(&vBuffer[0], vBuffer.size(), fmt, attempt);
+				va_end(attempt);
+				if (nWritten >= 0 || vBuffer.size() >= 0x100000)
+					break;
+				vBuffer.assign(vBuffer.size() * 2, L'\0');
+			}
+#endif
+			if (nWritten > 0)
+			{
+				strResult = &vBuffer[0];
+			}
+
+			va_end(marker);
+		}
+		return strResult;
+	}
+
+	inline std::vector<std::string> compact(const std::vector<std::string> &tokens)
+	{
+		std::vector<std::string> compacted;
+		for (size_t i = 0; i < tokens.size(); ++i) {
+			if (!tokens[i].empty()) {
+				compacted.push_back(tokens[i]);
+			}
+		}
+		return compacted;
+	}
+
+	inline std::vector<std::wstring> compact(const std::vector<std::wstring> &tokens)
+	{
+		std::vector<std::wstring> compacted;
+		for (size_t i = 0; i < tokens.size(); ++i) {
+			if (!tokens[i].empty()) {
+				compacted.push_back(tokens[i]);
+			}
+		}
+		return compacted;
+	}
+	
+	inline std::vector<std::string> split(const std::string& str, const std::string& delim, const bool trim_empty = false)
+	{
+		CPP_UTILS_PROBE(kSplit, str.size());
+		size_t pos, last_pos = 0, len;
+		std::vector<std::string> tokens;
+		while (true) {
+			pos = str.find(delim, last_pos);
+			if (pos == std::string::npos) {
+				pos = str.size();
+			}
+			len = pos - last_pos;
+			if (!trim_empty || len != 0) {
+				tokens.push_back(str.substr(last_pos, len));
+			}
+			if (pos == str.size()) {
+				break;
+			}
+			else {
+				last_pos = pos + delim.size();
+			}
+		}
+		CPP_UTILS_COUNT_ALLOC(kSplit, tokens.size() + 1);
+		return tokens;
+	}
+
+	inline std::vector<std::wstring> split(const std::wstring& str, const std::wstring& delim, const bool trim_empty = false)
+	{
+		CPP_UTILS_PROBE(kSplit, str.size());
+		size_t pos, last_pos = 0, len;
+		std::vector<std::wstring> tokens;
+		while (true) {
+			pos = str.find(delim, last_pos);
+			if (pos == std::wstring::npos) {
+				pos = str.size();
+			}
+			len = pos - last_pos;
+			if (!trim_empty || len != 0) {
+				tokens.push_back(str.substr(last_pos, len));
+			}
+			if (pos == str.size()) {
+				break;
+			}
+			else {
+				last_pos = pos + delim.size();
+			}
+		}
+		CPP_UTILS_COUNT_ALLOC(kSplit, tokens.size() + 1);
+		return tokens;
+	}
+
+	namespace detail
+	{
+		// Length of the joined result; the byte count of the kJoin probe
+		template <class Tokens>
+		inline size_t joined_length(const Tokens& tokens, size_t delim_size, bool trim_empty)
+		{
+			size_t size = 0, count = 0;
+			for (const auto& token : tokens) {
+				if (!trim_empty || !token.empty()) {
+					size += token.size();
+					++count;
+				}
+			}
+			return size + (count ? (count - 1) * delim_size : 0);
+		}
+	}
+
+	inline std::string join(const std::vector<std::string> &tokens,const std::string& delim, const bool trim_empty = false)
+	{
+		if (trim_empty) {
+			return join(compact(tokens), delim, false);
+		}
+		else {
+			CPP_UTILS_PROBE(kJoin, detail::joined_length(tokens, delim.size(), false));
+			CPP_UTILS_COUNT_ALLOC(kJoin, 1);
+			std::stringstream ss;
+			for (size_t i = 0; i < tokens.size() - 1; ++i) {
+				ss << tokens[i] << delim;
+			}
+			ss << tokens[tokens.size() - 1];
+			return ss.str();
+		}
+	}
+
+	inline std::wstring join(const std::vector<std::wstring> &tokens, const std::wstring& delim, const bool trim_empty = false)
+	{
+		if (trim_empty) {
+			return join(compact(tokens), delim, false);
+		}
+		else {
+			CPP_UTILS_PROBE(kJoin, detail::joined_length(tokens, delim.size(), false));
+			CPP_UTILS_COUNT_ALLOC(kJoin, 1);
+			std::wstringstream ss;
+			for (size_t i = 0; i < tokens.size() - 1; ++i) {
+				ss << tokens[i] << delim;
+			}
+			ss << tokens[tokens.size() - 1];
+			return ss.str();
+		}
+	}
+	
+	inline std::string trim(const std::string& str)
+	{
+		if (str.empty()) {
+			return str;
+		}
+		std::string sstr(str);
+		std::string::iterator c;
+		// Erase whitespace before the string  
+		for (c = sstr.begin(); c != sstr.end() && iswspace(*c++);); sstr.erase(sstr.begin(), --c);
+		// Erase whitespace after the string  
+		for (c = sstr.end(); c != sstr.begin() && iswspace(*--c);); sstr.erase(++c, sstr.end());
+		return sstr;
+	}
+
+	inline std::wstring trim(const std::wstring& str)
+	{
+		if (str.empty()) {
+			return str;
+		}
+		std::wstring sstr(str);
+		std::wstring::iterator c;
+		// Erase whitespace before the string  
+		for (c = sstr.begin(); c != sstr.end() && iswspace(*c++);); sstr.erase(sstr.begin(), --c);
+		// Erase whitespace after the string  
+		for (c = sstr.end(); c != sstr.begin() && iswspace(*--c);); sstr.erase(++c, sstr.end());
+		return sstr;
+	}
+	
+	inline std::string repeat(const std::string& str, unsigned int times)
+	{
+		std::stringstream ss;
+		for (unsigned int i = 0; i < times; ++i) {
+			ss << str;
+		}
+		return ss.str();
+	}
+
+	inline std::wstring repeat(const std::wstring& str, unsigned int times)
+	{
+		std::wstringstream ss;
+		for (unsigned int i = 0; i < times; ++i) {
+			ss << str;
+		}
+		return ss.str();
+	}
+	
+	inline std::string Toupper(const std::string& str)
+	{
+		if (str.empty()) {
+			return str;
+		}
+		std::string s(str);
+		std::transform(s.begin(), s.end(), s.begin(), toupper);
+		return s;
+	}
+
+	inline std::wstring Toupper(const std::wstring& str)
+	{
+		if (str.empty()) {
+			return str;
+		}
+		std::wstring s(str);
+		std::transform(s.begin(), s.end(), s.begin(), toupper);
+		return s;
+	}
+
+	inline std::string Tolower(const std::string& str)
+	{
+		if (str.empty()) {
+			return str;
+		}
+		std::string s(str);
+		std::transform(s.begin(), s.end(), s.begin(), tolower);
+		return s;
+	}
+
+	inline std::wstring Tolower(const std::wstring& str)
+	{
+		if (str.empty()) {
+			return str;
+		}
+		std::wstring s(str);
+		std::transform(s.begin(), s.end(), s.begin(), tolower);
+		return s;
+	}
+	
+	inline std::string replace(const std::string& source,const std::string& target,const std::string& replacement)
+	{
+		CPP_UTILS_PROBE(kReplace, source.size());
+		CPP_UTILS_COUNT_ALLOC(kReplace, 1);
+		std::string s(source);
+		std::string::size_type pos = 0;
+		std::string::size_type srclen = target.size();
+		std::string::size_type dstlen = replacement.size();
+		while ((pos = s.find(target, pos)) != std::string::npos)
+		{
+			s.replace(pos, srclen, replacement);
+			pos += dstlen;
+		}
+		return s;
+	}
+
+	inline std::wstring replace(const std::wstring& source, const std::wstring& target, const std::wstring& replacement)
+	{
+		CPP_UTILS_PROBE(kReplace, source.size());
+		CPP_UTILS_COUNT_ALLOC(kReplace, 1);
+		std::wstring s(source);
+		std::wstring::size_type pos = 0;
+		std::wstring::size_type srclen = target.size();
+		std::wstring::size_type dstlen = replacement.size();
+		while ((pos = s.find(target, pos)) != std::wstring::npos)
+		{
+			s.replace(pos, srclen, replacement);
+			pos += dstlen;
+		}
+		return s;
+	}
+	
+	inline std::string between(const std::string& str, const std::string& left, const std::string& right) {
+		size_t left_pos, right_pos, last_pos = 0;
+		left_pos = str.find(left, last_pos);
+		if (left_pos == std::string::npos)
+			return std::string();
+		last_pos = left_pos + left.size();
+		right_pos = str.find(right, last_pos);
+		if (right_pos == std::string::npos)
+			return std::string();
+		return str.substr(left_pos + left.size(), right_pos - left_pos - left.size());
+	}
+
+	inline std::wstring between(const std::wstring& str, const std::wstring& left, const std::wstring& right) {
+		size_t left_pos, right_pos, last_pos = 0;
+		left_pos = str.find(left, last_pos);
+		if (left_pos == std::wstring::npos)
+			return std::wstring();
+		last_pos = left_pos + left.size();
+		right_pos = str.find(right, last_pos);
+		if (right_pos == std::string::npos)
+			return std::wstring();
+		return str.substr(left_pos + left.size(), right_pos - left_pos - left.size());
+	}
+	
+	inline std::vector<std::string> between_array(const std::string& str, const std::string& left, const std::string&right, const bool trim_empty = false)
+	{
+		size_t left_pos, right_pos, last_pos = 0, len;
+		std::vector<std::string> result;
+		while (true) {
+			left_pos = str.find(left, last_pos);
+			if (left_pos == std::string::npos) {
+				break;
+			}
+			else
+			{
+				last_pos = left_pos + left.size();
+				right_pos = str.find(right, last_pos);
+				if (right_pos == std::string::npos) {
+					break;
+				}
+				len = right_pos - left_pos - left.size();
+				if (len != 0 || !trim_empty)
+				{
+					result.push_back(str.substr(last_pos, len));
+				}
+			}
+			last_pos = right_pos + right.size();
+		}
+		return result;
+	}
+
+	inline std::vector<std::wstring> between_array(const std::wstring& str, const std::wstring& left, const std::wstring&right, const bool trim_empty = false)
+	{
+		size_t left_pos, right_pos, last_pos = 0, len;
+		std::vector<std::wstring> result;
+		while (true) {
+			left_pos = str.find(left, last_pos);
+			if (left_pos == std::wstring::npos) {
+				break;
+			}
+			else
+			{
+				last_pos = left_pos + left.size();
+				right_pos = str.find(right, last_pos);
+				if (right_pos == std::wstring::npos) {
+					break;
+				}
+				len = right_pos - left_pos - left.size();
+				if (len != 0 || !trim_empty)
+				{
+					result.push_back(str.substr(last_pos, len));
+				}
+			}
+			last_pos = right_pos + right.size();
+		}
+		return result;
+	}
+	
+	inline std::string left(const std::string& str, const std::string& left)
+	{
+		std::string s(str);
+		size_t pos, last_pos = 0;
+		pos = s.find(left, last_pos);
+		if (pos != std::string::npos)
+			return s.substr(0, pos);
+		else
+			return std::string();
+	}
+
+	inline std::wstring left(const std::wstring& str, const std::wstring& left)
+	{
+		std::wstring s(str);
+		size_t pos, last_pos = 0;
+		pos = s.find(left, last_pos);
+		if (pos != std::wstring::npos)
+			return s.substr(0, pos);
+		else
+			return std::wstring();
+	}
+	
+	inline std::string right(const std::string& str, const std::string& right)
+	{
+		std::string s(str);
+		size_t pos, last_pos = 0;
+		pos = s.find(right, last_pos);
+		if (pos != std::string::npos)
+		{
+			pos += right.length();
+			return s.substr(pos, str.length() - pos);
+		}
+		else
+			return std::string();
+	}
+
+	inline std::wstring right(const std::wstring& str, const std::wstring& right)
+	{
+		std::wstring s(str);
+		size_t pos, last_pos = 0;
+		pos = s.find(right, last_pos);
+		if (pos != std::wstring::npos)
+		{
+			pos += right.length();
+			return s.substr(pos, str.length() - pos);
+		}
+		else
+			return std::wstring();
+	}
+
+	inline bool is_start_with(const std::string& str, const std::string& src)
+	{
+		return str.compare(0, src.length(), src) == 0;
+	}
+
+	inline bool is_start_with(const std::wstring& str, const std::wstring& src)
+	{
+		return str.compare(0, src.length(), src) == 0;
+	}
+
+	inline bool is_end_with(const std::string& str, const std::string& src)
+	{
+		return str.length() >= src.length() && str.compare(str.length() - src.length(), src.length(), src) == 0;
+	}
+
+	inline bool is_end_with(const std::wstring& str, const std::wstring& src)
+	{
+		return str.length() >= src.length() && str.compare(str.length() - src.length(), src.length(), src) == 0;
+	}
+
+#ifdef STRING_HELPER_HAS_STRING_VIEW
+	////////////////////////////////////////////////////////
+	// constexpr versions (C++17)
+	//
+	//  split, between, left, right, trim, is_start_with and is_end_with over
+	//  string views, usable in constant expressions. Nothing is allocated:
+	//  results are views into the input, and split returns a static_vector
+	//  whose capacity is a template argument. Tokens beyond the capacity are
+	//  dropped and overflow() is set. trim only strips ASCII whitespace.
+	//
+	//  Usage:
+	//    constexpr auto route = string_helper::cx::split<4>("/api/v1/users", "/", true);
+	//    static_assert(route.size() == 3 && route[2] == "users" && !route.overflow());
+	//
+	//  With C++20, patterns can also be template arguments, which lets the
+	//  compiler unroll the comparison against the literal:
+	//    if (string_helper::cx::is_start_with<"Bearer ">(header)) ...
+
+	namespace cx
+	{
+		template <class T, size_t N>
+		class static_vector
+		{
+		public:
+			constexpr static_vector() : m_items(), m_size(0), m_overflow(false) {}
+
+			// Returns false, and sets overflow(), when the vector is full
+			constexpr bool push_back(const T& item)
+			{
+				if (m_size == N) {
+					m_overflow = true;
+					return false;
+				}
+				m_items[m_size++] = item;
+				return true;
+			}
+
+			constexpr size_t size() const { return m_size; }
+			constexpr bool empty() const { return m_size == 0; }
+			static constexpr size_t capacity() { return N; }
+			constexpr bool overflow() const { return m_overflow; }
+
+			constexpr const T& operator[](size_t i) const { return m_items[i]; }
+			constexpr const T* begin() const { return m_items; }
+			constexpr const T* end() const { return m_items + m_size; }
+
+		private:
+			T m_items[N];
+			size_t m_size;
+			bool m_overflow;
+		};
+
+		namespace detail
+		{
+			template <class CharT>
+			constexpr bool is_space(CharT c)
+			{
+				return c == ' ' || c == '\t' || c == '\n' || c == '\v' || c == '\f' || c == '\r';
+			}
+
+			template <size_t N, class CharT>
+			constexpr static_vector<std::basic_string_view<CharT>, N> split(std::basic_string_view<CharT> str, std::basic_string_view<CharT> delim, bool trim_empty)
+			{
+				static_vector<std::basic_string_view<CharT>, N> tokens;
+				size_t pos = 0, last_pos = 0;
+				while (true) {
+					pos = delim.empty() ? std::basic_string_view<CharT>::npos : str.find(delim, last_pos);
+					if (pos == std::basic_string_view<CharT>::npos) {
+						pos = str.size();
+					}
+					if (!trim_empty || pos != last_pos) {
+						if (!tokens.push_back(str.substr(last_pos, pos - last_pos)))
+							break;
+					}
+					if (pos == str.size()) {
+						break;
+					}
+					last_pos = pos + delim.size();
+				}
+				return tokens;
+			}
+
+			template <class CharT>
+			constexpr std::basic_string_view<CharT> between(std::basic_string_view<CharT> str, std::basic_string_view<CharT> left, std::basic_string_view<CharT> right)
+			{
+				size_t left_pos = str.find(left);
+				if (left_pos == std::basic_string_view<CharT>::npos)
+					return std::basic_string_view<CharT>();
+				size_t right_pos = str.find(right, left_pos + left.size());
+				if (right_pos == std::basic_string_view<CharT>::npos)
+					return std::basic_string_view<CharT>();
+				return str.substr(left_pos + left.size(), right_pos - left_pos - left.size());
+			}
+
+			template <class CharT>
+			constexpr std::basic_string_view<CharT> left(std::basic_string_view<CharT> str, std::basic_string_view<CharT> left)
+			{
+				size_t pos = str.find(left);
+				return pos != std::basic_string_view<CharT>::npos ? str.substr(0, pos) : std::basic_string_view<CharT>();
+			}
+
+			template <class CharT>
+			constexpr std::basic_string_view<CharT> right(std::basic_string_view<CharT> str, std::basic_string_view<CharT> right)
+			{
+				size_t pos = str.find(right);
+				return pos != std::basic_string_view<CharT>::npos ? str.substr(pos + right.size()) : std::basic_string_view<CharT>();
+			}
+
+			template <class CharT>
+			constexpr std::basic_string_view<CharT> trim(std::basic_string_view<CharT> str)
+			{
+				size_t begin = 0, end = str.size();
+				while (begin < end && is_space(str[begin]))
+					++begin;
+				while (end > begin && is_space(str[end - 1]))
+					--end;
+				return str.substr(begin, end - begin);
+			}
+
+			template <class CharT>
+			constexpr bool is_start_with(std::basic_string_view<CharT> str, std::basic_string_view<CharT> src)
+			{
+				return str.size() >= src.size() && str.compare(0, src.size(), src) == 0;
+			}
+
+			template <class CharT>
+			constexpr bool is_end_with(std::basic_string_view<CharT> str, std::basic_string_view<CharT> src)
+			{
+				return str.size() >= src.size() && str.compare(str.size() - src.size(), src.size(), src) == 0;
+			}
+		}
+
+		template <size_t N>
+		constexpr static_vector<std::string_view, N> split(std::string_view str, std::string_view delim, bool trim_empty = false)
+		{
+			return detail::split<N, char>(str, delim, trim_empty);
+		}
+
+		template <size_t N>
+		constexpr static_vector<std::wstring_view, N> split(std::wstring_view str, std::wstring_view delim, bool trim_empty = false)
+		{
+			return detail::split<N, wchar_t>(str, delim, trim_empty);
+		}
+
+		constexpr std::string_view between(std::string_view str, std::string_view left, std::string_view right)
+		{
+			return detail::between<char>(str, left, right);
+		}
+
+		constexpr std::wstring_view between(std::wstring_view str, std::wstring_view left, std::wstring_view right)
+		{
+			return detail::between<wchar_t>(str, left, right);
+		}
+
+		constexpr std::string_view left(std::string_view str, std::string_view left)
+		{
+			return detail::left<char>(str, left);
+		}
+
+		constexpr std::wstring_view left(std::wstring_view str, std::wstring_view left)
+		{
+			return detail::left<wchar_t>(str, left);
+		}
+
+		constexpr std::string_view right(std::string_view str, std::string_view right)
+		{
+			return detail::right<char>(str, right);
+		}
+
+		constexpr std::wstring_view right(std::wstring_view str, std::wstring_view right)
+		{
+			return detail::right<wchar_t>(str, right);
+		}
+
+		constexpr std::string_view trim(std::string_view str)
+		{
+			return detail::trim<char>(str);
+		}
+
+		constexpr std::wstring_view trim(std::wstring_view str)
+		{
+			return detail::trim<wchar_t>(str);
+		}
+
+		constexpr bool is_start_with(std::string_view str, std::string_view src)
+		{
+			return detail::is_start_with<char>(str, src);
+		}
+
+		constexpr bool is_start_with(std::wstring_view str, std::wstring_view src)
+		{
+			return detail::is_start_with<wchar_t>(str, src);
+		}
+
+		constexpr bool is_end_with(std::string_view str, std::string_view src)
+		{
+			return detail::is_end_with<char>(str, src);
+		}
+
+		constexpr bool is_end_with(std::wstring_view str, std::wstring_view src)
+		{
+			return detail::is_end_with<wchar_t>(str, src);
+		}
+
+#ifdef STRING_HELPER_HAS_FIXED_STRING
+		// A string literal usable as a template argument
+		template <size_t N>
+		struct fixed_string
+		{
+			char value[N];
+
+			constexpr fixed_string(const char (&s)[N])
+			{
+				for (size_t i = 0; i < N; ++i)
+					value[i] = s[i];
+			}
+
+			static constexpr size_t size() { return N - 1; }
+			constexpr std::string_view view() const { return std::string_view(value, N - 1); }
+		};
+
+		namespace detail
+		{
+			// The length is a constant, so this unrolls into a few wide compares
+			template <fixed_string Pattern>
+			constexpr bool equal_at(const char* p)
+			{
+				for (size_t i = 0; i < Pattern.size(); ++i) {
+					if (p[i] != Pattern.value[i])
+						return false;
+				}
+				return true;
+			}
+		}
+
+		template <fixed_string Prefix>
+		constexpr bool is_start_with(std::string_view str)
+		{
+			return str.size() >= Prefix.size() && detail::equal_at<Prefix>(str.data());
+		}
+
+		template <fixed_string Suffix>
+		constexpr bool is_end_with(std::string_view str)
+		{
+			return str.size() >= Suffix.size() && detail::equal_at<Suffix>(str.data() + str.size() - Suffix.size());
+		}
+
+		template <fixed_string Left, fixed_string Right>
+		constexpr std::string_view between(std::string_view str)
+		{
+			return detail::between<char>(str, Left.view(), Right.view());
+		}
+#endif
+	}
+#endif
+
+#ifdef STRING_HELPER_HAS_STRING_VIEW
+	////////////////////////////////////////////////////////
+	// Parallel find-all / count (C++17)
+	//
+	//  find_all returns the offset of every occurrence of needle in str, in
+	//  order; count returns how many there are. Large inputs are cut into one
+	//  chunk per thread. A chunk reads needle.size() - 1 bytes past its end,
+	//  so a match crossing a boundary is found exactly once, by the chunk it
+	//  starts in. Each chunk is scanned with a SIMD filter on the first and
+	//  last needle bytes (AVX2 or SSE2, chosen at run time) and memcmp on the
+	//  candidates.
+	//
+	//  By default matches do not overlap, as with replace(): "aaaa" holds two
+	//  "aa", not three. Pass overlapping = true to get every position.
+	//  threads = 0 uses every core; inputs under 1 MB per thread use fewer.
+	//
+	//  Usage:
+	//    std::vector<size_t> hits = string_helper::find_all(buffer, "\r\n\r\n");
+	//    size_t lines = string_helper::count(buffer, "\n");
+
+	namespace detail
+	{
+		// Finds the matches starting in [begin, end); hay must be readable up to
+		// end + m - 1. Offsets go to out unless it is NULL. Returns the count.
+		typedef size_t find_fn(const char* hay, size_t begin, size_t end, const char* needle, size_t m, std::vector<size_t>* out);
+
+		inline size_t find_scalar(const char* hay, size_t begin, size_t end, const char* needle, size_t m, std::vector<size_t>* out)
+		{
+			size_t found = 0;
+			for (size_t i = begin; i < end; ++i) {
+				if (hay[i] == needle[0] && hay[i + m - 1] == needle[m - 1] && memcmp(hay + i, needle, m) == 0) {
+					++found;
+					if (out)
+						out->push_back(i);
+				}
+			}
+			return found;
+		}
+
+		inline size_t find_sse2(const char* hay, size_t begin, size_t end, const char* needle, size_t m, std::vector<size_t>* out)
+		{
+			size_t found = 0;
+			size_t i = begin;
+#ifdef CPU_HELPER_HAS_SSE2
+			const __m128i first = _mm_set1_epi8(needle[0]);
+			const __m128i last = _mm_set1_epi8(needle[m - 1]);
+			for (; i + 16 <= end; i += 16) {
+				const __m128i a = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(hay + i)), first);
+				const __m128i b = _mm_cmpeq_epi8(_mm_loadu_si128((const __m128i*)(hay + i + m - 1)), last);
+				unsigned mask = (unsigned)_mm_movemask_epi8(_mm_and_si128(a, b));
+				// Needles of one or two bytes are fully checked by the filter
+				if (out == NULL && m <= 2) {
+					found += cpu_helper::popcount32(mask);
+					continue;
+				}
+				while (mask) {
+					const size_t pos = i + cpu_helper::ctz32(mask);
+					if (m <= 2 || memcmp(hay + pos + 1, needle + 1, m - 2) == 0) {
+						++found;
+						if (out)
+							out->push_back(pos);
+					}
+					mask &= mask - 1;
+				}
+			}
+#endif
+			return found + find_scalar(hay, i, end, needle, m, out);
+		}
+
+#ifdef CPU_HELPER_X86
+		CPU_HELPER_TARGET_AVX2 inline size_t find_avx2(const char* hay, size_t begin, size_t end, const char* needle, size_t m, std::vector<size_t>* out)
+		{
+			size_t found = 0;
+			size_t i = begin;
+			const __m256i first = _mm256_set1_epi8(needle[0]);
+			const __m256i last = _mm256_set1_epi8(needle[m - 1]);
+			for (; i + 32 <= end; i += 32) {
+				const __m256i a = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(hay + i)), first);
+				const __m256i b = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i*)(hay + i + m - 1)), last);
+				unsigned mask = (unsigned)_mm256_movemask_epi8(_mm256_and_si256(a, b));
+				if (out == NULL && m <= 2) {
+					found += cpu_helper::popcount32(mask);
+					continue;
+				}
+				while (mask) {
+					const size_t pos = i + cpu_helper::ctz32(mask);
+					if (m <= 2 || memcmp(hay + pos + 1, needle + 1, m - 2) == 0) {
+						++found;
+						if (out)
+							out->push_back(pos);
+					}
+					mask &= mask - 1;
+				}
+			}
+			return found + find_scalar(hay, i, end, needle, m, out);
+		}
+#endif
+
+		inline cpu_helper::dispatch_t<find_fn>& find_kernel()
+		{
+			static cpu_helper::dispatch_t<find_fn> kernel = {
+#ifdef CPU_HELPER_X86
+				{ cpu_helper::kAVX2 | cpu_helper::kBMI1, find_avx2 },
+#endif
+#ifdef CPU_HELPER_HAS_SSE2
+				{ cpu_helper::kSSE2, find_sse2 },
+#endif
+				{ 0, find_scalar } };
+			return kernel;
+		}
+
+		// True if a match can start inside another one ("aa", "abab")
+		inline bool self_overlaps(std::string_view needle)
+		{
+			for (size_t k = 1; k < needle.size(); ++k) {
+				if (needle.compare(k, std::string_view::npos, needle, 0, needle.size() - k) == 0)
+					return true;
+			}
+			return false;
+		}
+
+		// Runs the kernel over chunks of the match starts in parallel; the
+		// per-chunk results come back in chunk order
+		inline size_t find_chunks(std::string_view str, std::string_view needle, unsigned threads, std::vector<std::vector<size_t> >* results)
+		{
+			const size_t starts = str.size() - needle.size() + 1;
+			const size_t chunks = cpu_helper::chunk_count(starts, threads);
+			cpu_helper::dispatch_t<find_fn>::fn_t kernel = find_kernel().get();
+
+			std::vector<size_t> counts(chunks, 0);
+			if (results)
+				results->resize(chunks);
+			cpu_helper::run_parallel(chunks, [&](size_t c) {
+				const size_t begin = starts / chunks * c;
+				const size_t end = c + 1 == chunks ? starts : starts / chunks * (c + 1);
+				counts[c] = kernel(str.data(), begin, end, needle.data(), needle.size(), results ? &(*results)[c] : NULL);
+			});
+
+			size_t total = 0;
+			for (size_t c = 0; c < chunks; ++c)
+				total += counts[c];
+			return total;
+		}
+	}
+
+	inline std::vector<size_t> find_all(std::string_view str, std::string_view needle, bool overlapping = false, unsigned threads = 0)
+	{
+		std::vector<size_t> offsets;
+		if (needle.empty() || needle.size() > str.size())
+			return offsets;
+
+		std::vector<std::vector<size_t> > results;
+		offsets.reserve(detail::find_chunks(str, needle, threads, &results));
+		const bool filter = !overlapping && detail::self_overlaps(needle);
+		for (size_t c = 0; c < results.size(); ++c) {
+			for (size_t i = 0; i < results[c].size(); ++i) {
+				// Chunks see every overlapping match; the greedy left-to-right
+				// choice is made here, across chunk boundaries
+				if (filter && !offsets.empty() && results[c][i] < offsets.back() + needle.size())
+					continue;
+				offsets.push_back(results[c][i]);
+			}
+		}
+		return offsets;
+	}
+
+	inline size_t count(std::string_view str, std::string_view needle, bool overlapping = false, unsigned threads = 0)
+	{
+		if (needle.empty() || needle.size() > str.size())
+			return 0;
+		// Matches of a needle that cannot overlap itself never overlap, so the
+		// chunk counts are exact; otherwise the positions are needed
+		if (!overlapping && detail::self_overlaps(needle))
+			return find_all(str, needle, false, threads).size();
+		return detail::find_chunks(str, needle, threads, NULL);
+	}
+#endif
+
+#ifdef STRING_HELPER_HAS_STRING_VIEW
+	////////////////////////////////////////////////////////
+	// Numeric parsing and formatting (C++17)
+	//
+	//  parse_int / parse_uint / parse_double convert a whole field without
+	//  allocating and without looking at the locale, unlike std::stoi,
+	//  std::stod and std::stringstream. An optional leading '+' (or '-' for
+	//  signed and floating point values) is accepted; whitespace is not, so
+	//  trim() first. The result is std::errc(): success,
+	//  std::errc::invalid_argument: empty, stray characters or no digits,
+	//  std::errc::result_out_of_range: does not fit in T.
+	//  value is only written on success.
+	//
+	//  Integers are read eight digits at a time with SWAR (SIMD within a
+	//  64-bit register): one test checks that all eight bytes are digits and
+	//  three multiplies combine them. Doubles go through std::from_chars.
+	//
+	//  write_number / append_number format with std::to_chars into a caller
+	//  buffer or onto the end of a string. The batch forms take an array of
+	//  fields, such as the output of split() or csv_helper rows.
+	//
+	//  Usage:
+	//    int64_t id;
+	//    if (string_helper::parse_int(fields[0], id) != std::errc())
+	//        return false;
+	//    std::string line;
+	//    string_helper::append_number(line, id);
+	//
+	//    std::vector<double> prices(count);
+	//    size_t ok = string_helper::parse_double(views.data(), count, prices.data());
+
+	namespace detail
+	{
+		inline uint64_t load8(const char* p)
+		{
+			uint64_t v;
+			memcpy(&v, p, sizeof(v));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+			v = __builtin_bswap64(v);
+#endif
+			return v;
+		}
+
+		// All eight bytes in '0'..'9'
+		inline bool is_eight_digits(uint64_t v)
+		{
+			return ((v & 0xF0F0F0F0F0F0F0F0ULL) | (((v + 0x0606060606060606ULL) & 0xF0F0F0F0F0F0F0F0ULL) >> 4)) == 0x3333333333333333ULL;
+		}
+
+		// Value of eight digit bytes, the first byte being the most significant
+		inline uint32_t parse_eight_digits(uint64_t v)
+		{
+			v -= 0x3030303030303030ULL;
+			v = (v * 10) + (v >> 8);
+			v = (((v & 0x000000FF000000FFULL) * (100 + (1000000ULL << 32))) + (((v >> 16) & 0x000000FF000000FFULL) * (1 + (10000ULL << 32)))) >> 32;
+			return (uint32_t)v;
+		}
+
+		inline std::errc parse_digits(const char* p, const char* end, uint64_t& value)
+		{
+			// Find the digit run, eight bytes per step
+			const char* q = p;
+			while (end - q >= 8 && is_eight_digits(load8(q)))
+				q += 8;
+			while (q < end && (unsigned)(*q - '0') < 10)
+				++q;
+			if (q != end || p == end)
+				return std::errc::invalid_argument;
+
+			while (p < end - 1 && *p == '0')
+				++p;
+			size_t n = (size_t)(end - p);
+			if (n > 20)
+				return std::errc::result_out_of_range;
+
+			// 19 digits always fit; the 20th needs an overflow check
+			const size_t head = n > 19 ? 19 : n;
+			uint64_t v = 0;
+			size_t i = 0;
+			for (; i + 8 <= head; i += 8)
+				v = v * 100000000 + parse_eight_digits(load8(p + i));
+			for (; i < head; ++i)
+				v = v * 10 + (unsigned)(p[i] - '0');
+			if (n == 20) {
+				const unsigned d = (unsigned)(p[19] - '0');
+				if (v > (UINT64_MAX - d) / 10)
+					return std::errc::result_out_of_range;
+				v = v * 10 + d;
+			}
+			value = v;
+			return std::errc();
+		}
+
+		template <class T>
+		inline size_t format_number(char* first, char* last, T value)
+		{
+			if constexpr (std::is_integral<T>::value) {
+				std::to_chars_result r = std::to_chars(first, last, value);
+				return r.ec == std::errc() ? (size_t)(r.ptr - first) : 0;
+			}
+			else {
+#if defined(__cpp_lib_to_chars) || (defined(_MSC_VER) && _MSC_VER >= 1924)
+				// Shortest text that reads back as the same value
+				std::to_chars_result r = std::to_chars(first, last, value);
+				return r.ec == std::errc() ? (size_t)(r.ptr - first) : 0;
+#else
+				char buffer[32];
+				int n = snprintf(buffer, sizeof(buffer), "%.17g", (double)value);
+				if (n <= 0 || n > last - first)
+					return 0;
+				memcpy(first, buffer, (size_t)n);
+				return (size_t)n;
+#endif
+			}
+		}
+	}
+
+	template <class T>
+	inline std::errc parse_uint(std::string_view str, T& value)
+	{
+		static_assert(std::is_integral<T>::value && std::is_unsigned<T>::value, "parse_uint needs an unsigned integer type");
+		const char* p = str.data();
+		const char* end = p + str.size();
+		if (p != end && *p == '+')
+			++p;
+		uint64_t v;
+		std::errc ec = detail::parse_digits(p, end, v);
+		if (ec != std::errc())
+			return ec;
+		if (v > (uint64_t)std::numeric_limits<T>::max())
+			return std::errc::result_out_of_range;
+		value = (T)v;
+		return std::errc();
+	}
+
+	template <class T>
+	inline std::errc parse_int(std::string_view str, T& value)
+	{
+		static_assert(std::is_integral<T>::value && std::is_signed<T>::value, "parse_int needs a signed integer type");
+		const char* p = str.data();
+		const char* end = p + str.size();
+		const bool negative = p != end && *p == '-';
+		if (p != end && (*p == '-' || *p == '+'))
+			++p;
+		uint64_t v;
+		std::errc ec = detail::parse_digits(p, end, v);
+		if (ec != std::errc())
+			return ec;
+		const uint64_t max = (uint64_t)std::numeric_limits<T>::max();
+		if (v > max + (negative ? 1 : 0))
+			return std::errc::result_out_of_range;
+		// Negate in unsigned arithmetic so the minimum value does not overflow
+		value = negative ? (T)(0 - v) : (T)v;
+		return std::errc();
+	}
+
+	inline std::errc parse_double(std::string_view str, double& value)
+	{
+		const char* p = str.data();
+		const char* end = p + str.size();
+		// from_chars takes a '-' but not a '+'
+		if (p != end && *p == '+' && end - p > 1 && p[1] != '-')
+			++p;
+		if (p == end)
+			return std::errc::invalid_argument;
+#if defined(__cpp_lib_to_chars) || (defined(_MSC_VER) && _MSC_VER >= 1924)
+		double v;
+		std::from_chars_result r = std::from_chars(p, end, v);
+		if (r.ec != std::errc())
+			return r.ec;
+		if (r.ptr != end)
+			return std::errc::invalid_argument;
+		value = v;
+		return std::errc();
+#else
+		// No floating point from_chars: strtod on a terminated copy. strtod
+		// follows the C locale's decimal point, which is '.' unless changed.
+		char buffer[128];
+		std::string copy;
+		const char* text;
+		if ((size_t)(end - p) < sizeof(buffer)) {
+			memcpy(buffer, p, (size_t)(end - p));
+			buffer[end - p] = '\0';
+			text = buffer;
+		}
+		else {
+			copy.assign(p, end);
+			text = copy.c_str();
+		}
+		if (*text == ' ' || *text == '\t' || *text == '\n' || *text == '\r' || *text == '\f' || *text == '\v')
+			return std::errc::invalid_argument;
+		char* stop;
+		errno = 0;
+		double v = strtod(text, &stop);
+		if (stop != text + (end - p) || stop == text)
+			return std::errc::invalid_argument;
+		if (errno == ERANGE)
+			return std::errc::result_out_of_range;
+		value = v;
+		return std::errc();
+#endif
+	}
+
+	// Batch forms: parse count fields into values. Fields that fail leave
+	// their value untouched; errors, when given, receives every field's
+	// result. Returns how many fields parsed.
+	template <class T>
+	inline size_t parse_uint(const std::string_view* fields, size_t count, T* values, std::errc* errors = NULL)
+	{
+		size_t ok = 0;
+		for (size_t i = 0; i < count; ++i) {
+			std::errc ec = parse_uint(fields[i], values[i]);
+			ok += ec == std::errc();
+			if (errors)
+				errors[i] = ec;
+		}
+		return ok;
+	}
+
+	template <class T>
+	inline size_t parse_int(const std::string_view* fields, size_t count, T* values, std::errc* errors = NULL)
+	{
+		size_t ok = 0;
+		for (size_t i = 0; i < count; ++i) {
+			std::errc ec = parse_int(fields[i], values[i]);
+			ok += ec == std::errc();
+			if (errors)
+				errors[i] = ec;
+		}
+		return ok;
+	}
+
+	inline size_t parse_double(const std::string_view* fields, size_t count, double* values, std::errc* errors = NULL)
+	{
+		size_t ok = 0;
+		for (size_t i = 0; i < count; ++i) {
+			std::errc ec = parse_double(fields[i], values[i]);
+			ok += ec == std::errc();
+			if (errors)
+				errors[i] = ec;
+		}
+		return ok;
+	}
+
+	// Writes value into [first, last); returns the end of the text, or NULL
+	// if it does not fit (nothing useful is written then)
+	template <class T>
+	inline char* write_number(char* first, char* last, T value)
+	{
+		static_assert(std::is_arithmetic<T>::value && !std::is_same<T, bool>::value, "write_number needs an integer or floating point value, not bool");
+		const size_t n = detail::format_number(first, last, value);
+		return n ? first + n : NULL;
+	}
+
+	template <class T>
+	inline std::string& append_number(std::string& out, T value)
+	{
+		static_assert(std::is_arithmetic<T>::value && !std::is_same<T, bool>::value, "append_number needs an integer or floating point value, not bool");
+		char buffer[64];
+		out.append(buffer, detail::format_number(buffer, buffer + sizeof(buffer), value));
+		return out;
+	}
+
+	// Appends the values separated by delim, growing out once per call
+	template <class T>
+	inline std::string& append_number(std::string& out, const T* values, size_t count, std::string_view delim)
+	{
+		static_assert(std::is_arithmetic<T>::value && !std::is_same<T, bool>::value, "append_number needs an integer or floating point value, not bool");
+		if (count == 0)
+			return out;
+		const size_t per_value = (std::is_integral<T>::value ? 21 : 48) + delim.size();
+		size_t pos = out.size();
+		out.resize(pos + per_value * count);
+		char* p = &out[0] + pos;
+		for (size_t i = 0; i < count; ++i) {
+			if (i) {
+				memcpy(p, delim.data(), delim.size());
+				p += delim.size();
+			}
+			p += detail::format_number(p, p + per_value, values[i]);
+		}
+		out.resize((size_t)(p - out.data()));
+		return out;
+	}
+#endif
+
+#ifdef STRING_HELPER_HAS_PMR
+	////////////////////////////////////////////////////////
+	// Allocator-aware versions (C++17 <memory_resource>)
+	//
+	//  Same behaviour as the functions above, but the result and every string
+	//  inside it are allocated from the given memory resource, so a request
+	//  handler can put everything in one monotonic arena and drop it at once.
+	//  Inputs are taken as views and may live anywhere.
+	//
+	//  Usage:
+	//    char buffer[16384];
+	//    std::pmr::monotonic_buffer_resource arena(buffer, sizeof(buffer));
+	//    std::pmr::vector<std::pmr::string> fields = string_helper::pmr::split(line, ",", false, &arena);
+	//    std::pmr::string name = string_helper::pmr::trim(fields[0], &arena);
+
+	namespace pmr
+	{
+		namespace detail
+		{
+			template <class CharT>
+			using string_t = std::pmr::basic_string<CharT>;
+
+			template <class CharT>
+			using vector_t = std::pmr::vector<std::pmr::basic_string<CharT> >;
+
+			inline bool is_space(char c) { return iswspace((unsigned char)c) != 0; }
+			inline bool is_space(wchar_t c) { return iswspace(c) != 0; }
+			inline char to_upper(char c) { return (char)toupper((unsigned char)c); }
+			inline wchar_t to_upper(wchar_t c) { return (wchar_t)towupper(c); }
+			inline char to_lower(char c) { return (char)tolower((unsigned char)c); }
+			inline wchar_t to_lower(wchar_t c) { return (wchar_t)towlower(c); }
+
+			template <class CharT>
+			inline vector_t<CharT> split(std::basic_string_view<CharT> str, std::basic_string_view<CharT> delim, bool trim_empty, std::pmr::memory_resource* resource)
+			{
+				CPP_UTILS_PROBE(kSplit, str.size());
+				vector_t<CharT> tokens(resource);
+				size_t pos, last_pos = 0, len;
+				while (true) {
+					pos = str.find(delim, last_pos);
+					if (pos == std::basic_string_view<CharT>::npos) {
+						pos = str.size();
+					}
+					len = pos - last_pos;
+					if (!trim_empty || len != 0) {
+						// The vector hands its resource to the element (uses-allocator construction)
+						tokens.emplace_back(str.substr(last_pos, len));
+					}
+					if (pos == str.size()) {
+						break;
+					}
+					last_pos = pos + delim.size();
+				}
+				CPP_UTILS_COUNT_ALLOC(kSplit, tokens.size() + 1);
+				return tokens;
+			}
+
+			template <class CharT, class Tokens>
+			inline vector_t<CharT> compact(const Tokens& tokens, std::pmr::memory_resource* resource)
+			{
+				vector_t<CharT> compacted(resource);
+				for (const auto& token : tokens) {
+					if (!token.empty()) {
+						compacted.emplace_back(std::basic_string_view<CharT>(token.data(), token.size()));
+					}
+				}
+				return compacted;
+			}
+
+			template <class CharT, class Tokens>
+			inline string_t<CharT> join(const Tokens& tokens, std::basic_string_view<CharT> delim, bool trim_empty, std::pmr::memory_resource* resource)
+			{
+				CPP_UTILS_PROBE(kJoin, string_helper::detail::joined_length(tokens, delim.size(), trim_empty));
+				CPP_UTILS_COUNT_ALLOC(kJoin, 1);
+				// Measure first so the result is allocated exactly once
+				size_t size = 0, count = 0;
+				for (const auto& token : tokens) {
+					if (!trim_empty || !token.empty()) {
+						size += token.size();
+						++count;
+					}
+				}
+				string_t<CharT> s(resource);
+				s.reserve(size + (count ? (count - 1) * delim.size() : 0));
+				bool first = true;
+				for (const auto& token : tokens) {
+					if (trim_empty && token.empty())
+						continue;
+					if (!first)
+						s.append(delim.data(), delim.size());
+					s.append(token.data(), token.size());
+					first = false;
+				}
+				return s;
+			}
+
+			template <class CharT>
+			inline string_t<CharT> trim(std::basic_string_view<CharT> str, std::pmr::memory_resource* resource)
+			{
+				size_t begin = 0, end = str.size();
+				while (begin < end && is_space(str[begin]))
+					++begin;
+				while (end > begin && is_space(str[end - 1]))
+					--end;
+				return string_t<CharT>(str.substr(begin, end - begin), resource);
+			}
+
+			template <class CharT>
+			inline string_t<CharT> repeat(std::basic_string_view<CharT> str, unsigned int times, std::pmr::memory_resource* resource)
+			{
+				string_t<CharT> s(resource);
+				s.reserve(str.size() * times);
+				for (unsigned int i = 0; i < times; ++i) {
+					s.append(str.data(), str.size());
+				}
+				return s;
+			}
+
+			template <class CharT>
+			inline string_t<CharT> Toupper(std::basic_string_view<CharT> str, std::pmr::memory_resource* resource)
+			{
+				string_t<CharT> s(str, resource);
+				for (size_t i = 0; i < s.size(); ++i)
+					s[i] = to_upper(s[i]);
+				return s;
+			}
+
+			template <class CharT>
+			inline string_t<CharT> Tolower(std::basic_string_view<CharT> str, std::pmr::memory_resource* resource)
+			{
+				string_t<CharT> s(str, resource);
+				for (size_t i = 0; i < s.size(); ++i)
+					s[i] = to_lower(s[i]);
+				return s;
+			}
+
+			template <class CharT>
+			inline string_t<CharT> replace(std::basic_string_view<CharT> source, std::basic_string_view<CharT> target, std::basic_string_view<CharT> replacement, std::pmr::memory_resource* resource)
+			{
+				CPP_UTILS_PROBE(kReplace, source.size());
+				CPP_UTILS_COUNT_ALLOC(kReplace, 1);
+				string_t<CharT> s(resource);
+				if (target.empty()) {
+					s.assign(source.data(), source.size());
+					return s;
+				}
+				// Built front to back instead of replacing in place, so no tail is moved
+				s.reserve(source.size());
+				size_t pos, last_pos = 0;
+				while ((pos = source.find(target, last_pos)) != std::basic_string_view<CharT>::npos) {
+					s.append(source.data() + last_pos, pos - last_pos);
+					s.append(replacement.data(), replacement.size());
+					last_pos = pos + target.size();
+				}
+				s.append(source.data() + last_pos, source.size() - last_pos);
+				return s;
+			}
+
+			template <class CharT>
+			inline string_t<CharT> between(std::basic_string_view<CharT> str, std::basic_string_view<CharT> left, std::basic_string_view<CharT> right, std::pmr::memory_resource* resource)
+			{
+				size_t left_pos = str.find(left);
+				if (left_pos == std::basic_string_view<CharT>::npos)
+					return string_t<CharT>(resource);
+				size_t right_pos = str.find(right, left_pos + left.size());
+				if (right_pos == std::basic_string_view<CharT>::npos)
+					return string_t<CharT>(resource);
+				return string_t<CharT>(str.substr(left_pos + left.size(), right_pos - left_pos - left.size()), resource);
+			}
+
+			template <class CharT>
+			inline vector_t<CharT> between_array(std::basic_string_view<CharT> str, std::basic_string_view<CharT> left, std::basic_string_view<CharT> right, bool trim_empty, std::pmr::memory_resource* resource)
+			{
+				vector_t<CharT> result(resource);
+				size_t left_pos, right_pos, last_pos = 0, len;
+				while (true) {
+					left_pos = str.find(left, last_pos);
+					if (left_pos == std::basic_string_view<CharT>::npos)
+						break;
+					last_pos = left_pos + left.size();
+					right_pos = str.find(right, last_pos);
+					if (right_pos == std::basic_string_view<CharT>::npos)
+						break;
+					len = right_pos - last_pos;
+					if (len != 0 || !trim_empty)
+						result.emplace_back(str.substr(last_pos, len));
+					last_pos = right_pos + right.size();
+				}
+				return result;
+			}
+		}
+
+		inline std::pmr::vector<std::pmr::string> split(std::string_view str, std::string_view delim, bool trim_empty = false, std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+		{
+			return detail::split<char>(str, delim, trim_empty, resource);
+		}
+
+		inline std::pmr::vector<std::pmr::wstring> split(std::wstring_view str, std::wstring_view delim, bool trim_empty = false, std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+		{
+			return detail::split<wchar_t>(str, delim, trim_empty, resource);
+		}
+
+		// tokens may be any container of strings or string views
+		template <class Tokens>
+		inline auto compact(const Tokens& tokens, std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+		{
+			return detail::compact<typename Tokens::value_type::value_type>(tokens, resource);
+		}
+
+		template <class Tokens>
+		inline auto join(const Tokens& tokens, std::basic_string_view<typename Tokens::value_type::value_type> delim, bool trim_empty = false, std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+		{
+			return detail::join<typename Tokens::value_type::value_type>(tokens, delim, trim_empty, resource);
+		}
+
+		inline std::pmr::string trim(std::string_view str, std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+		{
+			return detail::trim<char>(str, resource);
+		}
+
+		inline std::pmr::wstring trim(std::wstring_view str, std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+		{
+			return detail::trim<wchar_t>(str, resource);
+		}
+
+		inline std::pmr::string repeat(std::string_view str, unsigned int times, std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+		{
+			return detail::repeat<char>(str, times, resource);
+		}
+
+		inline std::pmr::wstring repeat(std::wstring_view str, unsigned int times, std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+		{
+			return detail::repeat<wchar_t>(str, times, resource);
+		}
+
+		inline std::pmr::string Toupper(std::string_view str, std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+		{
+			return detail::Toupper<char>(str, resource);
+		}
+
+		inline std::pmr::wstring Toupper(std::wstring_view str, std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+		{
+			return detail::Toupper<wchar_t>(str, resource);
+		}
+
+		inline std::pmr::string Tolower(std::string_view str, std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+		{
+			return detail::Tolower<char>(str, resource);
+		}
+
+		inline std::pmr::wstring Tolower(std::wstring_view str, std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+		{
+			return detail::Tolower<wchar_t>(str, resource);
+		}
+
+		inline std::pmr::string replace(std::string_view source, std::string_view target, std::string_view replacement, std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+		{
+			return detail::replace<char>(source, target, replacement, resource);
+		}
+
+		inline std::pmr::wstring replace(std::wstring_view source, std::wstring_view target, std::wstring_view replacement, std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+		{
+			return detail::replace<wchar_t>(source, target, replacement, resource);
+		}
+
+		inline std::pmr::string between(std::string_view str, std::string_view left, std::string_view right, std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+		{
+			return detail::between<char>(str, left, right, resource);
+		}
+
+		inline std::pmr::wstring between(std::wstring_view str, std::wstring_view left, std::wstring_view right, std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+		{
+			return detail::between<wchar_t>(str, left, right, resource);
+		}
+
+		inline std::pmr::vector<std::pmr::string> between_array(std::string_view str, std::string_view left, std::string_view right, bool trim_empty = false, std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+		{
+			return detail::between_array<char>(str, left, right, trim_empty, resource);
+		}
+
+		inline std::pmr::vector<std::pmr::wstring> between_array(std::wstring_view str, std::wstring_view left, std::wstring_view right, bool trim_empty = false, std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+		{
+			return detail::between_array<wchar_t>(str, left, right, trim_empty, resource);
+		}
+
+		inline std::pmr::string left(std::string_view str, std::string_view left, std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+		{
+			size_t pos = str.find(left);
+			return pos != std::string_view::npos ? std::pmr::string(str.substr(0, pos), resource) : std::pmr::string(resource);
+		}
+
+		inline std::pmr::wstring left(std::wstring_view str, std::wstring_view left, std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+		{
+			size_t pos = str.find(left);
+			return pos != std::wstring_view::npos ? std::pmr::wstring(str.substr(0, pos), resource) : std::pmr::wstring(resource);
+		}
+
+		inline std::pmr::string right(std::string_view str, std::string_view right, std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+		{
+			size_t pos = str.find(right);
+			return pos != std::string_view::npos ? std::pmr::string(str.substr(pos + right.size()), resource) : std::pmr::string(resource);
+		}
+
+		inline std::pmr::wstring right(std::wstring_view str, std::wstring_view right, std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+		{
+			size_t pos = str.find(right);
+			return pos != std::wstring_view::npos ? std::pmr::wstring(str.substr(pos + right.size()), resource) : std::pmr::wstring(resource);
+		}
+	}
+#endif
+}
+
+#endif // _STRING_HELPER_HPP_INCLUDED_
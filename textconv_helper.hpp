@@ -1,195 +1,611 @@
-/*
-* Author: LowBoyTeam (https://github.com/LowBoyTeam)
-* License: Code Project Open License
-* Disclaimer: The software is provided "as-is". No claim of suitability, guarantee, or any warranty whatsoever is provided.
-* Copyright (c) 2016-2017.
-*/
-
-#ifndef _ENCODER_HPP_INCLUDED_
-#define _ENCODER_HPP_INCLUDED_
-
-#include <windows.h>
-#include <vector>
-
-////////////////////////////////////////////////////////
-// Classes and functions (typedefs) for text conversions
-//
-//  This section defines the following text conversions:
-//  A2BSTR		ANSI  to BSTR
-//  A2OLE		ANSI  to OLE
-//	A2T			ANSI  to TCHAR
-//	A2W			ANSI  to WCHAR
-//  OLE2A		OLE   to ANSI
-//  OLE2T		OLE   to TCHAR
-//  OLE2W		OLE   to WCHAR
-//  T2A			TCHAR to ANSI
-//  T2BSTR		TCHAR to BSTR
-//  T2OLE       TCHAR to OLE
-//  T2W			TCHAR to WCHAR
-//  W2A			WCHAR to ANSI
-//  W2BSTR		WCHAR to BSTR
-//  W2OLE		WCHAR to OLE
-//  W2T			WCHAR to TCHAR
-
-// About different character and string types:
-// ------------------------------------------
-// char (or CHAR) character types are ANSI (8 bits).
-// wchar_t (or WCHAR) character types are Unicode (16 bits).
-// TCHAR characters are Unicode if the _UNICODE macro is defined, otherwise they are ANSI.
-// BSTR (Basic String) is a type of string used in Visual Basic and COM programming.
-// OLE is the same as WCHAR. It is used in Visual Basic and COM programming.
-
-namespace textconv_helper
-{
-	// Forward declarations of our classes. They are defined later.
-	class CA2A;
-	class CA2W;
-	class CW2A;
-	class CW2W;
-	class CA2BSTR;
-	class CW2BSTR;
-
-	// typedefs for the well known text conversions
-	typedef CA2W A2W;
-	typedef CW2A W2A;
-	typedef CW2BSTR W2BSTR;
-	typedef CA2BSTR A2BSTR;
-	typedef CW2A BSTR2A;
-	typedef CW2W BSTR2W;
-
-#ifdef _UNICODE
-	typedef CA2W A2T;
-	typedef CW2A T2A;
-	typedef CW2W T2W;
-	typedef CW2W W2T;
-	typedef CW2BSTR T2BSTR;
-	typedef BSTR2W BSTR2T;
-#else
-	typedef CA2A A2T;
-	typedef CA2A T2A;
-	typedef CA2W T2W;
-	typedef CW2A W2T;
-	typedef CA2BSTR T2BSTR;
-	typedef BSTR2A BSTR2T;
-#endif
-
-	typedef A2W  A2OLE;
-	typedef T2W  T2OLE;
-	typedef CW2W W2OLE;
-	typedef W2A  OLE2A;
-	typedef W2T  OLE2T;
-	typedef CW2W OLE2W;
-
-	class CA2W
-	{
-	public:
-		CA2W(LPCSTR pStr, UINT codePage = CP_ACP) : m_pStr(pStr)
-		{
-			if (pStr)
-			{
-				// Resize the vector and assign null WCHAR to each element
-				int length = MultiByteToWideChar(codePage, 0, pStr, -1, NULL, 0) + 1;
-				m_vWideArray.assign(length, L'\0');
-
-				// Fill our vector with the converted WCHAR array
-				MultiByteToWideChar(codePage, 0, pStr, -1, &m_vWideArray[0], length);
-			}
-		}
-		~CA2W() {}
-		operator LPCWSTR() { return m_pStr ? &m_vWideArray[0] : NULL; }
-		operator LPOLESTR() { return m_pStr ? (LPOLESTR)&m_vWideArray[0] : (LPOLESTR)NULL; }
-
-	private:
-		CA2W(const CA2W&);
-		CA2W& operator= (const CA2W&);
-		std::vector<wchar_t> m_vWideArray;
-		LPCSTR m_pStr;
-	};
-
-	class CW2A
-	{
-	public:
-		CW2A(LPCWSTR pWStr, UINT codePage = CP_ACP) : m_pWStr(pWStr)
-			// Usage:
-			//   CW2A ansiString(L"Some Text");
-			//   CW2A utf8String(L"Some Text", CP_UTF8);
-			//
-			// or
-			//   SetWindowTextA( W2A(L"Some Text") ); The ANSI version of SetWindowText
-		{
-			// Resize the vector and assign null char to each element
-			int length = WideCharToMultiByte(codePage, 0, pWStr, -1, NULL, 0, NULL, NULL) + 1;
-			m_vAnsiArray.assign(length, '\0');
-
-			// Fill our vector with the converted char array
-			WideCharToMultiByte(codePage, 0, pWStr, -1, &m_vAnsiArray[0], length, NULL, NULL);
-		}
-
-		~CW2A()
-		{
-			m_pWStr = 0;
-		}
-		operator LPCSTR() { return m_pWStr ? &m_vAnsiArray[0] : NULL; }
-
-	private:
-		CW2A(const CW2A&);
-		CW2A& operator= (const CW2A&);
-		std::vector<char> m_vAnsiArray;
-		LPCWSTR m_pWStr;
-	};
-
-	class CW2W
-	{
-	public:
-		CW2W(LPCWSTR pWStr) : m_pWStr(pWStr) {}
-		operator LPCWSTR() { return const_cast<LPWSTR>(m_pWStr); }
-		operator LPOLESTR() { return const_cast<LPOLESTR>(m_pWStr); }
-
-	private:
-		CW2W(const CW2W&);
-		CW2W& operator= (const CW2W&);
-
-		LPCWSTR m_pWStr;
-	};
-
-	class CA2A
-	{
-	public:
-		CA2A(LPCSTR pStr) : m_pStr(pStr) {}
-		operator LPCSTR() { return (LPSTR)m_pStr; }
-
-	private:
-		CA2A(const CA2A&);
-		CA2A& operator= (const CA2A&);
-
-		LPCSTR m_pStr;
-	};
-
-	class CW2BSTR
-	{
-	public:
-		CW2BSTR(LPCWSTR pWStr) { m_bstrString = ::SysAllocString(pWStr); }
-		~CW2BSTR() { ::SysFreeString(m_bstrString); }
-		operator BSTR() { return m_bstrString; }
-
-	private:
-		CW2BSTR(const CW2BSTR&);
-		CW2BSTR& operator= (const CW2BSTR&);
-		BSTR m_bstrString;
-	};
-
-	class CA2BSTR
-	{
-	public:
-		CA2BSTR(LPCSTR pStr) { m_bstrString = ::SysAllocString(A2W(pStr)); }
-		~CA2BSTR() { ::SysFreeString(m_bstrString); }
-		operator BSTR() { return m_bstrString; }
-
-	private:
-		CA2BSTR(const CA2BSTR&);
-		CA2BSTR& operator= (const CA2BSTR&);
-		BSTR m_bstrString;
-	};
-}
-
+/*
+* Author: LowBoyTeam (https://github.com/LowBoyTeam)
+* License: Code Project Open License
+* Disclaimer: The software is provided "as-is". No claim of suitability, guarantee, or any warranty whatsoever is provided.
+* Copyright (c) 2016-2017.
+*/
+
+#ifndef _ENCODER_HPP_INCLUDED_
+#define _ENCODER_HPP_INCLUDED_
+
+#include <windows.h>
+#include <vector>
+#include <string.h>
+
+////////////////////////////////////////////////////////
+// Classes and functions (typedefs) for text conversions
+//
+//  This section defines the following text conversions:
+//  A2BSTR		ANSI  to BSTR
+//  A2OLE		ANSI  to OLE
+//	A2T			ANSI  to TCHAR
+//	A2W			ANSI  to WCHAR
+//  OLE2A		OLE   to ANSI
+//  OLE2T		OLE   to TCHAR
+//  OLE2W		OLE   to WCHAR
+//  T2A			TCHAR to ANSI
+//  T2BSTR		TCHAR to BSTR
+//  T2OLE       TCHAR to OLE
+//  T2W			TCHAR to WCHAR
+//  W2A			WCHAR to ANSI
+//  W2BSTR		WCHAR to BSTR
+//  W2OLE		WCHAR to OLE
+//  W2T			WCHAR to TCHAR
+
+// About different character and string types:
+// ------------------------------------------
+// char (or CHAR) character types are ANSI (8 bits).
+// wchar_t (or WCHAR) character types are Unicode (16 bits).
+// TCHAR characters are Unicode if the _UNICODE macro is defined, otherwise they are ANSI.
+// BSTR (Basic String) is a type of string used in Visual Basic and COM programming.
+// OLE is the same as WCHAR. It is used in Visual Basic and COM programming.
+
+namespace textconv_helper
+{
+	// Forward declarations of our classes. They are defined later.
+	class CA2A;
+	class CA2W;
+	class CW2A;
+	class CW2W;
+	class CA2BSTR;
+	class CW2BSTR;
+
+	// typedefs for the well known text conversions
+	typedef CA2W A2W;
+	typedef CW2A W2A;
+	typedef CW2BSTR W2BSTR;
+	typedef CA2BSTR A2BSTR;
+	typedef CW2A BSTR2A;
+	typedef CW2W BSTR2W;
+
+#ifdef _UNICODE
+	typedef CA2W A2T;
+	typedef CW2A T2A;
+	typedef CW2W T2W;
+	typedef CW2W W2T;
+	typedef CW2BSTR T2BSTR;
+	typedef BSTR2W BSTR2T;
+#else
+	typedef CA2A A2T;
+	typedef CA2A T2A;
+	typedef CA2W T2W;
+	typedef CW2A W2T;
+	typedef CA2BSTR T2BSTR;
+	typedef BSTR2A BSTR2T;
+#endif
+
+	typedef A2W  A2OLE;
+	typedef T2W  T2OLE;
+	typedef CW2W W2OLE;
+	typedef W2A  OLE2A;
+	typedef W2T  OLE2T;
+	typedef CW2W OLE2W;
+
+	class CA2W
+	{
+	public:
+		CA2W(LPCSTR pStr, UINT codePage = CP_ACP) : m_pStr(pStr)
+		{
+			if (pStr)
+			{
+				// Resize the vector and assign null WCHAR to each element
+				int length = MultiByteToWideChar(codePage, 0, pStr, -1, NULL, 0) + 1;
+				m_vWideArray.assign(length, L'\0');
+
+				// Fill our vector with the converted WCHAR array
+				MultiByteToWideChar(codePage, 0, pStr, -1, &m_vWideArray[0], length);
+			}
+		}
+		~CA2W() {}
+		operator LPCWSTR() { return m_pStr ? &m_vWideArray[0] : NULL; }
+		operator LPOLESTR() { return m_pStr ? (LPOLESTR)&m_vWideArray[0] : (LPOLESTR)NULL; }
+
+	private:
+		CA2W(const CA2W&);
+		CA2W& operator= (const CA2W&);
+		std::vector<wchar_t> m_vWideArray;
+		LPCSTR m_pStr;
+	};
+
+	class CW2A
+	{
+	public:
+		CW2A(LPCWSTR pWStr, UINT codePage = CP_ACP) : m_pWStr(pWStr)
+			// Usage:
+			//   CW2A ansiString(L"Some Text");
+			//   CW2A utf8String(L"Some Text", CP_UTF8);
+			//
+			// or
+			//   SetWindowTextA( W2A(L"Some Text") ); The ANSI version of SetWindowText
+		{
+			// Resize the vector and assign null char to each element
+			int length = WideCharToMultiByte(codePage, 0, pWStr, -1, NULL, 0, NULL, NULL) + 1;
+			m_vAnsiArray.assign(length, '\0');
+
+			// Fill our vector with the converted char array
+			WideCharToMultiByte(codePage, 0, pWStr, -1, &m_vAnsiArray[0], length, NULL, NULL);
+		}
+
+		~CW2A()
+		{
+			m_pWStr = 0;
+		}
+		operator LPCSTR() { return m_pWStr ? &m_vAnsiArray[0] : NULL; }
+
+	private:
+		CW2A(const CW2A&);
+		CW2A& operator= (const CW2A&);
+		std::vector<char> m_vAnsiArray;
+		LPCWSTR m_pWStr;
+	};
+
+	class CW2W
+	{
+	public:
+		CW2W(LPCWSTR pWStr) : m_pWStr(pWStr) {}
+		operator LPCWSTR() { return const_cast<LPWSTR>(m_pWStr); }
+		operator LPOLESTR() { return const_cast<LPOLESTR>(m_pWStr); }
+
+	private:
+		CW2W(const CW2W&);
+		CW2W& operator= (const CW2W&);
+
+		LPCWSTR m_pWStr;
+	};
+
+	class CA2A
+	{
+	public:
+		CA2A(LPCSTR pStr) : m_pStr(pStr) {}
+		operator LPCSTR() { return (LPSTR)m_pStr; }
+
+	private:
+		CA2A(const CA2A&);
+		CA2A& operator= (const CA2A&);
+
+		LPCSTR m_pStr;
+	};
+
+	class CW2BSTR
+	{
+	public:
+		CW2BSTR(LPCWSTR pWStr) { m_bstrString = ::SysAllocString(pWStr); }
+		~CW2BSTR() { ::SysFreeString(m_bstrString); }
+		operator BSTR() { return m_bstrString; }
+
+	private:
+		CW2BSTR(const CW2BSTR&);
+		CW2BSTR& operator= (const CW2BSTR&);
+		BSTR m_bstrString;
+	};
+
+	class CA2BSTR
+	{
+	public:
+		CA2BSTR(LPCSTR pStr) { m_bstrString = ::SysAllocString(A2W(pStr)); }
+		~CA2BSTR() { ::SysFreeString(m_bstrString); }
+		operator BSTR() { return m_bstrString; }
+
+	private:
+		CA2BSTR(const CA2BSTR&);
+		CA2BSTR& operator= (const CA2BSTR&);
+		BSTR m_bstrString;
+	};
+
+	////////////////////////////////////////////////////////
+	// CStreamConv - chunked conversion between two code pages
+	//
+	// The classes above convert one NUL-terminated string per call. CStreamConv
+	// keeps state between calls instead, so input may arrive in arbitrary pieces
+	// (ReadFile, recv, a mapped view...). A multibyte sequence or surrogate pair
+	// cut by a chunk boundary is held back and completed by the next call.
+	// Output always goes to a caller-provided buffer; nothing is allocated per
+	// call. Use CP_WINUNICODE for UTF-16LE on either side.
+	//
+	// Usage:
+	//   CStreamConv conv(CP_ACP, CP_UTF8);
+	//   while (cbIn > 0) {
+	//     conv.Convert(pIn, cbIn, &cbRead, pOut, cbOut, &cbWritten);
+	//     send(pOut, cbWritten); pIn += cbRead; cbIn -= cbRead;
+	//   }
+	//   conv.Flush(pOut, cbOut, &cbWritten);
+	//
+	// or
+	//   CStreamConv::ConvertFile(L"in.txt", L"out.txt", 936, CP_UTF8);
+
+#ifndef CP_WINUNICODE
+#define CP_WINUNICODE 1200
+#endif
+
+	class CStreamConv
+	{
+	public:
+		CStreamConv(UINT fromCodePage, UINT toCodePage) : m_fromCP(fromCodePage), m_toCP(toCodePage), m_cbCarry(0)
+		{
+			m_cbOutMax = MaxCharSize(toCodePage);
+			m_bSingleByte = FALSE;
+
+			// Build a lead byte table once so splitting a DBCS chunk never calls into the system
+			ZeroMemory(m_bLead, sizeof(m_bLead));
+			CPINFO info;
+			if (fromCodePage != CP_WINUNICODE && fromCodePage != CP_UTF8 && ::GetCPInfo(fromCodePage, &info))
+			{
+				m_bSingleByte = (info.MaxCharSize == 1);
+				for (int i = 0; i + 1 < MAX_LEADBYTES && info.LeadByte[i] != 0; i += 2)
+				{
+					for (UINT b = info.LeadByte[i]; b <= info.LeadByte[i + 1]; ++b)
+						m_bLead[b] = TRUE;
+				}
+			}
+
+			m_vWideArray.assign(kBlockSize, L'\0');
+		}
+
+		// Converts as much of pIn as fits into pOut. *pcbRead is the number of input
+		// bytes consumed (an incomplete trailing sequence counts as consumed and is
+		// kept for the next call), *pcbWritten the number of output bytes produced.
+		// Returns FALSE only if the system conversion fails; GetLastError has the reason.
+		BOOL Convert(LPCVOID pIn, size_t cbIn, size_t* pcbRead, LPVOID pOut, size_t cbOut, size_t* pcbWritten)
+		{
+			const BYTE* pSrc = (const BYTE*)pIn;
+			BYTE* pDst = (BYTE*)pOut;
+			size_t cbRead = 0, cbWritten = 0;
+			BOOL bResult = TRUE;
+
+			// Complete the sequence left over from the previous chunk first
+			while (m_cbCarry > 0)
+			{
+				size_t cbSeq = SequenceLength(m_carry, m_cbCarry);
+				if (cbSeq == 0 || cbSeq > m_cbCarry)
+				{
+					if (cbRead == cbIn)
+						break;
+					m_carry[m_cbCarry++] = pSrc[cbRead++];
+					continue;
+				}
+
+				size_t cbPiece = 0;
+				if (!ConvertPiece(m_carry, cbSeq, pDst + cbWritten, cbOut - cbWritten, &cbPiece))
+				{
+					bResult = (::GetLastError() == ERROR_INSUFFICIENT_BUFFER);
+					goto done;
+				}
+				cbWritten += cbPiece;
+				m_cbCarry -= cbSeq;
+				memmove(m_carry, m_carry + cbSeq, m_cbCarry);
+			}
+
+			while (cbRead < cbIn && m_cbCarry == 0)
+			{
+				size_t cbAvail = cbIn - cbRead;
+				size_t cchRoom = (cbOut - cbWritten) / m_cbOutMax;
+
+				// Every input byte (or UTF-16 unit) yields at most one UTF-16 unit,
+				// and every UTF-16 unit at most m_cbOutMax output bytes.
+				size_t cbTake = cbAvail;
+				size_t cbUnit = (m_fromCP == CP_WINUNICODE) ? 2 : 1;
+				if (cbTake > kBlockSize * cbUnit)
+					cbTake = kBlockSize * cbUnit;
+				if (cbTake > cchRoom * cbUnit)
+					cbTake = cchRoom * cbUnit;
+
+				size_t cbSafe = SafeLength(pSrc + cbRead, cbTake);
+				if (cbSafe > 0)
+				{
+					size_t cbPiece = 0;
+					if (!ConvertPiece(pSrc + cbRead, cbSafe, pDst + cbWritten, cbOut - cbWritten, &cbPiece))
+					{
+						bResult = FALSE;
+						break;
+					}
+					cbRead += cbSafe;
+					cbWritten += cbPiece;
+				}
+				else if (cbTake < cbAvail || cbTake == 0)
+				{
+					// Output buffer full
+					break;
+				}
+
+				if (cbSafe < cbTake && cbTake == cbAvail)
+				{
+					// The tail of this chunk is an incomplete sequence; keep it
+					m_cbCarry = cbTake - cbSafe;
+					memcpy(m_carry, pSrc + cbRead, m_cbCarry);
+					cbRead += m_cbCarry;
+				}
+			}
+
+		done:
+			if (pcbRead)
+				*pcbRead = cbRead;
+			if (pcbWritten)
+				*pcbWritten = cbWritten;
+			return bResult;
+		}
+
+		// Emits whatever is still carried over (as replacement characters, since it
+		// is an incomplete sequence) and resets the converter for a new stream.
+		// The converter is reset even if the conversion fails.
+		BOOL Flush(LPVOID pOut, size_t cbOut, size_t* pcbWritten)
+		{
+			const BYTE* pCarry = m_carry;
+			size_t cbCarry = m_cbCarry;
+			m_cbCarry = 0;
+
+			// UTF-16 can only leave a lone high surrogate and/or an odd byte
+			// behind; each becomes U+FFFD, as the system would not convert them
+			BYTE replacement[sizeof(m_carry)];
+			if (m_fromCP == CP_WINUNICODE && cbCarry > 0)
+			{
+				size_t cchLeft = (cbCarry + 1) / 2;
+				for (size_t i = 0; i < cchLeft; ++i)
+				{
+					replacement[2 * i] = 0xFD;
+					replacement[2 * i + 1] = 0xFF;
+				}
+				pCarry = replacement;
+				cbCarry = cchLeft * 2;
+			}
+
+			size_t cbPiece = 0;
+			BOOL bResult = ConvertPiece(pCarry, cbCarry, (BYTE*)pOut, cbOut, &cbPiece);
+			if (pcbWritten)
+				*pcbWritten = bResult ? cbPiece : 0;
+			return bResult;
+		}
+
+		void Reset() { m_cbCarry = 0; }
+
+		// Number of input bytes currently held back waiting for the rest of a sequence
+		size_t GetPendingSize() const { return m_cbCarry; }
+
+		// Converts a whole file through a sliding read-only mapping of the source,
+		// so memory use stays constant regardless of the file size.
+		static BOOL ConvertFile(LPCWSTR pszSrcFile, LPCWSTR pszDstFile, UINT fromCodePage, UINT toCodePage)
+		{
+			HANDLE hSrc = ::CreateFileW(pszSrcFile, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+			if (hSrc == INVALID_HANDLE_VALUE)
+				return FALSE;
+
+			HANDLE hDst = ::CreateFileW(pszDstFile, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+			if (hDst == INVALID_HANDLE_VALUE)
+			{
+				DWORD dwError = ::GetLastError();
+				::CloseHandle(hSrc);
+				::SetLastError(dwError);
+				return FALSE;
+			}
+
+			BOOL bResult = FALSE;
+			HANDLE hMap = NULL;
+			LARGE_INTEGER size;
+			if (!::GetFileSizeEx(hSrc, &size))
+				goto cleanup;
+
+			if (size.QuadPart > 0)
+			{
+				hMap = ::CreateFileMappingW(hSrc, NULL, PAGE_READONLY, 0, 0, NULL);
+				if (hMap == NULL)
+					goto cleanup;
+			}
+
+			{
+				CStreamConv conv(fromCodePage, toCodePage);
+				std::vector<BYTE> vOut(kFileOutputSize);
+				ULONGLONG offset = 0;
+				ULONGLONG total = (ULONGLONG)size.QuadPart;
+
+				while (offset < total)
+				{
+					// kMapWindow is a multiple of the allocation granularity, as MapViewOfFile requires
+					SIZE_T cbView = (SIZE_T)((total - offset) < kMapWindow ? (total - offset) : kMapWindow);
+					const BYTE* pView = (const BYTE*)::MapViewOfFile(hMap, FILE_MAP_READ, (DWORD)(offset >> 32), (DWORD)offset, cbView);
+					if (pView == NULL)
+						goto cleanup;
+
+					size_t cbDone = 0;
+					while (cbDone < cbView)
+					{
+						size_t cbRead = 0, cbWritten = 0;
+						if (!conv.Convert(pView + cbDone, cbView - cbDone, &cbRead, &vOut[0], vOut.size(), &cbWritten) ||
+							!WriteAll(hDst, &vOut[0], cbWritten))
+						{
+							::UnmapViewOfFile(pView);
+							goto cleanup;
+						}
+						cbDone += cbRead;
+					}
+
+					::UnmapViewOfFile(pView);
+					offset += cbView;
+				}
+
+				size_t cbWritten = 0;
+				if (!conv.Flush(&vOut[0], vOut.size(), &cbWritten) || !WriteAll(hDst, &vOut[0], cbWritten))
+					goto cleanup;
+			}
+
+			bResult = TRUE;
+
+		cleanup:
+			DWORD dwError = ::GetLastError();
+			if (hMap != NULL)
+				::CloseHandle(hMap);
+			::CloseHandle(hDst);
+			::CloseHandle(hSrc);
+			if (!bResult)
+				::SetLastError(dwError);
+			return bResult;
+		}
+
+	private:
+		CStreamConv(const CStreamConv&);
+		CStreamConv& operator= (const CStreamConv&);
+
+		enum { kBlockSize = 64 * 1024 };
+		enum { kFileOutputSize = 1024 * 1024 };
+		static const ULONGLONG kMapWindow = 64ULL * 1024 * 1024;
+
+		static size_t MaxCharSize(UINT codePage)
+		{
+			if (codePage == CP_WINUNICODE)
+				return 2;
+			CPINFO info;
+			if (::GetCPInfo(codePage, &info) && info.MaxCharSize > 0)
+				return info.MaxCharSize;
+			return 4;
+		}
+
+		static BOOL WriteAll(HANDLE hFile, const BYTE* pData, size_t cbData)
+		{
+			while (cbData > 0)
+			{
+				DWORD cbChunk = cbData > 0x40000000 ? 0x40000000 : (DWORD)cbData;
+				DWORD cbDone = 0;
+				if (!::WriteFile(hFile, pData, cbChunk, &cbDone, NULL))
+					return FALSE;
+				pData += cbDone;
+				cbData -= cbDone;
+			}
+			return TRUE;
+		}
+
+		// Length of the sequence starting at p, or 0 if more bytes are needed to tell
+		size_t SequenceLength(const BYTE* p, size_t cb) const
+		{
+			if (cb == 0)
+				return 0;
+
+			switch (m_fromCP)
+			{
+			case CP_WINUNICODE:
+			{
+				if (cb < 2)
+					return 0;
+				WCHAR ch = (WCHAR)(p[0] | (p[1] << 8));
+				if (ch < 0xD800 || ch > 0xDBFF)
+					return 2;
+				if (cb < 4)
+					return 0;
+				WCHAR ch2 = (WCHAR)(p[2] | (p[3] << 8));
+				// A lone high surrogate is passed on alone and becomes U+FFFD
+				return (ch2 >= 0xDC00 && ch2 <= 0xDFFF) ? 4 : 2;
+			}
+			case CP_UTF8:
+				if (p[0] < 0xC0)
+					return 1;
+				if (p[0] < 0xE0)
+					return 2;
+				if (p[0] < 0xF0)
+					return 3;
+				return p[0] < 0xF8 ? 4 : 1;
+			case 54936: // GB18030 has four-byte sequences besides the DBCS ones
+				if (p[0] < 0x81 || p[0] == 0xFF)
+					return 1;
+				if (cb < 2)
+					return 0;
+				return (p[1] >= 0x30 && p[1] <= 0x39) ? 4 : 2;
+			default:
+				return m_bLead[p[0]] ? 2 : 1;
+			}
+		}
+
+		// Longest prefix of p[0, cb) that ends on a sequence boundary
+		size_t SafeLength(const BYTE* p, size_t cb) const
+		{
+			if (m_fromCP == CP_WINUNICODE)
+			{
+				size_t n = cb & ~(size_t)1;
+				if (n >= 2 && p[n - 1] >= 0xD8 && p[n - 1] <= 0xDB)
+					n -= 2;
+				return n;
+			}
+
+			if (m_fromCP == CP_UTF8)
+			{
+				// UTF-8 is self-synchronizing: only the last three bytes can be a cut sequence
+				for (size_t k = 1; k <= 3 && k <= cb; ++k)
+				{
+					BYTE b = p[cb - k];
+					if ((b & 0xC0) == 0x80)
+						continue;
+					if (b >= 0xC0 && SequenceLength(p + cb - k, k) > k)
+						return cb - k;
+					break;
+				}
+				return cb;
+			}
+
+			if (m_bSingleByte)
+				return cb;
+
+			// DBCS lead and trail byte ranges overlap, so walk forward from a known boundary
+			size_t i = 0;
+			while (i < cb)
+			{
+				size_t cbSeq = SequenceLength(p + i, cb - i);
+				if (cbSeq == 0 || i + cbSeq > cb)
+					break;
+				i += cbSeq;
+			}
+			return i;
+		}
+
+		BOOL ConvertPiece(const BYTE* pSrc, size_t cbSrc, BYTE* pDst, size_t cbDst, size_t* pcbWritten)
+		{
+			*pcbWritten = 0;
+			if (cbSrc == 0)
+				return TRUE;
+
+			const WCHAR* pWide = &m_vWideArray[0];
+			int cchWide = 0;
+			if (m_fromCP == CP_WINUNICODE)
+			{
+				cchWide = (int)(cbSrc / 2);
+				memcpy(&m_vWideArray[0], pSrc, cchWide * sizeof(WCHAR));
+			}
+			else
+			{
+				cchWide = ::MultiByteToWideChar(m_fromCP, 0, (LPCSTR)pSrc, (int)cbSrc, &m_vWideArray[0], (int)m_vWideArray.size());
+				if (cchWide == 0)
+					return FALSE;
+			}
+
+			if (m_toCP == CP_WINUNICODE)
+			{
+				if ((size_t)cchWide * 2 > cbDst)
+				{
+					::SetLastError(ERROR_INSUFFICIENT_BUFFER);
+					return FALSE;
+				}
+				memcpy(pDst, pWide, cchWide * sizeof(WCHAR));
+				*pcbWritten = cchWide * sizeof(WCHAR);
+				return TRUE;
+			}
+
+			if (cbDst == 0)
+			{
+				::SetLastError(ERROR_INSUFFICIENT_BUFFER);
+				return FALSE;
+			}
+
+			int cbOut = ::WideCharToMultiByte(m_toCP, 0, pWide, cchWide, (LPSTR)pDst, cbDst > 0x7FFFFFFF ? 0x7FFFFFFF : (int)cbDst, NULL, NULL);
+			if (cbOut == 0)
+				return FALSE;
+			*pcbWritten = cbOut;
+			return TRUE;
+		}
+
+		UINT m_fromCP;
+		UINT m_toCP;
+		size_t m_cbOutMax;
+		BOOL m_bSingleByte;
+		BOOL m_bLead[256];
+		BYTE m_carry[8];
+		size_t m_cbCarry;
+		std::vector<wchar_t> m_vWideArray;
+	};
+}
+
 #endif // _ENCODER_HPP_INCLUDED_
\ No newline at end of file
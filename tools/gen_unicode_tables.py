@@ -0,0 +1,202 @@
+#!/usr/bin/env python3
+"""Generates unicode_tables.hpp for unicode_helper.hpp.
+
+The data comes from the unicodedata module of the Python running this
+script, so the Unicode version follows the Python version:
+
+    python3 tools/gen_unicode_tables.py > unicode_tables.hpp
+
+Python has no simple case folding (str.casefold() is full folding), so it is
+derived: a character whose full folding is one character folds to it;
+otherwise it folds to its lowercase if that is a single other character
+(U+1E9E -> U+00DF, U+1F88 -> U+1F80), and to itself if not. This gives the
+C + S mappings of CaseFolding.txt.
+
+Tables are two-stage: stage1[cp >> SHIFT] picks a block of 1 << SHIFT
+entries in stage2, and identical blocks are stored once.
+"""
+
+import sys
+import unicodedata
+
+SHIFT = 7
+BLOCK = 1 << SHIFT
+MAX_CP = 0x110000
+
+HANGUL_S_BASE, HANGUL_S_COUNT = 0xAC00, 11172
+QC_YES, QC_MAYBE, QC_NO = 0, 1, 2
+
+
+def is_hangul_syllable(cp):
+    return HANGUL_S_BASE <= cp < HANGUL_S_BASE + HANGUL_S_COUNT
+
+
+def is_surrogate(cp):
+    return 0xD800 <= cp <= 0xDFFF
+
+
+def simple_fold(cp):
+    c = chr(cp)
+    full = c.casefold()
+    if len(full) == 1:
+        return ord(full)
+    lower = c.lower()
+    if len(lower) == 1:
+        return ord(lower)
+    return cp
+
+
+def canonical_decomposition(cp):
+    """Full (recursive) canonical decomposition, or None."""
+    if is_hangul_syllable(cp):
+        return None
+    d = unicodedata.decomposition(chr(cp))
+    if not d or d.startswith('<'):
+        return None
+    out = []
+    for part in d.split():
+        sub = int(part, 16)
+        rec = canonical_decomposition(sub)
+        out.extend(rec if rec else [sub])
+    return out
+
+
+def two_stage(values):
+    blocks = {}
+    stage1 = []
+    stage2 = []
+    for start in range(0, MAX_CP, BLOCK):
+        block = tuple(values[start:start + BLOCK])
+        if block not in blocks:
+            blocks[block] = len(blocks)
+            stage2.extend(block)
+        stage1.append(blocks[block])
+    return stage1, stage2
+
+
+def c_type(values):
+    hi = max(values)
+    if hi < 1 << 8:
+        return 'uint8_t'
+    if hi < 1 << 16:
+        return 'uint16_t'
+    return 'uint32_t'
+
+
+def emit_array(out, ctype, name, values, per_line=16):
+    out.append('\t\tconstexpr %s %s[%d] = {' % (ctype, name, len(values)))
+    for i in range(0, len(values), per_line):
+        out.append('\t\t\t' + ', '.join(str(v) for v in values[i:i + per_line]) + ',')
+    out.append('\t\t};')
+    out.append('')
+
+
+def main():
+    # Case folding: index into a table of distinct deltas
+    deltas = [0]
+    delta_index = {0: 0}
+    fold = [0] * MAX_CP
+    for cp in range(MAX_CP):
+        if is_surrogate(cp):
+            continue
+        delta = simple_fold(cp) - cp
+        if delta not in delta_index:
+            delta_index[delta] = len(deltas)
+            deltas.append(delta)
+        fold[cp] = delta_index[delta]
+
+    # Composition pairs: primary composites with a two-character decomposition
+    pairs = {}
+    for cp in range(MAX_CP):
+        if is_surrogate(cp) or is_hangul_syllable(cp):
+            continue
+        d = unicodedata.decomposition(chr(cp))
+        if not d or d.startswith('<'):
+            continue
+        parts = [int(p, 16) for p in d.split()]
+        if len(parts) == 2 and unicodedata.normalize('NFC', chr(cp)) == chr(cp):
+            pairs[(parts[0], parts[1])] = cp
+    seconds = set(second for (_, second) in pairs)
+    seconds.update(range(0x1161, 0x1176))     # Hangul V jamo
+    seconds.update(range(0x11A8, 0x11C3))     # Hangul T jamo
+
+    # Normalization properties: index into a table of distinct
+    # (ccc, quick check, decomposition) records
+    decomp = []
+    decomp_at = {}
+    records = [0]
+    record_index = {0: 0}
+    props = [0] * MAX_CP
+    for cp in range(MAX_CP):
+        if is_surrogate(cp):
+            continue
+        c = chr(cp)
+        ccc = unicodedata.combining(c)
+        if unicodedata.normalize('NFC', c) != c:
+            qc = QC_NO
+        elif cp in seconds:
+            qc = QC_MAYBE
+        else:
+            qc = QC_YES
+        d = canonical_decomposition(cp)
+        offset, length = 0, 0
+        if d:
+            key = tuple(d)
+            if key not in decomp_at:
+                decomp_at[key] = len(decomp)
+                decomp.extend(d)
+            offset, length = decomp_at[key], len(d)
+        assert length < 8 and offset < 1 << 16
+        record = ccc | (qc << 8) | (length << 10) | (offset << 16)
+        if record not in record_index:
+            record_index[record] = len(records)
+            records.append(record)
+        props[cp] = record_index[record]
+
+    fold1, fold2 = two_stage(fold)
+    props1, props2 = two_stage(props)
+    pair_keys = sorted(pairs)
+
+    out = []
+    out.append('/*')
+    out.append('* Author: LowBoyTeam (https://github.com/LowBoyTeam)')
+    out.append('* License: Code Project Open License')
+    out.append('* Disclaimer: The software is provided "as-is". No claim of suitability, guarantee, or any warranty whatsoever is provided.')
+    out.append('* Copyright (c) 2016-2017.')
+    out.append('*/')
+    out.append('')
+    out.append('// Generated by tools/gen_unicode_tables.py from Unicode %s. Do not edit.' % unicodedata.unidata_version)
+    out.append('')
+    out.append('#ifndef _UNICODE_TABLES_HPP_INCLUDED_')
+    out.append('#define _UNICODE_TABLES_HPP_INCLUDED_')
+    out.append('')
+    out.append('#include <stdint.h>')
+    out.append('')
+    out.append('namespace unicode_helper')
+    out.append('{')
+    out.append('\tnamespace tables')
+    out.append('\t{')
+    out.append('\t\tconstexpr char kVersion[] = "%s";' % unicodedata.unidata_version)
+    out.append('\t\tconstexpr unsigned kShift = %d;' % SHIFT)
+    out.append('')
+    out.append('\t\t// Simple case folding: cp + fold_delta[fold_stage2[(fold_stage1[cp >> kShift] << kShift) + (cp & mask)]]')
+    emit_array(out, c_type(fold1), 'fold_stage1', fold1, 32)
+    emit_array(out, c_type(fold2), 'fold_stage2', fold2, 32)
+    emit_array(out, 'int32_t', 'fold_delta', deltas, 12)
+    out.append('\t\t// Normalization: props[...] = ccc | quick_check << 8 | decomposition length << 10 | offset << 16')
+    emit_array(out, c_type(props1), 'props_stage1', props1, 32)
+    emit_array(out, c_type(props2), 'props_stage2', props2, 24)
+    emit_array(out, 'uint32_t', 'props', records, 8)
+    emit_array(out, 'uint32_t', 'decomposition', decomp, 12)
+    out.append('\t\t// Primary composites, sorted by first << 32 | second')
+    emit_array(out, 'uint64_t', 'compose_pairs', ['0x%XULL' % (a << 32 | b) for (a, b) in pair_keys], 6)
+    emit_array(out, 'uint32_t', 'compose_result', [pairs[k] for k in pair_keys], 12)
+    out.append('\t}')
+    out.append('}')
+    out.append('')
+    out.append('#endif // _UNICODE_TABLES_HPP_INCLUDED_')
+    sys.stdout.write('\n'.join(out) + '\n')
+
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,885 @@
+/*
+* Author: LowBoyTeam (https://github.com/LowBoyTeam)
+* License: Code Project Open License
+* Disclaimer: The software is provided "as-is". No claim of suitability, guarantee, or any warranty whatsoever is provided.
+* Copyright (c) 2016-2017.
+*/
+
+#ifndef _UNICODE_HELPER_HPP_INCLUDED_
+#define _UNICODE_HELPER_HPP_INCLUDED_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#include "cpu_helper.hpp"
+#include "unicode_tables.hpp"
+
+////////////////////////////////////////////////////////
+// Unicode case folding and NFC normalization
+//
+//  Works on UTF-8 (char), UTF-16 (char16_t, and wchar_t on Windows) and
+//  UTF-32 (char32_t, and wchar_t elsewhere). Every function appends to out.
+//  Ill-formed input (stray continuation bytes, lone surrogates, ...)
+//  becomes U+FFFD in the output, and the function returns false.
+//
+//  casefold()   simple case folding (CaseFolding.txt C + S): one code point
+//               to one code point, so the text keeps its shape.
+//  normalize()  NFC.
+//  fold_key()   NFC(casefold(NFD(s))): two strings that differ only in case
+//               or in canonical normalization get the same key. Use it for
+//               case-insensitive user names and similar keys.
+//  is_nfc()     whether text is already in NFC.
+//
+//  The properties come from unicode_tables.hpp, which holds two-stage tables
+//  generated by tools/gen_unicode_tables.py. Runs of ASCII are scanned with
+//  SIMD, and so are runs below U+0300 (Latin-1, Latin Extended, IPA) for NFC,
+//  which need no lookup. Other code points that are already NFC (quick
+//  check "Yes", in canonical order) are passed through unchanged after one
+//  table lookup each. Only the short segment around a code point that needs
+//  work is decoded, decomposed, reordered and recomposed. Already normalized
+//  text is therefore copied at close to memcpy speed when it is ASCII or
+//  Latin; other scripts pay the decode and lookup per code point.
+//
+//  casefolder_t and normalizer_t take text in pieces of any size, even ones
+//  that split a UTF-8 sequence or a combining sequence.
+//
+//  Usage:
+//    std::string key;
+//    unicode_helper::fold_key(user_name, key);
+//
+//    unicode_helper::normalizer_t<wchar_t> nfc;
+//    while (read(chunk))
+//        nfc.update(chunk, out);
+//    nfc.finish(out);
+
+namespace unicode_helper
+{
+	namespace detail
+	{
+		template <class T>
+		struct identity
+		{
+			typedef T type;
+		};
+
+		enum
+		{
+			kQcYes = 0,
+			kQcMaybe = 1,
+			kQcNo = 2
+		};
+
+		enum : uint32_t
+		{
+			kReplacement = 0xFFFD,
+			kHangulSBase = 0xAC00,
+			kHangulLBase = 0x1100,
+			kHangulVBase = 0x1161,
+			kHangulTBase = 0x11A7,
+			kHangulLCount = 19,
+			kHangulVCount = 21,
+			kHangulTCount = 28,
+			kHangulNCount = kHangulVCount * kHangulTCount,
+			kHangulSCount = kHangulLCount * kHangulNCount
+		};
+
+		inline uint32_t fold(uint32_t cp)
+		{
+			const uint32_t block = tables::fold_stage1[cp >> tables::kShift];
+			const uint32_t index = tables::fold_stage2[(block << tables::kShift) + (cp & ((1u << tables::kShift) - 1))];
+			return (uint32_t)((int32_t)cp + tables::fold_delta[index]);
+		}
+
+		// ccc | quick check << 8 | decomposition length << 10 | offset << 16
+		inline uint32_t props(uint32_t cp)
+		{
+			const uint32_t block = tables::props_stage1[cp >> tables::kShift];
+			return tables::props[tables::props_stage2[(block << tables::kShift) + (cp & ((1u << tables::kShift) - 1))]];
+		}
+
+		inline unsigned ccc_of(uint32_t p) { return p & 0xFF; }
+		inline unsigned qc_of(uint32_t p) { return (p >> 8) & 3; }
+		inline unsigned length_of(uint32_t p) { return (p >> 10) & 7; }
+		inline const uint32_t* decomposition_of(uint32_t p) { return tables::decomposition + (p >> 16); }
+
+		inline unsigned ccc(uint32_t cp) { return ccc_of(props(cp)); }
+
+		// True if folding cp, or any code point of its decomposition, changes nothing
+		inline bool fold_stable(uint32_t cp, uint32_t p)
+		{
+			if (fold(cp) != cp)
+				return false;
+			const uint32_t* d = decomposition_of(p);
+			for (unsigned i = 0, n = length_of(p); i < n; ++i) {
+				if (fold(d[i]) != d[i])
+					return false;
+			}
+			return true;
+		}
+
+		inline void decompose(uint32_t cp, std::vector<uint32_t>& out)
+		{
+			if (cp - kHangulSBase < kHangulSCount) {
+				const uint32_t s = cp - kHangulSBase;
+				out.push_back(kHangulLBase + s / kHangulNCount);
+				out.push_back(kHangulVBase + (s % kHangulNCount) / kHangulTCount);
+				if (s % kHangulTCount != 0)
+					out.push_back(kHangulTBase + s % kHangulTCount);
+				return;
+			}
+			const uint32_t p = props(cp);
+			const unsigned n = length_of(p);
+			if (n == 0) {
+				out.push_back(cp);
+				return;
+			}
+			const uint32_t* d = decomposition_of(p);
+			out.insert(out.end(), d, d + n);
+		}
+
+		// Primary composite of a + b, or 0
+		inline uint32_t compose(uint32_t a, uint32_t b)
+		{
+			if (a - kHangulLBase < kHangulLCount && b - kHangulVBase < kHangulVCount)
+				return kHangulSBase + ((a - kHangulLBase) * kHangulVCount + (b - kHangulVBase)) * kHangulTCount;
+			if (a - kHangulSBase < kHangulSCount && (a - kHangulSBase) % kHangulTCount == 0 && b - kHangulTBase - 1 < kHangulTCount - 1)
+				return a + (b - kHangulTBase);
+
+			const uint64_t key = (uint64_t)a << 32 | b;
+			const size_t count = sizeof(tables::compose_pairs) / sizeof(tables::compose_pairs[0]);
+			size_t lo = 0, hi = count;
+			while (lo < hi) {
+				const size_t mid = (lo + hi) / 2;
+				if (tables::compose_pairs[mid] < key)
+					lo = mid + 1;
+				else
+					hi = mid;
+			}
+			return lo < count && tables::compose_pairs[lo] == key ? tables::compose_result[lo] : 0;
+		}
+
+		// Stable sort of every run of non-starters by combining class
+		inline void canonical_order(std::vector<uint32_t>& cps)
+		{
+			for (size_t i = 1; i < cps.size(); ++i) {
+				const uint32_t c = cps[i];
+				const unsigned cc = ccc(c);
+				if (cc == 0)
+					continue;
+				size_t j = i;
+				while (j > 0 && ccc(cps[j - 1]) > cc) {
+					cps[j] = cps[j - 1];
+					--j;
+				}
+				cps[j] = c;
+			}
+		}
+
+		// Canonical composition of a decomposed, ordered sequence
+		inline void compose_all(std::vector<uint32_t>& cps)
+		{
+			if (cps.empty())
+				return;
+			size_t starter = ccc(cps[0]) == 0 ? 0 : (size_t)-1;
+			int last_cc = -1;			// combining class of the last kept code point after starter, -1 if none
+			size_t w = 1;
+			for (size_t i = 1; i < cps.size(); ++i) {
+				const uint32_t c = cps[i];
+				const int cc = (int)ccc(c);
+				if (starter != (size_t)-1 && (last_cc == -1 || last_cc < cc)) {
+					const uint32_t composite = compose(cps[starter], c);
+					if (composite != 0) {
+						cps[starter] = composite;
+						continue;
+					}
+				}
+				if (cc == 0) {
+					starter = w;
+					last_cc = -1;
+				}
+				else {
+					last_cc = cc;
+				}
+				cps[w++] = c;
+			}
+			cps.resize(w);
+		}
+
+		////////////////////////////////////////////////////////
+		// Encodings. decode() reads one code point and advances p; on
+		// ill-formed input it skips one unit, returns false and sets cp to
+		// U+FFFD. incomplete() is the number of units at the end of a piece
+		// that may be the start of a code point continued in the next piece.
+
+		template <class Char>
+		struct utf8_codec
+		{
+			static bool decode(const Char*& p, const Char* end, uint32_t& cp)
+			{
+				const unsigned c = (unsigned char)*p;
+				if (c < 0x80) {
+					cp = c;
+					++p;
+					return true;
+				}
+				unsigned length;
+				uint32_t value, min;
+				if (c >= 0xC2 && c <= 0xDF) {
+					length = 2;
+					value = c & 0x1F;
+					min = 0x80;
+				}
+				else if (c >= 0xE0 && c <= 0xEF) {
+					length = 3;
+					value = c & 0x0F;
+					min = 0x800;
+				}
+				else if (c >= 0xF0 && c <= 0xF4) {
+					length = 4;
+					value = c & 0x07;
+					min = 0x10000;
+				}
+				else {
+					return fail(p, cp);
+				}
+				if ((size_t)(end - p) < length)
+					return fail(p, cp);
+				for (unsigned i = 1; i < length; ++i) {
+					const unsigned t = (unsigned char)p[i];
+					if ((t & 0xC0) != 0x80)
+						return fail(p, cp);
+					value = (value << 6) | (t & 0x3F);
+				}
+				if (value < min || value > 0x10FFFF || (value >= 0xD800 && value <= 0xDFFF))
+					return fail(p, cp);
+				cp = value;
+				p += length;
+				return true;
+			}
+
+			// Writes cp at dst and returns the number of units written (at most 4)
+			static size_t put(uint32_t cp, Char* dst)
+			{
+				if (cp < 0x80) {
+					dst[0] = (Char)cp;
+					return 1;
+				}
+				if (cp < 0x800) {
+					dst[0] = (Char)(0xC0 | (cp >> 6));
+					dst[1] = (Char)(0x80 | (cp & 0x3F));
+					return 2;
+				}
+				if (cp < 0x10000) {
+					dst[0] = (Char)(0xE0 | (cp >> 12));
+					dst[1] = (Char)(0x80 | ((cp >> 6) & 0x3F));
+					dst[2] = (Char)(0x80 | (cp & 0x3F));
+					return 3;
+				}
+				dst[0] = (Char)(0xF0 | (cp >> 18));
+				dst[1] = (Char)(0x80 | ((cp >> 12) & 0x3F));
+				dst[2] = (Char)(0x80 | ((cp >> 6) & 0x3F));
+				dst[3] = (Char)(0x80 | (cp & 0x3F));
+				return 4;
+			}
+
+			static void encode(uint32_t cp, std::basic_string<Char>& out)
+			{
+				Char buffer[4];
+				out.append(buffer, put(cp, buffer));
+			}
+
+			static size_t incomplete(const Char* begin, const Char* end)
+			{
+				for (size_t k = 1; k <= 3 && k <= (size_t)(end - begin); ++k) {
+					const unsigned c = (unsigned char)end[-(ptrdiff_t)k];
+					if ((c & 0xC0) == 0x80)
+						continue;
+					const size_t need = c >= 0xC2 && c <= 0xDF ? 2 : c >= 0xE0 && c <= 0xEF ? 3 : c >= 0xF0 && c <= 0xF4 ? 4 : 0;
+					return need > k ? k : 0;
+				}
+				return 0;
+			}
+
+		private:
+			static bool fail(const Char*& p, uint32_t& cp)
+			{
+				++p;
+				cp = kReplacement;
+				return false;
+			}
+		};
+
+		template <class Char>
+		struct utf16_codec
+		{
+			static bool decode(const Char*& p, const Char* end, uint32_t& cp)
+			{
+				const uint32_t u = (uint16_t)*p++;
+				if (u < 0xD800 || u > 0xDFFF) {
+					cp = u;
+					return true;
+				}
+				if (u <= 0xDBFF && p < end && (uint16_t)*p >= 0xDC00 && (uint16_t)*p <= 0xDFFF) {
+					cp = 0x10000 + ((u - 0xD800) << 10) + ((uint16_t)*p++ - 0xDC00);
+					return true;
+				}
+				cp = kReplacement;
+				return false;
+			}
+
+			static size_t put(uint32_t cp, Char* dst)
+			{
+				if (cp < 0x10000) {
+					dst[0] = (Char)cp;
+					return 1;
+				}
+				dst[0] = (Char)(0xD800 + ((cp - 0x10000) >> 10));
+				dst[1] = (Char)(0xDC00 + ((cp - 0x10000) & 0x3FF));
+				return 2;
+			}
+
+			static void encode(uint32_t cp, std::basic_string<Char>& out)
+			{
+				if (cp < 0x10000) {
+					out.push_back((Char)cp);
+				}
+				else {
+					Char pair[2];
+					out.append(pair, put(cp, pair));
+				}
+			}
+
+			static size_t incomplete(const Char* begin, const Char* end)
+			{
+				return end > begin && (uint16_t)end[-1] >= 0xD800 && (uint16_t)end[-1] <= 0xDBFF ? 1 : 0;
+			}
+		};
+
+		template <class Char>
+		struct utf32_codec
+		{
+			static bool decode(const Char*& p, const Char* end, uint32_t& cp)
+			{
+				(void)end;
+				cp = (uint32_t)*p++;
+				if (cp > 0x10FFFF || (cp >= 0xD800 && cp <= 0xDFFF)) {
+					cp = kReplacement;
+					return false;
+				}
+				return true;
+			}
+
+			static size_t put(uint32_t cp, Char* dst)
+			{
+				dst[0] = (Char)cp;
+				return 1;
+			}
+
+			static void encode(uint32_t cp, std::basic_string<Char>& out)
+			{
+				out.push_back((Char)cp);
+			}
+
+			static size_t incomplete(const Char*, const Char*)
+			{
+				return 0;
+			}
+		};
+
+		template <class Char, size_t Size = sizeof(Char)>
+		struct codec_for;
+
+		template <class Char>
+		struct codec_for<Char, 1>
+		{
+			typedef utf8_codec<Char> type;
+		};
+
+		template <class Char>
+		struct codec_for<Char, 2>
+		{
+			typedef utf16_codec<Char> type;
+		};
+
+		template <class Char>
+		struct codec_for<Char, 4>
+		{
+			typedef utf32_codec<Char> type;
+		};
+
+		////////////////////////////////////////////////////////
+		// ASCII fast paths
+
+		// Length of the run of ASCII units at p
+		template <class Char>
+		inline size_t ascii_run(const Char* p, const Char* end)
+		{
+			const size_t n = (size_t)(end - p);
+			size_t i = 0;
+#ifdef CPU_HELPER_HAS_SSE2
+			if (sizeof(Char) == 1) {
+				for (; i + 16 <= n; i += 16) {
+					const unsigned mask = (unsigned)_mm_movemask_epi8(_mm_loadu_si128((const __m128i*)(p + i)));
+					if (mask != 0)
+						return i + cpu_helper::ctz32(mask);
+				}
+			}
+			else if (sizeof(Char) == 2) {
+				const __m128i high = _mm_set1_epi16((short)0xFF80);
+				for (; i + 8 <= n; i += 8) {
+					const __m128i v = _mm_and_si128(_mm_loadu_si128((const __m128i*)(p + i)), high);
+					const unsigned mask = ~(unsigned)_mm_movemask_epi8(_mm_cmpeq_epi16(v, _mm_setzero_si128())) & 0xFFFF;
+					if (mask != 0)
+						return i + cpu_helper::ctz32(mask) / 2;
+				}
+			}
+#endif
+			while (i < n && (uint32_t)(typename std::make_unsigned<Char>::type)p[i] < 0x80)
+				++i;
+			return i;
+		}
+
+		// Length of the run of code points below U+0300 at p. Those are all
+		// starters with quick check "Yes", so the run is NFC as it stands. In
+		// UTF-8 that is ASCII and well-formed pairs with a lead byte below 0xCC.
+		template <class Char>
+		inline size_t nfc_run(const Char* p, const Char* end)
+		{
+			const size_t n = (size_t)(end - p);
+			size_t i = 0;
+			if (sizeof(Char) == 1) {
+#ifdef CPU_HELPER_HAS_SSE2
+				// As signed bytes, leads C2..CB are -62..-53, continuations -128..-65
+				const __m128i lead_lo = _mm_set1_epi8(-63), lead_hi = _mm_set1_epi8(-52), cont_hi = _mm_set1_epi8(-64);
+				while (i + 16 <= n) {
+					const __m128i v = _mm_loadu_si128((const __m128i*)(p + i));
+					const unsigned high = (unsigned)_mm_movemask_epi8(v);
+					if (high == 0) {
+						i += 16;
+						continue;
+					}
+					const unsigned lead = (unsigned)_mm_movemask_epi8(_mm_and_si128(_mm_cmpgt_epi8(v, lead_lo), _mm_cmplt_epi8(v, lead_hi)));
+					const unsigned cont = (unsigned)_mm_movemask_epi8(_mm_cmplt_epi8(v, cont_hi));
+					// Each lead needs a continuation after it and each continuation a lead before it
+					const unsigned bad = (high & ~lead & ~cont) | (cont & ~(lead << 1)) | (lead & ~(cont >> 1));
+					if (bad == 0) {
+						i += 16;
+						continue;
+					}
+					// A pair split by the block end is checked with the next block
+					if (bad == 0x8000 && (lead & 0x8000)) {
+						i += 15;
+						continue;
+					}
+					return i + cpu_helper::ctz32(bad);
+				}
+#endif
+				while (i < n) {
+					const unsigned char c = (unsigned char)p[i];
+					if (c < 0x80)
+						++i;
+					else if (c >= 0xC2 && c <= 0xCB && i + 1 < n && ((unsigned char)p[i + 1] & 0xC0) == 0x80)
+						i += 2;
+					else
+						break;
+				}
+				return i;
+			}
+#ifdef CPU_HELPER_HAS_SSE2
+			if (sizeof(Char) == 2) {
+				const __m128i top = _mm_set1_epi16(0x2FF);
+				for (; i + 8 <= n; i += 8) {
+					const __m128i over = _mm_subs_epu16(_mm_loadu_si128((const __m128i*)(p + i)), top);
+					const unsigned mask = ~(unsigned)_mm_movemask_epi8(_mm_cmpeq_epi16(over, _mm_setzero_si128())) & 0xFFFF;
+					if (mask != 0)
+						return i + cpu_helper::ctz32(mask) / 2;
+				}
+			}
+#endif
+			while (i < n && (uint32_t)(typename std::make_unsigned<Char>::type)p[i] < 0x300)
+				++i;
+			return i;
+		}
+
+		// Start of the last code point of a run that ends at p
+		template <class Char>
+		inline const Char* run_last(const Char* p)
+		{
+			return sizeof(Char) == 1 && (unsigned char)p[-1] >= 0x80 ? p - 2 : p - 1;
+		}
+
+		// Copies n units and lowercases the ASCII letters among them
+		template <class Char>
+		inline void ascii_lower(Char* dst, const Char* src, size_t n)
+		{
+			size_t i = 0;
+#ifdef CPU_HELPER_HAS_SSE2
+			// Signed compares: units of 0x80 and up are negative or above 'Z'
+			if (sizeof(Char) == 1) {
+				const __m128i a = _mm_set1_epi8('A' - 1), z = _mm_set1_epi8('Z' + 1), bit = _mm_set1_epi8(0x20);
+				for (; i + 16 <= n; i += 16) {
+					const __m128i v = _mm_loadu_si128((const __m128i*)(src + i));
+					const __m128i upper = _mm_and_si128(_mm_cmpgt_epi8(v, a), _mm_cmplt_epi8(v, z));
+					_mm_storeu_si128((__m128i*)(dst + i), _mm_or_si128(v, _mm_and_si128(upper, bit)));
+				}
+			}
+			else if (sizeof(Char) == 2) {
+				const __m128i a = _mm_set1_epi16('A' - 1), z = _mm_set1_epi16('Z' + 1), bit = _mm_set1_epi16(0x20);
+				for (; i + 8 <= n; i += 8) {
+					const __m128i v = _mm_loadu_si128((const __m128i*)(src + i));
+					const __m128i upper = _mm_and_si128(_mm_cmpgt_epi16(v, a), _mm_cmplt_epi16(v, z));
+					_mm_storeu_si128((__m128i*)(dst + i), _mm_or_si128(v, _mm_and_si128(upper, bit)));
+				}
+			}
+#endif
+			for (; i < n; ++i) {
+				const Char c = src[i];
+				dst[i] = c >= 'A' && c <= 'Z' ? (Char)(c | 0x20) : c;
+			}
+		}
+
+		template <class Char>
+		inline void append_lower(std::basic_string<Char>& out, const Char* src, size_t n)
+		{
+			if (n == 0)
+				return;
+			const size_t pos = out.size();
+			out.resize(pos + n);
+			ascii_lower(&out[pos], src, n);
+		}
+
+		////////////////////////////////////////////////////////
+		// Engines
+
+		template <class Char>
+		bool casefold(const Char* p, const Char* end, std::basic_string<Char>& out)
+		{
+			typedef typename codec_for<Char>::type codec;
+			bool ok = true;
+			// Folded text is nearly always the size of the input; only a few
+			// UTF-8 letters (U+023A to U+2C65 and the like) grow, by one unit
+			const size_t pos = out.size();
+			out.resize(pos + (size_t)(end - p) + 4);
+			Char* dst = &out[pos];
+			while (p < end) {
+				const size_t run = ascii_run(p, end);
+				ascii_lower(dst, p, run);
+				p += run;
+				dst += run;
+				if (p == end)
+					break;
+				uint32_t cp;
+				const Char* from = p;
+				if (!codec::decode(p, end, cp))
+					ok = false;
+				cp = fold(cp);
+				if ((size_t)(&out[0] + out.size() - dst) < 4 + (size_t)(end - p)) {
+					// Less room than the input left plus one code point: grow
+					const size_t done = (size_t)(dst - &out[0]);
+					out.resize(done + (size_t)(end - from) + (size_t)(end - from) / 2 + 4);
+					dst = &out[0] + done;
+				}
+				dst += codec::put(cp, dst);
+			}
+			out.resize((size_t)(dst - &out[0]));
+			return ok;
+		}
+
+		// Start of the segment following the one that contains p: the next
+		// starter with quick check "Yes", or end
+		template <class Char>
+		const Char* segment_end(const Char* p, const Char* end)
+		{
+			typedef typename codec_for<Char>::type codec;
+			while (p < end) {
+				const Char* q = p;
+				uint32_t c;
+				if (codec::decode(q, end, c)) {
+					const uint32_t pr = props(c);
+					if (ccc_of(pr) == 0 && qc_of(pr) == kQcYes)
+						break;
+				}
+				p = q;
+			}
+			return p;
+		}
+
+		// Decodes [p, end), decomposes, reorders, (folds,) composes, encodes
+		template <class Char, bool Fold>
+		bool normalize_segment(const Char* p, const Char* end, std::basic_string<Char>& out, std::vector<uint32_t>& cps, std::vector<uint32_t>& tmp)
+		{
+			typedef typename codec_for<Char>::type codec;
+			bool ok = true;
+			cps.clear();
+			while (p < end) {
+				uint32_t cp;
+				if (!codec::decode(p, end, cp))
+					ok = false;
+				decompose(cp, cps);
+			}
+			canonical_order(cps);
+			if (Fold) {
+				// Fold the NFD form: U+0345 folds to a starter, so the order
+				// it had as a combining mark matters
+				tmp.clear();
+				for (size_t i = 0; i < cps.size(); ++i)
+					decompose(fold(cps[i]), tmp);
+				cps.swap(tmp);
+				canonical_order(cps);
+			}
+			compose_all(cps);
+			for (size_t i = 0; i < cps.size(); ++i)
+				codec::encode(cps[i], out);
+			return ok;
+		}
+
+		// NFC (or fold key) of [begin, end). With flush false the text may
+		// continue: output stops at the last point nothing later can change,
+		// and *stop is where the caller has to resume.
+		template <class Char, bool Fold>
+		bool normalize(const Char* begin, const Char* end, std::basic_string<Char>& out, bool flush, const Char** stop, std::vector<uint32_t>& cps, std::vector<uint32_t>& tmp)
+		{
+			typedef typename codec_for<Char>::type codec;
+			bool ok = true;
+			const Char* copied = begin;		// [copied, boundary) is final and unchanged (bar ASCII case)
+			const Char* boundary = begin;	// start of the last starter nothing can combine across
+			unsigned last_ccc = 0;
+			const Char* p = begin;
+			out.reserve(out.size() + (size_t)(end - begin));
+
+			while (p < end) {
+				// Folding changes letters below U+0300, so only ASCII is safe to skip
+				const size_t run = Fold ? ascii_run(p, end) : nfc_run(p, end);
+				if (run != 0) {
+					p += run;
+					boundary = run_last(p);
+					last_ccc = 0;
+					if (p == end)
+						break;
+				}
+
+				const Char* next = p;
+				uint32_t cp;
+				if (codec::decode(next, end, cp)) {
+					const uint32_t pr = props(cp);
+					const unsigned cc = ccc_of(pr);
+					if (qc_of(pr) == kQcYes && (cc == 0 || cc >= last_ccc) && (!Fold || fold_stable(cp, pr))) {
+						if (cc == 0)
+							boundary = p;
+						last_ccc = cc;
+						p = next;
+						continue;
+					}
+				}
+
+				// Needs work: redo from the last boundary up to the next one
+				const Char* last = segment_end(next, end);
+				if (Fold)
+					append_lower(out, copied, (size_t)(boundary - copied));
+				else
+					out.append(copied, (size_t)(boundary - copied));
+				if (!flush && last == end) {
+					*stop = boundary;
+					return ok;
+				}
+				if (!normalize_segment<Char, Fold>(boundary, last, out, cps, tmp))
+					ok = false;
+				copied = boundary = p = last;
+				last_ccc = 0;
+			}
+
+			const Char* done = flush ? end : boundary;
+			if (Fold)
+				append_lower(out, copied, (size_t)(done - copied));
+			else
+				out.append(copied, (size_t)(done - copied));
+			*stop = done;
+			return ok;
+		}
+
+		template <class Char>
+		bool is_nfc(const Char* p, const Char* end)
+		{
+			typedef typename codec_for<Char>::type codec;
+			const Char* boundary = p;
+			unsigned last_ccc = 0;
+			std::basic_string<Char> redone;
+			std::vector<uint32_t> cps, tmp;
+			while (p < end) {
+				const size_t run = nfc_run(p, end);
+				if (run != 0) {
+					p += run;
+					boundary = run_last(p);
+					last_ccc = 0;
+					if (p == end)
+						break;
+				}
+				const Char* next = p;
+				uint32_t cp;
+				if (!codec::decode(next, end, cp))
+					return false;
+				const uint32_t pr = props(cp);
+				const unsigned cc = ccc_of(pr);
+				if (qc_of(pr) == kQcNo || (cc != 0 && cc < last_ccc))
+					return false;
+				if (qc_of(pr) == kQcMaybe) {
+					// May or may not compose with what precedes: normalize the
+					// segment and compare
+					const Char* last = segment_end(next, end);
+					redone.clear();
+					normalize_segment<Char, false>(boundary, last, redone, cps, tmp);
+					if (redone.size() != (size_t)(last - boundary) || redone.compare(0, redone.size(), boundary, redone.size()) != 0)
+						return false;
+					boundary = p = last;
+					last_ccc = 0;
+					continue;
+				}
+				if (cc == 0)
+					boundary = p;
+				last_ccc = cc;
+				p = next;
+			}
+			return true;
+		}
+
+		// Shared by casefolder_t and normalizer_t: keeps what a piece could not
+		// finish (a split code point, an open combining sequence) for the next one
+		template <class Char, class Process>
+		bool feed(std::basic_string<Char>& pending, std::basic_string_view<Char> in, bool flush, Process process)
+		{
+			typedef typename codec_for<Char>::type codec;
+			const Char* begin;
+			const Char* end;
+			if (pending.empty()) {
+				begin = in.data();
+				end = begin + in.size();
+			}
+			else {
+				pending.append(in.data(), in.size());
+				begin = pending.data();
+				end = begin + pending.size();
+			}
+			const Char* last = flush ? end : end - codec::incomplete(begin, end);
+			const Char* stop = last;
+			const bool ok = process(begin, last, flush, &stop);
+			std::basic_string<Char> rest(stop, end);
+			pending.swap(rest);
+			return ok;
+		}
+	}
+
+	// Appends the simple case folding of in to out
+	template <class Char>
+	bool casefold(std::basic_string_view<typename detail::identity<Char>::type> in, std::basic_string<Char>& out)
+	{
+		return detail::casefold(in.data(), in.data() + in.size(), out);
+	}
+
+	// Appends the NFC form of in to out
+	template <class Char>
+	bool normalize(std::basic_string_view<typename detail::identity<Char>::type> in, std::basic_string<Char>& out)
+	{
+		std::vector<uint32_t> cps, tmp;
+		const Char* stop;
+		return detail::normalize<Char, false>(in.data(), in.data() + in.size(), out, true, &stop, cps, tmp);
+	}
+
+	// Appends the case-insensitive key of in to out
+	template <class Char>
+	bool fold_key(std::basic_string_view<typename detail::identity<Char>::type> in, std::basic_string<Char>& out)
+	{
+		std::vector<uint32_t> cps, tmp;
+		const Char* stop;
+		return detail::normalize<Char, true>(in.data(), in.data() + in.size(), out, true, &stop, cps, tmp);
+	}
+
+	inline bool is_nfc(std::string_view in) { return detail::is_nfc(in.data(), in.data() + in.size()); }
+	inline bool is_nfc(std::u16string_view in) { return detail::is_nfc(in.data(), in.data() + in.size()); }
+	inline bool is_nfc(std::u32string_view in) { return detail::is_nfc(in.data(), in.data() + in.size()); }
+	inline bool is_nfc(std::wstring_view in) { return detail::is_nfc(in.data(), in.data() + in.size()); }
+
+	// casefold() over text that arrives in pieces
+	template <class Char>
+	class casefolder_t
+	{
+	public:
+		casefolder_t() : m_ok(true) {}
+
+		void update(std::basic_string_view<Char> in, std::basic_string<Char>& out) { process(in, out, false); }
+
+		// Flushes what is left; returns false if any of the text was ill-formed
+		bool finish(std::basic_string<Char>& out)
+		{
+			process(std::basic_string_view<Char>(), out, true);
+			const bool ok = m_ok;
+			reset();
+			return ok;
+		}
+
+		void reset()
+		{
+			m_pending.clear();
+			m_ok = true;
+		}
+
+	private:
+		void process(std::basic_string_view<Char> in, std::basic_string<Char>& out, bool flush)
+		{
+			if (!detail::feed(m_pending, in, flush, [&out](const Char* begin, const Char* end, bool, const Char** stop) {
+				*stop = end;
+				return detail::casefold(begin, end, out);
+			}))
+				m_ok = false;
+		}
+
+		std::basic_string<Char> m_pending;
+		bool m_ok;
+	};
+
+	// normalize() (or fold_key() with fold = true) over text that arrives in
+	// pieces. Output lags the input by at most one combining sequence.
+	template <class Char>
+	class normalizer_t
+	{
+	public:
+		explicit normalizer_t(bool fold = false) : m_fold(fold), m_ok(true) {}
+
+		void update(std::basic_string_view<Char> in, std::basic_string<Char>& out) { process(in, out, false); }
+
+		bool finish(std::basic_string<Char>& out)
+		{
+			process(std::basic_string_view<Char>(), out, true);
+			const bool ok = m_ok;
+			reset();
+			return ok;
+		}
+
+		void reset()
+		{
+			m_pending.clear();
+			m_ok = true;
+		}
+
+	private:
+		void process(std::basic_string_view<Char> in, std::basic_string<Char>& out, bool flush)
+		{
+			if (!detail::feed(m_pending, in, flush, [this, &out](const Char* begin, const Char* end, bool last, const Char** stop) {
+				return m_fold ? detail::normalize<Char, true>(begin, end, out, last, stop, m_cps, m_tmp)
+					: detail::normalize<Char, false>(begin, end, out, last, stop, m_cps, m_tmp);
+			}))
+				m_ok = false;
+		}
+
+		bool m_fold;
+		bool m_ok;
+		std::basic_string<Char> m_pending;
+		std::vector<uint32_t> m_cps;
+		std::vector<uint32_t> m_tmp;
+	};
+}
+
+#endif // _UNICODE_HELPER_HPP_INCLUDED_
@@ -0,0 +1,386 @@
+/*
+* Author: LowBoyTeam (https://github.com/LowBoyTeam)
+* License: Code Project Open License
+* Disclaimer: The software is provided "as-is". No claim of suitability, guarantee, or any warranty whatsoever is provided.
+* Copyright (c) 2016-2017.
+*/
+
+#ifndef _URI_HELPER_HPP_INCLUDED_
+#define _URI_HELPER_HPP_INCLUDED_
+
+#include <string>
+#include <string_view>
+#include <stdint.h>
+#include <string.h>
+
+////////////////////////////////////////////////////////
+// RFC 3986 URI parsing and normalization
+//
+//  parse() splits a URI reference in one pass and records every component as
+//  an offset/length pair into the original buffer, so nothing is copied:
+//
+//    scheme://userinfo@host:port/path?query#fragment
+//
+//  Bracketed IP literals ("[::1]") are returned without the brackets. The
+//  parser checks structure (brackets, port digits) but does not validate the
+//  character set of every component.
+//
+//  normalize() rewrites a URI in place into its RFC 3986 section 6.2.2 form:
+//  scheme and host lowercased, percent-encodings of unreserved characters
+//  decoded, remaining escapes uppercased, dot segments removed, default
+//  ports dropped and an empty path under an authority turned into "/".
+//
+//  Usage:
+//    uri_helper::uri_t u;
+//    if (uri_helper::parse(url, u))
+//        std::string_view host = uri_helper::component(url, u.host);
+//
+//    std::string key(url);
+//    uri_helper::normalize(key);
+
+namespace uri_helper
+{
+	static const size_t npos = (size_t)-1;
+
+	struct range_t
+	{
+		uint32_t offset;
+		uint32_t length;
+	};
+
+	struct uri_t
+	{
+		// Bits of flags telling which optional components were present. A present
+		// component may still be empty, as in "http://host/?".
+		enum
+		{
+			kScheme = 1,
+			kAuthority = 2,
+			kUserinfo = 4,
+			kPort = 8,
+			kQuery = 16,
+			kFragment = 32
+		};
+
+		range_t scheme;
+		range_t userinfo;
+		range_t host;
+		range_t port;
+		range_t path;
+		range_t query;
+		range_t fragment;
+		unsigned flags;
+		int port_number;	// -1 when no port digits were given
+		bool ip_literal;	// host was written in brackets
+
+		bool has(unsigned component) const { return (flags & component) != 0; }
+	};
+
+	inline std::string_view component(std::string_view url, range_t r)
+	{
+		return url.substr(r.offset, r.length);
+	}
+
+	namespace detail
+	{
+		inline bool is_alpha(unsigned char c) { return (unsigned char)((c | 0x20) - 'a') < 26; }
+		inline bool is_digit(unsigned char c) { return (unsigned char)(c - '0') < 10; }
+		inline bool is_scheme_char(unsigned char c) { return is_alpha(c) || is_digit(c) || c == '+' || c == '-' || c == '.'; }
+		inline bool is_unreserved(unsigned char c) { return is_alpha(c) || is_digit(c) || c == '-' || c == '.' || c == '_' || c == '~'; }
+		inline char to_lower(unsigned char c) { return (char)((unsigned char)(c - 'A') < 26 ? c | 0x20 : c); }
+
+		inline int hexval(unsigned char c)
+		{
+			if (is_digit(c))
+				return c - '0';
+			c |= 0x20;
+			return (c >= 'a' && c <= 'f') ? c - 'a' + 10 : -1;
+		}
+
+		inline range_t make_range(size_t offset, size_t length)
+		{
+			range_t r = { (uint32_t)offset, (uint32_t)length };
+			return r;
+		}
+
+		// Copies buf[offset, offset + length) to buf + w (w <= offset), decoding
+		// escaped unreserved characters and uppercasing the hex digits of the rest.
+		inline size_t normalize_escapes(char* buf, size_t w, size_t offset, size_t length, bool lower)
+		{
+			static const char hexchars[] = "0123456789ABCDEF";
+			const char* p = buf + offset;
+			const char* end = p + length;
+			while (p < end) {
+				unsigned char c = (unsigned char)*p;
+				if (c == '%' && end - p > 2 && hexval(p[1]) >= 0 && hexval(p[2]) >= 0) {
+					unsigned char v = (unsigned char)((hexval(p[1]) << 4) | hexval(p[2]));
+					if (is_unreserved(v)) {
+						buf[w++] = lower ? to_lower(v) : (char)v;
+					}
+					else {
+						buf[w++] = '%';
+						buf[w++] = hexchars[v >> 4];
+						buf[w++] = hexchars[v & 15];
+					}
+					p += 3;
+				}
+				else {
+					buf[w++] = lower ? to_lower(c) : (char)c;
+					++p;
+				}
+			}
+			return w;
+		}
+
+		inline bool is_default_port(std::string_view scheme, int port)
+		{
+			switch (port) {
+			case 80:
+				return scheme == "http" || scheme == "ws";
+			case 443:
+				return scheme == "https" || scheme == "wss";
+			case 21:
+				return scheme == "ftp";
+			default:
+				return false;
+			}
+		}
+	}
+
+	// Splits url into its components. Returns false if the authority is
+	// malformed (unclosed IP literal, non-numeric or out of range port).
+	inline bool parse(std::string_view url, uri_t& u)
+	{
+		const char* s = url.data();
+		const size_t n = url.size();
+		size_t i = 0;
+
+		memset(&u, 0, sizeof(u));
+		u.port_number = -1;
+		if (n > 0xFFFFFFFFu)
+			return false;
+
+		// scheme = ALPHA *( ALPHA / DIGIT / "+" / "-" / "." ) ":"
+		if (n > 0 && detail::is_alpha(s[0])) {
+			size_t j = 1;
+			while (j < n && detail::is_scheme_char(s[j]))
+				++j;
+			if (j < n && s[j] == ':') {
+				u.scheme = detail::make_range(0, j);
+				u.flags |= uri_t::kScheme;
+				i = j + 1;
+			}
+		}
+
+		if (n - i >= 2 && s[i] == '/' && s[i + 1] == '/') {
+			i += 2;
+			u.flags |= uri_t::kAuthority;
+
+			const size_t start = i;
+			size_t at = npos;
+			while (i < n && s[i] != '/' && s[i] != '?' && s[i] != '#') {
+				if (s[i] == '@')
+					at = i;
+				++i;
+			}
+			const size_t end = i;
+
+			size_t h = start;
+			if (at != npos) {
+				u.userinfo = detail::make_range(start, at - start);
+				u.flags |= uri_t::kUserinfo;
+				h = at + 1;
+			}
+
+			size_t p;
+			if (h < end && s[h] == '[') {
+				const char* close = (const char*)memchr(s + h, ']', end - h);
+				if (close == NULL)
+					return false;
+				p = close - s;
+				u.host = detail::make_range(h + 1, p - h - 1);
+				u.ip_literal = true;
+				++p;
+				if (p < end && s[p] != ':')
+					return false;
+			}
+			else {
+				p = h;
+				while (p < end && s[p] != ':')
+					++p;
+				u.host = detail::make_range(h, p - h);
+			}
+
+			if (p < end) {
+				u.port = detail::make_range(p + 1, end - p - 1);
+				u.flags |= uri_t::kPort;
+				if (end - p - 1 > 0) {
+					int value = 0;
+					for (size_t k = p + 1; k < end; ++k) {
+						if (!detail::is_digit(s[k]))
+							return false;
+						value = value * 10 + (s[k] - '0');
+						if (value > 65535)
+							return false;
+					}
+					u.port_number = value;
+				}
+			}
+		}
+
+		const size_t path = i;
+		while (i < n && s[i] != '?' && s[i] != '#')
+			++i;
+		u.path = detail::make_range(path, i - path);
+
+		if (i < n && s[i] == '?') {
+			const size_t query = ++i;
+			const char* hash = (const char*)memchr(s + i, '#', n - i);
+			i = hash ? hash - s : n;
+			u.query = detail::make_range(query, i - query);
+			u.flags |= uri_t::kQuery;
+		}
+
+		if (i < n) {
+			u.fragment = detail::make_range(i + 1, n - i - 1);
+			u.flags |= uri_t::kFragment;
+		}
+
+		return true;
+	}
+
+	// RFC 3986 section 5.2.4 on path[0, len), in place. Returns the new length.
+	inline size_t remove_dot_segments(char* path, size_t len)
+	{
+		size_t r = 0, w = 0;
+		while (r < len) {
+			const char* in = path + r;
+			const size_t rest = len - r;
+
+			if (rest >= 3 && in[0] == '.' && in[1] == '.' && in[2] == '/') {
+				r += 3;
+			}
+			else if (rest >= 2 && in[0] == '.' && in[1] == '/') {
+				r += 2;
+			}
+			else if (rest >= 3 && in[0] == '/' && in[1] == '.' && in[2] == '/') {
+				r += 2;
+			}
+			else if (rest == 2 && in[0] == '/' && in[1] == '.') {
+				path[w++] = '/';
+				r = len;
+			}
+			else if (rest >= 3 && in[0] == '/' && in[1] == '.' && in[2] == '.' && (rest == 3 || in[3] == '/')) {
+				// Drop the last output segment together with its leading '/'
+				while (w > 0 && path[w - 1] != '/')
+					--w;
+				if (w > 0)
+					--w;
+				if (rest == 3) {
+					path[w++] = '/';
+					r = len;
+				}
+				else {
+					r += 3;
+				}
+			}
+			else if ((rest == 1 && in[0] == '.') || (rest == 2 && in[0] == '.' && in[1] == '.')) {
+				r = len;
+			}
+			else {
+				// Move the first segment, including its leading '/', to the output
+				do {
+					path[w++] = path[r++];
+				} while (r < len && path[r] != '/');
+			}
+		}
+		return w;
+	}
+
+	// Normalizes buf[0, len) in place and returns the new length, or npos if
+	// the URI does not parse. buf must have room for len + 1 bytes because
+	// "http://host" becomes "http://host/".
+	inline size_t normalize(char* buf, size_t len)
+	{
+		uri_t u;
+		if (!parse(std::string_view(buf, len), u))
+			return npos;
+
+		size_t w = 0;
+		if (u.has(uri_t::kScheme)) {
+			for (; w < u.scheme.length; ++w)
+				buf[w] = detail::to_lower(buf[w]);
+			buf[w++] = ':';
+		}
+
+		if (u.has(uri_t::kAuthority)) {
+			buf[w++] = '/';
+			buf[w++] = '/';
+			if (u.has(uri_t::kUserinfo)) {
+				w = detail::normalize_escapes(buf, w, u.userinfo.offset, u.userinfo.length, false);
+				buf[w++] = '@';
+			}
+			if (u.ip_literal)
+				buf[w++] = '[';
+			w = detail::normalize_escapes(buf, w, u.host.offset, u.host.length, true);
+			if (u.ip_literal)
+				buf[w++] = ']';
+			if (u.port_number >= 0 && !detail::is_default_port(std::string_view(buf, u.scheme.length), u.port_number)) {
+				buf[w++] = ':';
+				memmove(buf + w, buf + u.port.offset, u.port.length);
+				w += u.port.length;
+			}
+		}
+
+		const size_t path = w;
+		w = detail::normalize_escapes(buf, w, u.path.offset, u.path.length, false);
+		w = path + remove_dot_segments(buf + path, w - path);
+
+		size_t tail = u.path.offset + u.path.length;
+		if (u.has(uri_t::kAuthority) && w == path) {
+			if (tail == w) {
+				// No slack left in front of the query/fragment: shift them right by one
+				memmove(buf + tail + 1, buf + tail, len - tail);
+				++tail;
+				++len;
+				u.query.offset++;
+				u.fragment.offset++;
+			}
+			buf[w++] = '/';
+		}
+
+		if (u.has(uri_t::kQuery)) {
+			buf[w++] = '?';
+			w = detail::normalize_escapes(buf, w, u.query.offset, u.query.length, false);
+		}
+		if (u.has(uri_t::kFragment)) {
+			buf[w++] = '#';
+			w = detail::normalize_escapes(buf, w, u.fragment.offset, u.fragment.length, false);
+		}
+		return w;
+	}
+
+	inline bool normalize(std::string& url)
+	{
+		size_t len = url.size();
+		url.push_back('\0');
+		len = normalize(&url[0], len);
+		if (len == npos) {
+			url.pop_back();
+			return false;
+		}
+		url.resize(len);
+		return true;
+	}
+
+	inline std::string normalized(std::string_view url)
+	{
+		std::string result;
+		result.reserve(url.size() + 1);
+		result.assign(url.data(), url.size());
+		normalize(result);
+		return result;
+	}
+}
+
+#endif // _URI_HELPER_HPP_INCLUDED_
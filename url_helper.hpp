@@ -1,112 +1,673 @@
-/*
-* Author: LowBoyTeam (https://github.com/LowBoyTeam)
-* License: Code Project Open License
-* Disclaimer: The software is provided "as-is". No claim of suitability, guarantee, or any warranty whatsoever is provided.
-* Copyright (c) 2016-2017.
-*/
-
-#ifndef _URLENCODER_HPP_INCLUDED_
-#define _URLENCODER_HPP_INCLUDED_
-
-#include <string>
-#include <vector>
-
-namespace url_helper
-{
-	int _htoi(char *s)
-	{
-		int value;
-		int c;
-
-		c = ((unsigned char *)s)[0];
-		if (isupper(c))
-			c = tolower(c);
-		value = (c >= '0' && c <= '9' ? c - '0' : c - 'a' + 10) * 16;
-
-		c = ((unsigned char *)s)[1];
-		if (isupper(c))
-			c = tolower(c);
-		value += c >= '0' && c <= '9' ? c - '0' : c - 'a' + 10;
-
-		return (value);
-	}
-
-	std::string url_decode(const std::string &str_source)
-	{
-		char const *in_str = str_source.c_str();
-		int in_str_len = strlen(in_str);
-		int out_str_len = 0;
-		std::string out_str;
-		char *str;
-
-		str = _strdup(in_str);
-		char *dest = str;
-		char *data = str;
-
-		while (in_str_len--) {
-			if (*data == '+') {
-				*dest = ' ';
-			}
-			else if (*data == '%' && in_str_len >= 2 && isxdigit((int) *(data + 1))
-				&& isxdigit((int) *(data + 2))) {
-				*dest = (char)_htoi(data + 1);
-				data += 2;
-				in_str_len -= 2;
-			}
-			else {
-				*dest = *data;
-			}
-			data++;
-			dest++;
-		}
-		*dest = '\0';
-		out_str_len = dest - str;
-		out_str = str;
-		free(str);
-		return out_str;
-	}
-
-	std::string url_encode(const std::string &str_source)
-	{
-		char const *in_str = str_source.c_str();
-		int in_str_len = strlen(in_str);
-		int out_str_len = 0;
-		std::string out_str;
-		register unsigned char c;
-		unsigned char *to, *start;
-		unsigned char const *from, *end;
-		unsigned char hexchars[] = "0123456789ABCDEF";
-
-		from = (unsigned char *)in_str;
-		end = (unsigned char *)in_str + in_str_len;
-		start = to = (unsigned char *)malloc(3 * in_str_len + 1);
-
-		while (from < end) {
-			c = *from++;
-
-			if (c == ' ') {
-				*to++ = '+';
-			}
-			else if ((c < '0' && c != '-' && c != '.') ||
-				(c < 'A' && c > '9') ||
-				(c > 'Z' && c < 'a' && c != '_') ||
-				(c > 'z')) {
-				to[0] = '%';
-				to[1] = hexchars[c >> 4];
-				to[2] = hexchars[c & 15];
-				to += 3;
-			}
-			else {
-				*to++ = c;
-			}
-		}
-		*to = 0;
-
-		out_str_len = to - start;
-		out_str = (char *)start;
-		free(start);
-		return out_str;
-	}
-}
-
+/*
+* Author: LowBoyTeam (https://github.com/LowBoyTeam)
+* License: Code Project Open License
+* Disclaimer: The software is provided "as-is". No claim of suitability, guarantee, or any warranty whatsoever is provided.
+* Copyright (c) 2016-2017.
+*/
+
+#ifndef _URLENCODER_HPP_INCLUDED_
+#define _URLENCODER_HPP_INCLUDED_
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <string.h>
+#include <ctype.h>
+#if defined(__has_include)
+#if __has_include(<memory_resource>)
+#include <memory_resource>
+#define URL_HELPER_HAS_PMR 1
+#endif
+#endif
+
+#include "cpu_helper.hpp"
+#include "instrument_helper.hpp"
+
+namespace url_helper
+{
+	inline int _htoi(char *s)
+	{
+		int value;
+		int c;
+
+		c = ((unsigned char *)s)[0];
+		if (isupper(c))
+			c = tolower(c);
+		value = (c >= '0' && c <= '9' ? c - '0' : c - 'a' + 10) * 16;
+
+		c = ((unsigned char *)s)[1];
+		if (isupper(c))
+			c = tolower(c);
+		value += c >= '0' && c <= '9' ? c - '0' : c - 'a' + 10;
+
+		return (value);
+	}
+
+	namespace detail
+	{
+		inline int hexval(unsigned char c)
+		{
+			if (c >= '0' && c <= '9')
+				return c - '0';
+			c |= 0x20;
+			if (c >= 'a' && c <= 'f')
+				return c - 'a' + 10;
+			return -1;
+		}
+
+		// Characters url_encode passes through unchanged: [0-9A-Za-z._-]
+		inline bool is_unreserved(unsigned char c)
+		{
+			return (c >= '0' && c <= '9') || ((c | 0x20) >= 'a' && (c | 0x20) <= 'z') || c == '-' || c == '.' || c == '_';
+		}
+
+		inline unsigned char* encode_byte(unsigned char* to, unsigned char c)
+		{
+			static const char hexchars[] = "0123456789ABCDEF";
+			if (c == ' ') {
+				*to++ = '+';
+			}
+			else {
+				to[0] = '%';
+				to[1] = hexchars[c >> 4];
+				to[2] = hexchars[c & 15];
+				to += 3;
+			}
+			return to;
+		}
+
+#ifdef CPU_HELPER_HAS_SSE2
+		// Bit i is set when byte i of v has to be escaped. Bytes >= 0x80 are negative
+		// as signed chars and therefore fall outside every range below.
+		inline unsigned sse2_escape_mask(__m128i v)
+		{
+			const __m128i lower = _mm_or_si128(v, _mm_set1_epi8(0x20));
+			const __m128i alpha = _mm_and_si128(_mm_cmpgt_epi8(lower, _mm_set1_epi8('a' - 1)), _mm_cmplt_epi8(lower, _mm_set1_epi8('z' + 1)));
+			const __m128i digit = _mm_and_si128(_mm_cmpgt_epi8(v, _mm_set1_epi8('0' - 1)), _mm_cmplt_epi8(v, _mm_set1_epi8('9' + 1)));
+			const __m128i punct = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('-')), _mm_cmpeq_epi8(v, _mm_set1_epi8('.'))), _mm_cmpeq_epi8(v, _mm_set1_epi8('_')));
+			return ~(unsigned)_mm_movemask_epi8(_mm_or_si128(_mm_or_si128(alpha, digit), punct)) & 0xFFFF;
+		}
+#endif
+	}
+
+	namespace detail
+	{
+		// Counts the bytes url_encode turns into %XX and the spaces it turns into '+'
+		inline void encode_stats_scalar(const char *src, size_t len, size_t &escaped, size_t &spaces)
+		{
+			const unsigned char *from = (const unsigned char *)src;
+			const unsigned char *end = from + len;
+			escaped = spaces = 0;
+			for (; from < end; ++from) {
+				if (*from == ' ')
+					++spaces;
+				else if (!is_unreserved(*from))
+					++escaped;
+			}
+		}
+
+		inline size_t encode_scalar(const char *src, size_t len, char *dst)
+		{
+			const unsigned char *from = (const unsigned char *)src;
+			const unsigned char *end = from + len;
+			unsigned char *to = (unsigned char *)dst;
+			while (from < end) {
+				unsigned char c = *from++;
+				if (is_unreserved(c))
+					*to++ = c;
+				else
+					to = encode_byte(to, c);
+			}
+			return to - (unsigned char *)dst;
+		}
+
+		// Decodes the '+', "%XX" or plain byte at data
+		inline void decode_one(const unsigned char *&data, const unsigned char *end, unsigned char *&dest)
+		{
+			if (*data == '+') {
+				*dest++ = ' ';
+				++data;
+			}
+			else if (*data == '%' && end - data > 2 && hexval(data[1]) >= 0 && hexval(data[2]) >= 0) {
+				*dest++ = (unsigned char)((hexval(data[1]) << 4) | hexval(data[2]));
+				data += 3;
+			}
+			else {
+				*dest++ = *data++;
+			}
+		}
+
+		inline size_t decode_scalar(const char *src, size_t len, char *dst)
+		{
+			const unsigned char *data = (const unsigned char *)src;
+			const unsigned char *end = data + len;
+			unsigned char *dest = (unsigned char *)dst;
+			while (data < end)
+				decode_one(data, end, dest);
+			return dest - (unsigned char *)dst;
+		}
+
+		// The SSE2 kernels handle 16-byte blocks and leave the remainder to the
+		// scalar versions above; without SSE2 in the build they are those versions
+		inline void encode_stats_sse2(const char *src, size_t len, size_t &escaped, size_t &spaces)
+		{
+			const char *from = src;
+			const char *end = src + len;
+			size_t e = 0, s = 0;
+#ifdef CPU_HELPER_HAS_SSE2
+			for (; end - from >= 16; from += 16) {
+				const __m128i v = _mm_loadu_si128((const __m128i *)from);
+				const unsigned space = (unsigned)_mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_set1_epi8(' ')));
+				const unsigned mask = sse2_escape_mask(v);
+				e += cpu_helper::popcount32(mask & ~space);
+				s += cpu_helper::popcount32(space);
+			}
+#endif
+			encode_stats_scalar(from, end - from, escaped, spaces);
+			escaped += e;
+			spaces += s;
+		}
+
+		inline size_t encode_sse2(const char *src, size_t len, char *dst)
+		{
+			const unsigned char *from = (const unsigned char *)src;
+			const unsigned char *end = from + len;
+			unsigned char *to = (unsigned char *)dst;
+
+#ifdef CPU_HELPER_HAS_SSE2
+			for (; end - from >= 16; from += 16) {
+				const __m128i v = _mm_loadu_si128((const __m128i *)from);
+				unsigned mask = sse2_escape_mask(v);
+				if (mask == 0) {
+					_mm_storeu_si128((__m128i *)to, v);
+					to += 16;
+					continue;
+				}
+				// Copy the clean runs between escaped bytes in bulk
+				unsigned i = 0;
+				do {
+					unsigned n = cpu_helper::ctz32(mask);
+					memcpy(to, from + i, n - i);
+					to = encode_byte(to + (n - i), from[n]);
+					i = n + 1;
+					mask &= mask - 1;
+				} while (mask);
+				memcpy(to, from + i, 16 - i);
+				to += 16 - i;
+			}
+#endif
+			to += encode_scalar((const char *)from, end - from, (char *)to);
+			return to - (unsigned char *)dst;
+		}
+
+		inline size_t decode_sse2(const char *src, size_t len, char *dst)
+		{
+			const unsigned char *data = (const unsigned char *)src;
+			const unsigned char *end = data + len;
+			unsigned char *dest = (unsigned char *)dst;
+
+#ifdef CPU_HELPER_HAS_SSE2
+			while (end - data >= 16) {
+				const __m128i v = _mm_loadu_si128((const __m128i *)data);
+				const unsigned mask = (unsigned)_mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('%')), _mm_cmpeq_epi8(v, _mm_set1_epi8('+'))));
+				if (mask == 0) {
+					// dest never runs ahead of data, so this is safe in place too
+					_mm_storeu_si128((__m128i *)dest, v);
+					dest += 16;
+					data += 16;
+					continue;
+				}
+				unsigned n = cpu_helper::ctz32(mask);
+				memmove(dest, data, n);
+				dest += n;
+				data += n;
+				decode_one(data, end, dest);
+			}
+#endif
+			dest += decode_scalar((const char *)data, end - data, (char *)dest);
+			return dest - (unsigned char *)dst;
+		}
+
+#ifdef CPU_HELPER_X86
+		// The AVX2 kernels handle 32-byte blocks and leave the remainder to the
+		// SSE2 versions above
+		CPU_HELPER_TARGET_AVX2 inline unsigned avx2_escape_mask(__m256i v)
+		{
+			const __m256i lower = _mm256_or_si256(v, _mm256_set1_epi8(0x20));
+			const __m256i alpha = _mm256_and_si256(_mm256_cmpgt_epi8(lower, _mm256_set1_epi8('a' - 1)), _mm256_cmpgt_epi8(_mm256_set1_epi8('z' + 1), lower));
+			const __m256i digit = _mm256_and_si256(_mm256_cmpgt_epi8(v, _mm256_set1_epi8('0' - 1)), _mm256_cmpgt_epi8(_mm256_set1_epi8('9' + 1), v));
+			const __m256i punct = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('-')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8('.'))), _mm256_cmpeq_epi8(v, _mm256_set1_epi8('_')));
+			return ~(unsigned)_mm256_movemask_epi8(_mm256_or_si256(_mm256_or_si256(alpha, digit), punct));
+		}
+
+		CPU_HELPER_TARGET_AVX2 inline void encode_stats_avx2(const char *src, size_t len, size_t &escaped, size_t &spaces)
+		{
+			const char *from = src;
+			const char *end = src + len;
+			size_t e = 0, s = 0;
+			for (; end - from >= 32; from += 32) {
+				const __m256i v = _mm256_loadu_si256((const __m256i *)from);
+				const unsigned space = (unsigned)_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(' ')));
+				e += _mm_popcnt_u32(avx2_escape_mask(v) & ~space);
+				s += _mm_popcnt_u32(space);
+			}
+			encode_stats_sse2(from, end - from, escaped, spaces);
+			escaped += e;
+			spaces += s;
+		}
+
+		CPU_HELPER_TARGET_AVX2 inline size_t encode_avx2(const char *src, size_t len, char *dst)
+		{
+			const unsigned char *from = (const unsigned char *)src;
+			const unsigned char *end = from + len;
+			unsigned char *to = (unsigned char *)dst;
+
+			for (; end - from >= 32; from += 32) {
+				const __m256i v = _mm256_loadu_si256((const __m256i *)from);
+				unsigned mask = avx2_escape_mask(v);
+				if (mask == 0) {
+					_mm256_storeu_si256((__m256i *)to, v);
+					to += 32;
+					continue;
+				}
+				unsigned i = 0;
+				do {
+					unsigned n = _tzcnt_u32(mask);
+					memcpy(to, from + i, n - i);
+					to = encode_byte(to + (n - i), from[n]);
+					i = n + 1;
+					mask = _blsr_u32(mask);
+				} while (mask);
+				memcpy(to, from + i, 32 - i);
+				to += 32 - i;
+			}
+			to += encode_sse2((const char *)from, end - from, (char *)to);
+			return to - (unsigned char *)dst;
+		}
+
+		CPU_HELPER_TARGET_AVX2 inline size_t decode_avx2(const char *src, size_t len, char *dst)
+		{
+			const char *data = src;
+			const char *end = src + len;
+			char *dest = dst;
+
+			while (end - data >= 32) {
+				const __m256i v = _mm256_loadu_si256((const __m256i *)data);
+				const unsigned mask = (unsigned)_mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('%')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8('+'))));
+				if (mask == 0) {
+					_mm256_storeu_si256((__m256i *)dest, v);
+					dest += 32;
+					data += 32;
+					continue;
+				}
+				unsigned n = _tzcnt_u32(mask);
+				memmove(dest, data, n);
+				dest += n;
+				data += n;
+
+				// Decode the one escape here; it may reach into the next block
+				if (*data == '+') {
+					*dest++ = ' ';
+					++data;
+				}
+				else if (end - data > 2 && hexval(data[1]) >= 0 && hexval(data[2]) >= 0) {
+					*dest++ = (char)((hexval(data[1]) << 4) | hexval(data[2]));
+					data += 3;
+				}
+				else {
+					*dest++ = *data++;
+				}
+			}
+			dest += decode_sse2(data, end - data, dest);
+			return dest - dst;
+		}
+#endif
+
+		typedef void encode_stats_fn(const char *, size_t, size_t &, size_t &);
+		typedef size_t code_fn(const char *, size_t, char *);
+
+		// Short inputs stay on the inline SSE2 path; the indirect call only pays
+		// off once there are a few 32-byte blocks to process
+		enum { kDispatchThreshold = 64 };
+
+		inline cpu_helper::dispatch_t<encode_stats_fn>& encode_stats_kernel()
+		{
+			static cpu_helper::dispatch_t<encode_stats_fn> kernel = {
+#ifdef CPU_HELPER_X86
+				{ cpu_helper::kAVX2 | cpu_helper::kPOPCNT, encode_stats_avx2 },
+#endif
+#ifdef CPU_HELPER_HAS_SSE2
+				{ cpu_helper::kSSE2, encode_stats_sse2 },
+#endif
+				{ 0, encode_stats_scalar } };
+			return kernel;
+		}
+
+		inline cpu_helper::dispatch_t<code_fn>& encode_kernel()
+		{
+			static cpu_helper::dispatch_t<code_fn> kernel = {
+#ifdef CPU_HELPER_X86
+				{ cpu_helper::kAVX2 | cpu_helper::kBMI1, encode_avx2 },
+#endif
+#ifdef CPU_HELPER_HAS_SSE2
+				{ cpu_helper::kSSE2, encode_sse2 },
+#endif
+				{ 0, encode_scalar } };
+			return kernel;
+		}
+
+		inline cpu_helper::dispatch_t<code_fn>& decode_kernel()
+		{
+			static cpu_helper::dispatch_t<code_fn> kernel = {
+#ifdef CPU_HELPER_X86
+				{ cpu_helper::kAVX2 | cpu_helper::kBMI1, decode_avx2 },
+#endif
+#ifdef CPU_HELPER_HAS_SSE2
+				{ cpu_helper::kSSE2, decode_sse2 },
+#endif
+				{ 0, decode_scalar } };
+			return kernel;
+		}
+
+		inline void encode_stats(const char *src, size_t len, size_t &escaped, size_t &spaces)
+		{
+			if (len < kDispatchThreshold)
+				encode_stats_sse2(src, len, escaped, spaces);
+			else
+				encode_stats_kernel()(src, len, escaped, spaces);
+		}
+	}
+
+	// Exact number of bytes url_encode produces for src[0, len)
+	inline size_t url_encode_length(const char *src, size_t len)
+	{
+		size_t escaped, spaces;
+		detail::encode_stats(src, len, escaped, spaces);
+		return len + 2 * escaped;
+	}
+
+	// Encodes src[0, len) into dst, which must hold url_encode_length(src, len)
+	// bytes. Embedded NULs are encoded like any other byte and no terminator is
+	// written. Returns the number of bytes written.
+	inline size_t url_encode(const char *src, size_t len, char *dst)
+	{
+		CPP_UTILS_PROBE(kUrlEncode, len);
+		if (len < detail::kDispatchThreshold)
+			return detail::encode_sse2(src, len, dst);
+		return detail::encode_kernel()(src, len, dst);
+	}
+
+	// Decodes src[0, len) into dst, which must hold len bytes; dst may be src to
+	// decode in place. Returns the number of bytes written.
+	inline size_t url_decode(const char *src, size_t len, char *dst)
+	{
+		CPP_UTILS_PROBE(kUrlDecode, len);
+		if (len < detail::kDispatchThreshold)
+			return detail::decode_sse2(src, len, dst);
+		return detail::decode_kernel()(src, len, dst);
+	}
+
+	// Appends the decoded form of str_source to out_str
+	inline std::string& url_decode(const std::string &str_source, std::string &out_str)
+	{
+		size_t pos = out_str.size();
+		if (out_str.capacity() < pos + str_source.size())
+			CPP_UTILS_COUNT_ALLOC(kUrlDecode, 1);
+		out_str.append(str_source);
+		out_str.resize(pos + url_decode(&out_str[0] + pos, str_source.size(), &out_str[0] + pos));
+		return out_str;
+	}
+
+	// Appends the encoded form of str_source to out_str, growing it exactly once
+	inline std::string& url_encode(const std::string &str_source, std::string &out_str)
+	{
+		size_t escaped, spaces;
+		detail::encode_stats(str_source.data(), str_source.size(), escaped, spaces);
+		if (escaped == 0 && spaces == 0) {
+			CPP_UTILS_PROBE(kUrlEncode, str_source.size());
+			out_str.append(str_source);
+		}
+		else {
+			size_t pos = out_str.size();
+			if (out_str.capacity() < pos + str_source.size() + 2 * escaped)
+				CPP_UTILS_COUNT_ALLOC(kUrlEncode, 1);
+			out_str.resize(pos + str_source.size() + 2 * escaped);
+			url_encode(str_source.data(), str_source.size(), &out_str[0] + pos);
+		}
+		return out_str;
+	}
+
+	inline std::string url_decode(const std::string &str_source)
+	{
+		std::string out_str;
+		return url_decode(str_source, out_str);
+	}
+
+	inline std::string url_encode(const std::string &str_source)
+	{
+		std::string out_str;
+		return url_encode(str_source, out_str);
+	}
+
+	////////////////////////////////////////////////////////
+	// Component-specific encoding
+	//
+	//  url_encode above follows PHP urlencode, which is only right for form
+	//  bodies. The modes below select the set of bytes left unescaped for each
+	//  URL component. Every mode carries a 256-entry table built at compile
+	//  time, so the per-byte test is a single load, and every function below is
+	//  instantiated separately per mode.
+	//
+	//  Usage:
+	//    std::string path = url_helper::url_encode<url_helper::path_mode>(raw_path);
+	//    if (url_helper::needs_encoding<url_helper::query_mode>(value.data(), value.size())) ...
+
+	namespace detail
+	{
+		struct byte_class_t
+		{
+			unsigned char pass[256];	// 1 if the byte is copied unchanged
+			unsigned char width[256];	// encoded size of the byte: 1 or 3
+		};
+
+		constexpr byte_class_t make_byte_class(const char *extra, bool space_as_plus)
+		{
+			byte_class_t t = {};
+			for (int c = 0; c < 256; ++c) {
+				bool pass = (c >= '0' && c <= '9') || (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z');
+				for (const char *p = extra; *p; ++p)
+					pass = pass || (unsigned char)*p == c;
+				t.pass[c] = pass ? 1 : 0;
+				t.width[c] = (pass || (space_as_plus && c == ' ')) ? 1 : 3;
+			}
+			return t;
+		}
+	}
+
+	// application/x-www-form-urlencoded, same rules as url_encode: space becomes '+'
+	struct form_mode
+	{
+		static constexpr bool space_as_plus = true;
+		static constexpr detail::byte_class_t table = detail::make_byte_class("-._", true);
+	};
+
+	// RFC 3986 unreserved characters only (PHP rawurlencode)
+	struct raw_mode
+	{
+		static constexpr bool space_as_plus = false;
+		static constexpr detail::byte_class_t table = detail::make_byte_class("-._~", false);
+	};
+
+	// A path: pchar plus '/', so segment separators survive
+	struct path_mode
+	{
+		static constexpr bool space_as_plus = false;
+		static constexpr detail::byte_class_t table = detail::make_byte_class("-._~!$&'()*+,;=:@/", false);
+	};
+
+	// A single query key or value: '&', '=', '+', ';' and '#' are escaped so the
+	// result cannot change how the query string is split or decoded
+	struct query_mode
+	{
+		static constexpr bool space_as_plus = false;
+		static constexpr detail::byte_class_t table = detail::make_byte_class("-._~!$'()*,:@/?", false);
+	};
+
+	// A fragment: pchar plus '/' and '?'
+	struct fragment_mode
+	{
+		static constexpr bool space_as_plus = false;
+		static constexpr detail::byte_class_t table = detail::make_byte_class("-._~!$&'()*+,;=:@/?", false);
+	};
+
+	// True if encoding src[0, len) with Mode would change it
+	template <class Mode>
+	inline bool needs_encoding(const char *src, size_t len)
+	{
+		const unsigned char *from = (const unsigned char *)src;
+		const unsigned char *end = from + len;
+
+		// Accumulate without branching, checking for an early exit once per block
+		while (from < end) {
+			const unsigned char *block_end = (end - from > 64) ? from + 64 : end;
+			unsigned char pass = 1;
+			for (; from < block_end; ++from)
+				pass &= Mode::table.pass[*from];
+			if (!pass)
+				return true;
+		}
+		return false;
+	}
+
+	template <class Mode>
+	inline size_t url_encode_length(const char *src, size_t len)
+	{
+		const unsigned char *from = (const unsigned char *)src;
+		size_t total = 0;
+		for (size_t i = 0; i < len; ++i)
+			total += Mode::table.width[from[i]];
+		return total;
+	}
+
+	// Encodes src[0, len) into dst, which must hold url_encode_length<Mode>(src, len) bytes
+	template <class Mode>
+	inline size_t url_encode(const char *src, size_t len, char *dst)
+	{
+		static const char hexchars[] = "0123456789ABCDEF";
+		const unsigned char *from = (const unsigned char *)src;
+		const unsigned char *end = from + len;
+		unsigned char *to = (unsigned char *)dst;
+
+		while (from < end) {
+			const unsigned char *run = from;
+			while (from < end && Mode::table.pass[*from])
+				++from;
+			memcpy(to, run, from - run);
+			to += from - run;
+			if (from == end)
+				break;
+
+			unsigned char c = *from++;
+			if (Mode::space_as_plus && c == ' ') {
+				*to++ = '+';
+			}
+			else {
+				to[0] = '%';
+				to[1] = hexchars[c >> 4];
+				to[2] = hexchars[c & 15];
+				to += 3;
+			}
+		}
+		return to - (unsigned char *)dst;
+	}
+
+	// Form encoding has the vectorised kernel
+	template <>
+	inline bool needs_encoding<form_mode>(const char *src, size_t len)
+	{
+		size_t escaped, spaces;
+		detail::encode_stats(src, len, escaped, spaces);
+		return escaped != 0 || spaces != 0;
+	}
+
+	template <>
+	inline size_t url_encode_length<form_mode>(const char *src, size_t len)
+	{
+		return url_encode_length(src, len);
+	}
+
+	template <>
+	inline size_t url_encode<form_mode>(const char *src, size_t len, char *dst)
+	{
+		return url_encode(src, len, dst);
+	}
+
+	// Appends the Mode encoding of str_source to out_str
+	template <class Mode>
+	inline std::string& url_encode(const std::string &str_source, std::string &out_str)
+	{
+		if (!needs_encoding<Mode>(str_source.data(), str_source.size())) {
+			out_str.append(str_source);
+		}
+		else {
+			size_t pos = out_str.size();
+			out_str.resize(pos + url_encode_length<Mode>(str_source.data(), str_source.size()));
+			url_encode<Mode>(str_source.data(), str_source.size(), &out_str[0] + pos);
+		}
+		return out_str;
+	}
+
+	// Takes str_source by value: a string that needs no escaping is moved
+	// straight back to the caller
+	template <class Mode>
+	inline std::string url_encode(std::string str_source)
+	{
+		if (!needs_encoding<Mode>(str_source.data(), str_source.size()))
+			return str_source;
+		std::string out_str;
+		return url_encode<Mode>(str_source, out_str);
+	}
+
+	// Returns str_source itself when it needs no escaping; otherwise encodes it
+	// into storage and returns that. Nothing is copied in the common case.
+	template <class Mode>
+	inline std::string_view encode_if_needed(std::string_view str_source, std::string &storage)
+	{
+		if (!needs_encoding<Mode>(str_source.data(), str_source.size()))
+			return str_source;
+		storage.resize(url_encode_length<Mode>(str_source.data(), str_source.size()));
+		url_encode<Mode>(str_source.data(), str_source.size(), &storage[0]);
+		return storage;
+	}
+#ifdef URL_HELPER_HAS_PMR
+	// Allocator-aware versions: the result is allocated from resource, e.g. a
+	// per-request std::pmr::monotonic_buffer_resource
+	namespace pmr
+	{
+		template <class Mode = form_mode>
+		inline std::pmr::string url_encode(std::string_view str_source, std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+		{
+			std::pmr::string out_str(resource);
+			if (!needs_encoding<Mode>(str_source.data(), str_source.size())) {
+				out_str.assign(str_source.data(), str_source.size());
+			}
+			else {
+				CPP_UTILS_COUNT_ALLOC(kUrlEncode, 1);
+				out_str.resize(url_encode_length<Mode>(str_source.data(), str_source.size()));
+				url_helper::url_encode<Mode>(str_source.data(), str_source.size(), &out_str[0]);
+			}
+			return out_str;
+		}
+
+		inline std::pmr::string url_decode(std::string_view str_source, std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+		{
+			CPP_UTILS_COUNT_ALLOC(kUrlDecode, 1);
+			std::pmr::string out_str(str_source, resource);
+			out_str.resize(url_helper::url_decode(out_str.data(), out_str.size(), &out_str[0]));
+			return out_str;
+		}
+	}
+#endif
+}
+
 #endif // _URLENCODER_HPP_INCLUDED_
\ No newline at end of file